@@ -7,11 +7,16 @@
 
 namespace boo {
 
-const DeviceSignature BOO_DEVICE_SIGS[] = {DEVICE_SIG(DolphinSmashAdapter, 0x57e, 0x337, DeviceType::USB),
-                                           DEVICE_SIG(DualshockPad, 0x54c, 0x268, DeviceType::HID),
-                                           DEVICE_SIG(GenericPad, 0, 0, DeviceType::HID),
-                                           DEVICE_SIG(NintendoPowerA, 0x20D6, 0xA711, DeviceType::USB),
-                                           DEVICE_SIG(XInputPad, 0, 0, DeviceType::XInput),
-                                           DEVICE_SIG_SENTINEL()};
+constexpr DeviceSignature BOO_DEVICE_SIGS[] = {DEVICE_SIG(DolphinSmashAdapter, 0x57e, 0x337, DeviceType::USB),
+                                               DEVICE_SIG(DualshockPad, 0x54c, 0x268, DeviceType::HID),
+                                               DEVICE_SIG(GenericPad, 0, 0, DeviceType::HID),
+                                               DEVICE_SIG(NintendoPowerA, 0x20D6, 0xA711, DeviceType::USB),
+                                               DEVICE_SIG(XInputPad, 0, 0, DeviceType::XInput),
+                                               DEVICE_SIG_SENTINEL()};
+
+static constexpr auto BOO_DEVICE_SIG_TABLE = MakeDeviceSignatureTable(BOO_DEVICE_SIGS);
+constexpr DeviceSignatureIndex BOO_DEVICE_SIG_INDEX(BOO_DEVICE_SIGS, BOO_DEVICE_SIG_TABLE.m_slots.data(),
+                                                    BOO_DEVICE_SIG_TABLE.m_seed,
+                                                    uint32_t(BOO_DEVICE_SIG_TABLE.m_slots.size() - 1));
 
 }
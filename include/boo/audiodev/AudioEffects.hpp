@@ -0,0 +1,242 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "boo/audiodev/IAudioSubmix.hpp"
+#include "boo/audiodev/IAudioVoice.hpp"
+
+namespace boo {
+
+/** Effect parameter written from any thread and smoothed on the mixing thread */
+class AudioEffectParam {
+  std::atomic<float> m_target;
+  float m_cur;
+
+public:
+  explicit AudioEffectParam(float value) : m_target(value), m_cur(value) {}
+
+  void set(float value) { m_target.store(value, std::memory_order_relaxed); }
+  float get() const { return m_target.load(std::memory_order_relaxed); }
+
+  /* Mixing thread: one-pole step toward the target; returns true if the value moved */
+  bool _smooth(float coef);
+  void _snap() { m_cur = get(); }
+  float _value() const { return m_cur; }
+};
+
+/** Base of the built-in submix effects; install by passing the effect as the cb of
+ *  IAudioVoiceEngine::allocateNewSubmix(bool mainOut, IAudioSubmixCallback* cb, int busId).
+ *  Each applyEffect() call is deinterleaved into ControlFrames-sized float blocks whose
+ *  channel lanes are padded to a multiple of four, so every effect runs a single SIMD
+ *  float kernel for all submix formats and channel sets. Parameters are smoothed once
+ *  per block. All buffers are sized at construction; the mixing thread never allocates.
+ *
+ *  A bypassed effect reports canApplyEffect() == false and is not called at all;
+ *  its history is cleared when it is re-enabled. */
+class AudioEffect : public IAudioSubmixCallback {
+protected:
+  static constexpr size_t ControlFrames = 32;
+  static constexpr unsigned MaxChannels = 8;
+
+  unsigned m_channels; /* Channels processed, from the AudioChannelSet */
+  unsigned m_stride;   /* Floats per frame in the block (m_channels rounded up to 4) */
+  double m_maxSampleRate;
+  double m_sampleRate = 0.0;
+  float m_smoothCoef = 1.f;
+
+  AudioEffect(AudioChannelSet set, double maxSampleRate);
+
+  /** Mixing thread: clear all history (delay lines, filter state) */
+  virtual void _reset() = 0;
+
+  /** Mixing thread: derive rate-dependent constants; must not allocate */
+  virtual void _setSampleRate(double sampleRate) = 0;
+
+  /** Mixing thread: process frames (<= ControlFrames) of the padded block in place */
+  virtual void _process(float* block, size_t frames) = 0;
+
+private:
+  std::atomic_bool m_bypass{false};
+  std::atomic_bool m_optional{false};
+  std::atomic_bool m_resetPending{true};
+  std::atomic<float> m_smoothTime{0.02f};
+  alignas(16) float m_block[ControlFrames * MaxChannels];
+
+  void _updateSampleRate(double sampleRate);
+  void _run(float* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate);
+
+public:
+  /** Skip the effect entirely; the submix passes audio through untouched */
+  void setBypass(bool bypass);
+  bool isBypassed() const { return m_bypass.load(std::memory_order_relaxed); }
+
+  /** Let the engine drop this effect at AudioQualityLevel::BypassEffects */
+  void setOptional(bool optional) { m_optional.store(optional, std::memory_order_relaxed); }
+
+  /** Time constant of parameter smoothing in seconds (default 20ms) */
+  void setSmoothingTime(float seconds) { m_smoothTime.store(seconds, std::memory_order_relaxed); }
+
+  bool canApplyEffect() const override { return !m_bypass.load(std::memory_order_relaxed); }
+  bool isEffectOptional() const override { return m_optional.load(std::memory_order_relaxed); }
+  /* Submixes only call the float overload; the deprecated integer ones keep their empty defaults */
+  void applyEffect(float* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const override;
+  void resetOutputSampleRate(double sampleRate) override;
+};
+
+/** RBJ-cookbook biquad applied to every channel */
+class AudioEffectBiquad : public AudioEffect {
+public:
+  enum class Type { LowPass, HighPass, BandPass, Notch, Peaking, LowShelf, HighShelf };
+
+private:
+  std::atomic<Type> m_type;
+  Type m_curType;
+  AudioEffectParam m_frequency;
+  AudioEffectParam m_q;
+  AudioEffectParam m_gainDb;
+  bool m_dirty = true;
+  float m_b0 = 1.f, m_b1 = 0.f, m_b2 = 0.f, m_a1 = 0.f, m_a2 = 0.f;
+  alignas(16) float m_z1[MaxChannels] = {};
+  alignas(16) float m_z2[MaxChannels] = {};
+
+  void _computeCoefs();
+
+protected:
+  void _reset() override;
+  void _setSampleRate(double sampleRate) override;
+  void _process(float* block, size_t frames) override;
+
+public:
+  AudioEffectBiquad(AudioChannelSet set, Type type, float frequency, float q = 0.7071f, float gainDb = 0.f,
+                    double maxSampleRate = 96000.0);
+
+  void setType(Type type) { m_type.store(type, std::memory_order_relaxed); }
+  void setFrequency(float hz) { m_frequency.set(hz); }
+  void setQ(float q) { m_q.set(q); }
+  /** Only used by Peaking and the shelves */
+  void setGain(float dB) { m_gainDb.set(dB); }
+};
+
+/** Feedback delay with fractional, smoothly modulated delay time */
+class AudioEffectDelay : public AudioEffect {
+  std::vector<float> m_buffer;
+  size_t m_capacity;
+  size_t m_write = 0;
+  AudioEffectParam m_time;
+  AudioEffectParam m_feedback;
+  AudioEffectParam m_mix;
+  float m_curDelay = 1.f;
+
+protected:
+  void _reset() override;
+  void _setSampleRate(double sampleRate) override;
+  void _process(float* block, size_t frames) override;
+
+public:
+  AudioEffectDelay(AudioChannelSet set, float maxSeconds, float seconds, float feedback, float mix,
+                   double maxSampleRate = 96000.0);
+
+  /** Clamped to the maximum given at construction */
+  void setTime(float seconds) { m_time.set(seconds); }
+  void setFeedback(float feedback) { m_feedback.set(feedback); }
+  void setMix(float mix) { m_mix.set(mix); }
+};
+
+/** Modulated-delay chorus; each channel's LFO is a quarter cycle behind the previous one */
+class AudioEffectChorus : public AudioEffect {
+  std::vector<float> m_buffer;
+  size_t m_capacity;
+  size_t m_write = 0;
+  AudioEffectParam m_delay;
+  AudioEffectParam m_depth;
+  AudioEffectParam m_rate;
+  AudioEffectParam m_mix;
+  double m_lfoPhase = 0.0;
+  float m_curDelay[MaxChannels] = {};
+
+protected:
+  void _reset() override;
+  void _setSampleRate(double sampleRate) override;
+  void _process(float* block, size_t frames) override;
+
+public:
+  static constexpr float MaxDelaySeconds = 0.05f;
+
+  AudioEffectChorus(AudioChannelSet set, float delaySeconds = 0.015f, float depthSeconds = 0.004f,
+                    float rateHz = 0.8f, float mix = 0.5f, double maxSampleRate = 96000.0);
+
+  /** delay + depth is clamped to MaxDelaySeconds */
+  void setDelay(float seconds) { m_delay.set(seconds); }
+  void setDepth(float seconds) { m_depth.set(seconds); }
+  void setRate(float hz) { m_rate.set(hz); }
+  void setMix(float mix) { m_mix.set(mix); }
+};
+
+/** Per-channel four-line feedback delay network reverb with high-frequency damping */
+class AudioEffectReverb : public AudioEffect {
+  static constexpr unsigned Lines = 4;
+
+  std::vector<float> m_buffer;
+  size_t m_lineOffset[MaxChannels][Lines];
+  size_t m_lineCapacity[MaxChannels][Lines];
+  size_t m_lineLength[MaxChannels][Lines];
+  size_t m_linePos[MaxChannels][Lines] = {};
+  alignas(16) float m_damp[MaxChannels][Lines] = {};
+  alignas(16) float m_lineGain[MaxChannels][Lines] = {};
+  AudioEffectParam m_decay;
+  AudioEffectParam m_damping;
+  AudioEffectParam m_mix;
+  bool m_dirty = true;
+
+  void _computeGains();
+
+protected:
+  void _reset() override;
+  void _setSampleRate(double sampleRate) override;
+  void _process(float* block, size_t frames) override;
+
+public:
+  AudioEffectReverb(AudioChannelSet set, float decaySeconds = 1.5f, float damping = 0.5f, float mix = 0.3f,
+                    double maxSampleRate = 96000.0);
+
+  /** RT60 in seconds */
+  void setDecay(float seconds) { m_decay.set(seconds); }
+  /** 0 (bright) to 1 (dark) */
+  void setDamping(float damping) { m_damping.set(damping); }
+  void setMix(float mix) { m_mix.set(mix); }
+};
+
+/** Peak compressor; all channels share one detector so the image does not shift */
+class AudioEffectCompressor : public AudioEffect {
+  AudioEffectParam m_threshold;
+  AudioEffectParam m_ratio;
+  AudioEffectParam m_attack;
+  AudioEffectParam m_release;
+  AudioEffectParam m_makeup;
+  float m_env = 0.f;
+  float m_gain = 1.f;
+  std::atomic<float> m_gainReduction{0.f};
+
+protected:
+  void _reset() override;
+  void _setSampleRate(double sampleRate) override;
+  void _process(float* block, size_t frames) override;
+
+public:
+  AudioEffectCompressor(AudioChannelSet set, float thresholdDb = -12.f, float ratio = 4.f, float attackSeconds = 0.005f,
+                        float releaseSeconds = 0.1f, float makeupDb = 0.f, double maxSampleRate = 96000.0);
+
+  void setThreshold(float dB) { m_threshold.set(dB); }
+  void setRatio(float ratio) { m_ratio.set(ratio); }
+  void setAttack(float seconds) { m_attack.set(seconds); }
+  void setRelease(float seconds) { m_release.set(seconds); }
+  void setMakeup(float dB) { m_makeup.set(dB); }
+
+  /** Gain reduction of the most recent block in dB, for metering */
+  float getGainReduction() const { return m_gainReduction.load(std::memory_order_relaxed); }
+};
+
+} // namespace boo
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "boo/BooObject.hpp"
+#include "boo/audiodev/IAudioSubmix.hpp"
+#include "boo/audiodev/IAudioVoice.hpp"
+#include "boo/audiodev/IAudioVoiceEngine.hpp"
+
+namespace boo {
+
+/** Carries a submix of one engine into a voice of another engine whose output device runs
+ *  on its own clock (e.g. the main mix duplicated onto a headset or a recording bus).
+ *  The source is captured with a submix tap; the destination voice is a dynamic-pitch
+ *  stereo voice whose ratio is trimmed continuously to hold the tap's fill level at the
+ *  requested latency, absorbing drift between the two device clocks.
+ *
+ *  Only the first two source channels are carried (mono sources are duplicated). Route the
+ *  destination voice with voice()->setStereoChannelLevels() like any other voice. */
+class AudioEngineBridge : public IAudioVoiceCallback {
+  ObjToken<IAudioSubmixTap> m_tap;
+  ObjToken<IAudioVoice> m_voice;
+  size_t m_targetFrames;
+
+  /* Destination mixing thread state */
+  size_t m_blockOffset = 0;
+  size_t m_blockFrames = 0;
+  bool m_primed = false;
+  double m_fillError = 0.0;
+  double m_driftRatio = 1.0;
+  uint64_t m_underruns = 0;
+
+  size_t _queuedFrames();
+
+public:
+  /** sourceTap is typically from IAudioVoiceEngine::allocateMainMixTap() or IAudioSubmix::allocateTap()
+   *  on the source engine and should buffer comfortably more than latencyMs */
+  AudioEngineBridge(ObjToken<IAudioSubmixTap> sourceTap, double sourceRate, IAudioVoiceEngine& dest,
+                    double latencyMs = 40.0, AudioResamplerType resampler = AudioResamplerType::Hermite);
+  ~AudioEngineBridge();
+  AudioEngineBridge(const AudioEngineBridge&) = delete;
+  AudioEngineBridge& operator=(const AudioEngineBridge&) = delete;
+
+  /** Destination voice; empty if the destination engine refused the allocation */
+  IAudioVoice* voice() const { return m_voice.get(); }
+
+  /** Current correction applied to the nominal rate ratio (1.0 means the clocks agree) */
+  double getDriftRatio() const { return m_driftRatio; }
+
+  /** Number of times the destination ran dry and had to re-buffer */
+  uint64_t getUnderrunCount() const { return m_underruns; }
+
+  void preSupplyAudio(IAudioVoice& voice, double dt) override;
+  size_t supplyAudio(IAudioVoice& voice, size_t frames, int16_t* data) override;
+};
+
+} // namespace boo
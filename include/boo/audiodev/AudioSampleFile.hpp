@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+#include "boo/System.hpp"
+#include "boo/audiodev/IAudioVoice.hpp"
+
+namespace boo {
+
+/** Read-only memory mapping of a sample file, exposing its frames in place for
+ *  IAudioVoiceEngine::allocateNewSampleVoice(). Supports RIFF WAVE with 16-bit PCM
+ *  or IMA ADPCM (mono/stereo), where the first loop of a 'smpl' chunk is used for
+ *  loop points when present, and mono Nintendo DSP-ADPCM files with their standard
+ *  96-byte header. The mapping must outlive every voice playing from it. */
+class AudioSampleFile {
+  void* m_view = nullptr;
+  size_t m_viewSize = 0;
+#if _WIN32
+  void* m_mapping = nullptr;
+#endif
+  AudioSampleData m_sample;
+
+  bool _parse();
+  bool _parseWAVE();
+  bool _parseDSP();
+
+public:
+  AudioSampleFile() = default;
+  explicit AudioSampleFile(const SystemChar* path) { open(path); }
+  ~AudioSampleFile() { close(); }
+  AudioSampleFile(const AudioSampleFile&) = delete;
+  AudioSampleFile& operator=(const AudioSampleFile&) = delete;
+  AudioSampleFile(AudioSampleFile&& other) noexcept { *this = std::move(other); }
+  AudioSampleFile& operator=(AudioSampleFile&& other) noexcept;
+
+  bool open(const SystemChar* path);
+  void close();
+  bool isOpen() const { return m_sample.m_data != nullptr; }
+  const AudioSampleData& sampleData() const { return m_sample; }
+};
+
+} // namespace boo
@@ -13,6 +13,32 @@ struct IAudioSubmixCallback;
 
 enum class SubmixFormat { Int16, Int32, Float };
 
+/** One mixing interval of submix output captured by a tap (interleaved float samples) */
+struct AudioTapBlock {
+  uint64_t m_framePos = 0;    /**< Submix frame position at the start of this block */
+  uint64_t m_timestampNs = 0; /**< steady_clock time (nanoseconds) when the block was mixed */
+  size_t m_frames = 0;
+  unsigned m_channelCount = 0;
+  const float* m_samples = nullptr;
+};
+
+/** Loopback capture of a submix's post-effect output. The mixing thread copies each
+ *  interval into a preallocated wait-free ring; exactly one consumer thread drains it.
+ *  When the ring is full, intervals are dropped and counted rather than blocking the mix. */
+struct IAudioSubmixTap : IObj {
+  /** Consumer: oldest unread block, or nullptr if none; stays valid until popBlock() */
+  virtual const AudioTapBlock* peekBlock() = 0;
+
+  /** Consumer: release the block returned by peekBlock() back to the mixer */
+  virtual void popBlock() = 0;
+
+  /** Consumer: number of blocks currently waiting to be read */
+  virtual size_t getQueuedBlockCount() const = 0;
+
+  /** Count of intervals dropped because the ring was full (or larger than its blocks) */
+  virtual uint64_t getOverrunCount() const = 0;
+};
+
 struct IAudioSubmix : IObj {
   /** Reset channel-levels to silence; unbind all submixes */
   virtual void resetSendLevels() = 0;
@@ -25,17 +51,29 @@ struct IAudioSubmix : IObj {
 
   /** Gets fixed sample format of submix this way */
   virtual SubmixFormat getSampleFormat() const = 0;
+
+  /** Capture this submix's output for consumption on another thread.
+   *  blockCount 5ms intervals are buffered (rounded up to a power of two) */
+  virtual ObjToken<IAudioSubmixTap> allocateTap(size_t blockCount = 64) = 0;
 };
 
 struct IAudioSubmixCallback {
   /** Client-provided claim to implement / is ready to call applyEffect() */
   virtual bool canApplyEffect() const = 0;
 
-  /** Client-provided effect solution for interleaved, master sample-rate audio */
-  virtual void applyEffect(int16_t* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const = 0;
-  virtual void applyEffect(int32_t* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const = 0;
+  /** Optional effects are skipped while the engine is at AudioQualityLevel::BypassEffects */
+  virtual bool isEffectOptional() const { return false; }
+
+  /** Client-provided effect solution for interleaved, master sample-rate audio.
+   *  Submixes always mix on the float bus, so this is the only overload called */
   virtual void applyEffect(float* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const = 0;
 
+  /** Never called since submixes mix in float; implement the float overload instead */
+  [[deprecated("only the float applyEffect() is called")]] virtual void
+  applyEffect(int16_t* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const {}
+  [[deprecated("only the float applyEffect() is called")]] virtual void
+  applyEffect(int32_t* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const {}
+
   /** Notify of output sample rate changes (for instance, changing the default audio device on Windows) */
   virtual void resetOutputSampleRate(double sampleRate) = 0;
 };
@@ -44,6 +44,52 @@ static inline unsigned ChannelCount(AudioChannelSet layout) {
   return 0;
 }
 
+/** Sample-rate conversion used by a voice; the interpolating types keep pitch changes cheap */
+enum class AudioResamplerType {
+  SoXR,    /**< High-quality soxr (default) */
+  Linear,  /**< 2-point linear interpolation */
+  Hermite, /**< 4-point, 3rd-order Hermite interpolation */
+  Sinc     /**< 8-tap windowed sinc interpolated from a 32-phase table */
+};
+
+/** Encoding of AudioSampleData frames */
+enum class AudioSampleFormat {
+  PCM16,   /**< Interleaved little-endian int16 frames */
+  IMAADPCM, /**< Microsoft IMA ADPCM blocks (WAVE format 0x11) of m_blockAlign bytes */
+  DSPADPCM  /**< Nintendo DSP-ADPCM; one stream of 8-byte/14-sample frames per channel */
+};
+
+/** Sample data played in place by a sample voice (see IAudioVoiceEngine::allocateNewSampleVoice()).
+ *  The referenced data must remain valid and unmodified while any voice plays it. */
+struct AudioSampleData {
+  AudioSampleFormat m_format = AudioSampleFormat::PCM16;
+  const void* m_data = nullptr;
+  size_t m_dataSize = 0; /**< Bytes; bounds decoding of compressed formats */
+  size_t m_frameCount = 0;
+  unsigned m_channelCount = 1; /**< 1 (mono) or 2 (stereo) */
+  double m_sampleRate = 32000.0;
+  size_t m_loopStart = 0;
+  size_t m_loopEnd = 0; /**< One past the last looped frame; looping is disabled unless > m_loopStart */
+
+  /** IMAADPCM: bytes per block (all channels) */
+  unsigned m_blockAlign = 0;
+
+  /** DSPADPCM: byte offset between each channel's frame stream */
+  size_t m_channelStride = 0;
+
+  /** DSPADPCM: per-channel decoder parameters as found in the standard DSP header */
+  struct DSPChannel {
+    int16_t m_coefs[8][2] = {};
+    int16_t m_hist1 = 0;
+    int16_t m_hist2 = 0;
+    int16_t m_loopHist1 = 0;
+    int16_t m_loopHist2 = 0;
+  };
+  std::array<DSPChannel, 2> m_dsp = {};
+
+  bool isLooped() const { return m_loopEnd > m_loopStart; }
+};
+
 struct IAudioVoice : IObj {
   /** Set sample rate into voice (may result in audio discontinuities) */
   virtual void resetSampleRate(double sampleRate) = 0;
@@ -60,6 +106,9 @@ struct IAudioVoice : IObj {
   /** Called by client to dynamically adjust the pitch of voices with dynamic pitch enabled */
   virtual void setPitchRatio(double ratio, bool slew) = 0;
 
+  /** Importance when the engine is overloaded (default 0); see AudioWatchdogConfig::m_virtualPriority */
+  virtual void setPriority(int priority) = 0;
+
   /** Instructs platform to begin consuming sample data; invoking callback as needed */
   virtual void start() = 0;
 
@@ -77,16 +126,19 @@ struct IAudioVoiceCallback {
   virtual size_t supplyAudio(IAudioVoice& voice, size_t frames, int16_t* data) = 0;
 
   /** after resampling, boo calls this for each submix that this voice targets;
-   *  client performs volume processing and bus-routing this way */
-  virtual void routeAudio(size_t frames, size_t channels, double dt, int busId, int16_t* in, int16_t* out) {
-    memmove(out, in, frames * channels * 2);
-  }
-
-  virtual void routeAudio(size_t frames, size_t channels, double dt, int busId, int32_t* in, int32_t* out) {
+   *  client performs volume processing and bus-routing this way.
+   *  Voices always mix on the float bus, so this is the only overload called */
+  virtual void routeAudio(size_t frames, size_t channels, double dt, int busId, float* in, float* out) {
     memmove(out, in, frames * channels * 4);
   }
 
-  virtual void routeAudio(size_t frames, size_t channels, double dt, int busId, float* in, float* out) {
+  /** Never called since voices mix in float; override the float overload instead */
+  [[deprecated("only the float routeAudio() is called")]] virtual void
+  routeAudio(size_t frames, size_t channels, double dt, int busId, int16_t* in, int16_t* out) {
+    memmove(out, in, frames * channels * 2);
+  }
+  [[deprecated("only the float routeAudio() is called")]] virtual void
+  routeAudio(size_t frames, size_t channels, double dt, int busId, int32_t* in, int32_t* out) {
     memmove(out, in, frames * channels * 4);
   }
 };
@@ -10,10 +10,28 @@
 #include "boo/audiodev/IAudioSubmix.hpp"
 #include "boo/audiodev/IAudioVoice.hpp"
 #include "boo/audiodev/IMIDIPort.hpp"
+#include "boo/audiodev/MIDIEventQueue.hpp"
 
 namespace boo {
 struct IAudioVoiceEngine;
 
+/** Progressive steps the mixer takes when it risks missing its output deadline */
+enum class AudioQualityLevel {
+  Full,
+  ReducedResampling, /**< Resampling voices switch to low-quality filters */
+  VirtualVoices,     /**< Also, voices below AudioWatchdogConfig::m_virtualPriority advance without mixing */
+  BypassEffects      /**< Also, submix effects reporting IAudioSubmixCallback::isEffectOptional() are skipped */
+};
+
+/** Tuning for the engine's deadline watchdog; load is mix time divided by the duration of audio mixed */
+struct AudioWatchdogConfig {
+  bool m_enabled = true;
+  double m_degradeLoad = 0.75; /**< Smoothed load above which quality steps down */
+  double m_recoverLoad = 0.4;  /**< Load that must hold for m_recoverPeriods pump cycles to step back up */
+  unsigned m_recoverPeriods = 200;
+  int m_virtualPriority = 0; /**< Voices with IAudioVoice::setPriority() below this may be virtualized */
+};
+
 /** Time-sensitive event callback for synchronizing the client with rendered audio waveform */
 struct IAudioVoiceEngineCallback {
   /** All mixing occurs in virtual 5ms intervals;
@@ -23,6 +41,10 @@ struct IAudioVoiceEngineCallback {
   /** When a pumping cycle is complete this is called to allow the client to
    *  perform periodic cleanup tasks */
   virtual void onPumpCycleComplete(IAudioVoiceEngine& engine) {}
+
+  /** Called from the mixing thread when the watchdog changes quality level;
+   *  load is the smoothed ratio of mix time to audio time that triggered it */
+  virtual void onQualityLevelChanged(IAudioVoiceEngine& engine, AudioQualityLevel level, double load) {}
 };
 
 /** Mixing and sample-rate-conversion system. Allocates voices and mixes them
@@ -36,17 +58,34 @@ struct IAudioVoiceEngine {
    *
    *  Client must be prepared to supply audio frames via the callback when this is called;
    *  the backing audio-buffers are primed with initial data for low-latency playback start
+   *
+   *  resampler selects the sample-rate converter; the interpolating types suit voices
+   *  with continuously modulated pitch where soxr's cost outweighs its fidelity
    */
   virtual ObjToken<IAudioVoice> allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                     bool dynamicPitch = false) = 0;
+                                                     bool dynamicPitch = false,
+                                                     AudioResamplerType resampler = AudioResamplerType::SoXR) = 0;
 
   /** Same as allocateNewMonoVoice, but source audio is stereo-interleaved */
   virtual ObjToken<IAudioVoice> allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                       bool dynamicPitch = false) = 0;
+                                                       bool dynamicPitch = false,
+                                                       AudioResamplerType resampler = AudioResamplerType::SoXR) = 0;
+
+  /** Allocate a voice that plays sample directly from its (possibly memory-mapped) storage,
+   *  beginning at startFrame. No supplyAudio() calls are made; cb is optional and, if set,
+   *  still receives preSupplyAudio() and routeAudio(). A non-looped sample stops the voice when
+   *  exhausted and start() will play it again from startFrame. */
+  virtual ObjToken<IAudioVoice> allocateNewSampleVoice(const AudioSampleData& sample, size_t startFrame = 0,
+                                                       IAudioVoiceCallback* cb = nullptr, bool dynamicPitch = false,
+                                                       AudioResamplerType resampler = AudioResamplerType::SoXR) = 0;
 
   /** Client calls this to allocate a Submix for gathering audio together for effects processing */
   virtual ObjToken<IAudioSubmix> allocateNewSubmix(bool mainOut, IAudioSubmixCallback* cb, int busId) = 0;
 
+  /** Capture the final mix (before master volume and Lt/Rt encoding) for consumption
+   *  on another thread; see IAudioSubmix::allocateTap() */
+  virtual ObjToken<IAudioSubmixTap> allocateMainMixTap(size_t blockCount = 64) = 0;
+
   /** Client can register for key callback events from the mixing engine this way */
   virtual void setCallbackInterface(IAudioVoiceEngineCallback* cb) = 0;
 
@@ -59,6 +98,13 @@ struct IAudioVoiceEngine {
   /** Set total volume of engine */
   virtual void setVolume(float vol) = 0;
 
+  /** Configure the watchdog that degrades mixing quality under CPU pressure
+   *  (enabled by default, except for the WAV render engine) */
+  virtual void setQualityWatchdog(const AudioWatchdogConfig& config) = 0;
+
+  /** Quality level currently applied by the watchdog */
+  virtual AudioQualityLevel getQualityLevel() const = 0;
+
   /** Enable or disable Lt/Rt surround encoding. If successful, getAvailableSet() will return Surround51 */
   virtual bool enableLtRt(bool enable) = 0;
 
@@ -95,6 +141,10 @@ struct IAudioVoiceEngine {
   /** Open named MIDI in/out port, name format depends on OS */
   virtual std::unique_ptr<IMIDIInOut> newRealMIDIInOut(const char* name, ReceiveFunctor&& receiver) = 0;
 
+  /** Create a queue that replays MIDI input into reader on the mixing thread at the start of each
+   *  5ms interval with frame offsets; open a port with its receiver(). See MIDIEventQueue */
+  virtual std::unique_ptr<MIDIEventQueue> newMIDIEventQueue(IMIDIReader& reader, size_t capacity = 1024) = 0;
+
   /** If this returns true, MIDI callbacks are assumed to be *not* thread-safe; need protection via mutex */
   virtual bool useMIDILock() const = 0;
 
@@ -105,10 +155,36 @@ struct IAudioVoiceEngine {
 /** Construct host platform's voice engine */
 std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine();
 
-/** Construct WAV-rendering voice engine */
-std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const char* path, double sampleRate, int numChans);
+/** Construct host platform's voice engine bound to outputName (a name from enumerateAudioOutputs()).
+ *  Engines are fully independent: several may run concurrently, each with its own device, mix format
+ *  and channel layout, and each pumped by the client. Use AudioEngineBridge to send audio across them.
+ *  Returns empty unique_ptr if the output can't be opened */
+std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine(const char* outputName);
+
+#if __linux__ || __FreeBSD__
+/** Construct voice engine that writes directly into an ALSA PCM's mmap buffer,
+ *  bypassing any sound server. Returns empty unique_ptr if the device can't be opened.
+ *  The ALSA 'null' device may be used to drive the mixer without audio hardware */
+std::unique_ptr<IAudioVoiceEngine> NewALSAAudioVoiceEngine(const char* device = "default", int numChans = 2);
+#endif
+
+/** File sink tuning for the WAV-rendering voice engine */
+struct WAVOutOptions {
+  size_t m_bufferBytes = 8 << 20;    /**< Ring between the mixing thread and the writer thread */
+  size_t m_writeBytes = 1 << 20;     /**< Size of each write issued to the file (rounded to 4KiB) */
+  bool m_directIO = false;           /**< Bypass the OS page cache (O_DIRECT / F_NOCACHE) where supported */
+  double m_headerFixupSeconds = 1.0; /**< Rewrite header sizes this often so a truncated file stays readable;
+                                          0 only writes them on close */
+};
+
+/** Construct WAV-rendering voice engine. Mixed audio is handed to a background writer thread;
+ *  pumpAndMixVoices() only waits if the writer falls a full buffer behind.
+ *  Files growing past 4GiB are promoted to RF64. The quality watchdog starts disabled */
+std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const char* path, double sampleRate, int numChans,
+                                                          const WAVOutOptions& options = {});
 #if _WIN32
-std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const wchar_t* path, double sampleRate, int numChans);
+std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const wchar_t* path, double sampleRate, int numChans,
+                                                          const WAVOutOptions& options = {});
 #endif
 
 } // namespace boo
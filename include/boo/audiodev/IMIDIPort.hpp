@@ -4,11 +4,51 @@
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace boo {
 struct IAudioVoiceEngine;
-using ReceiveFunctor = std::function<void(std::vector<uint8_t>&&, double time)>;
+
+/** Client callback for incoming MIDI bytes; constructible from either form of callable:
+ *  - void(const uint8_t* data, size_t len, double time): data is borrowed from the port's
+ *    read buffer and only valid during the call; nothing is allocated per read.
+ *  - void(std::vector<uint8_t>&& bytes, double time): receives an owned copy of each read. */
+class ReceiveFunctor {
+  std::function<void(const uint8_t*, size_t, double)> m_span;
+  std::function<void(std::vector<uint8_t>&&, double)> m_vector;
+
+  template <typename F>
+  static constexpr bool IsSpanFn =
+      !std::is_same_v<std::decay_t<F>, ReceiveFunctor> && std::is_invocable_v<F&, const uint8_t*, size_t, double>;
+  template <typename F>
+  static constexpr bool IsVectorFn = !std::is_same_v<std::decay_t<F>, ReceiveFunctor> && !IsSpanFn<F> &&
+                                     std::is_invocable_v<F&, std::vector<uint8_t>&&, double>;
+
+public:
+  ReceiveFunctor() = default;
+  template <typename F, std::enable_if_t<IsSpanFn<F>, int> = 0>
+  ReceiveFunctor(F&& f) : m_span(std::forward<F>(f)) {}
+  template <typename F, std::enable_if_t<IsVectorFn<F>, int> = 0>
+  ReceiveFunctor(F&& f) : m_vector(std::forward<F>(f)) {}
+
+  void operator()(const uint8_t* data, size_t len, double time) const {
+    if (m_span)
+      m_span(data, len, time);
+    else if (m_vector)
+      m_vector(std::vector<uint8_t>(data, data + len), time);
+  }
+
+  void operator()(std::vector<uint8_t>&& bytes, double time) const {
+    if (m_vector)
+      m_vector(std::move(bytes), time);
+    else if (m_span)
+      m_span(bytes.data(), bytes.size(), time);
+  }
+
+  explicit operator bool() const { return m_span || m_vector; }
+};
 
 class IMIDIPort {
   bool m_virtual;
@@ -10,8 +10,15 @@ class MIDIDecoder {
   IMIDIReader& m_out;
   uint8_t m_status = 0;
 
+  template <typename It>
+  It _receive(It begin, It end);
+
 public:
   MIDIDecoder(IMIDIReader& out) : m_out(out) {}
+
+  /** Decode every complete message in [begin, end); returns the first byte not consumed.
+   *  The pointer form decodes straight out of a borrowed buffer without copying */
+  const uint8_t* receiveBytes(const uint8_t* begin, const uint8_t* end);
   std::vector<uint8_t>::const_iterator receiveBytes(std::vector<uint8_t>::const_iterator begin,
                                                     std::vector<uint8_t>::const_iterator end);
 };
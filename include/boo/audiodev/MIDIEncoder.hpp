@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 
@@ -7,11 +9,30 @@
 
 namespace boo {
 
+/** Encodes IMIDIReader calls into MIDI wire bytes for Sender::send(), eliding repeated
+ *  channel status bytes (running status).
+ *
+ *  By default every message is sent as it is encoded. In buffered mode messages accumulate
+ *  in a fixed buffer and go out in one send() per flush(); call flush() once per audio or game
+ *  frame. The buffer is also flushed early when flushBytes are pending or, as messages are
+ *  added, when the oldest pending message is older than maxLatency seconds. */
 template <class Sender>
 class MIDIEncoder : public IMIDIReader {
+public:
+  static constexpr size_t BufferBytes = 1024;
+
+private:
   Sender& m_sender;
   uint8_t m_status = 0;
 
+  bool m_buffered = false;
+  size_t m_flushBytes = BufferBytes;
+  std::chrono::steady_clock::duration m_maxLatency{};
+  std::chrono::steady_clock::time_point m_firstPending;
+  size_t m_pending = 0;
+  uint8_t m_buffer[BufferBytes];
+
+  void _send(const void* data, size_t len);
   void _sendMessage(const uint8_t* data, size_t len);
 
   template <typename ContiguousContainer>
@@ -23,6 +44,16 @@ class MIDIEncoder : public IMIDIReader {
 
 public:
   MIDIEncoder(Sender& sender) : m_sender(sender) {}
+  ~MIDIEncoder() { flush(); }
+
+  /** Switch to buffered mode; flushBytes is clamped to BufferBytes */
+  void setBuffered(size_t flushBytes = BufferBytes, double maxLatency = 0.005);
+
+  /** Flush and return to sending every message immediately */
+  void setUnbuffered();
+
+  /** Send all pending bytes in a single write */
+  void flush();
 
   void noteOff(uint8_t chan, uint8_t key, uint8_t velocity) override;
   void noteOn(uint8_t chan, uint8_t key, uint8_t velocity) override;
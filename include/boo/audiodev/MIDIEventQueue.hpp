@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "boo/audiodev/IMIDIPort.hpp"
+
+namespace boo {
+class BaseAudioVoiceEngine;
+class IMIDIReader;
+
+/** Delivers MIDI input on the mixing thread with sample-accurate timing.
+ *  Open a MIDI in port with receiver(); incoming bytes are decoded on the port's receive thread,
+ *  stamped with the monotonic clock and pushed into a wait-free ring. At the start of each 5ms
+ *  mixing interval the engine replays every event that falls within the interval into the
+ *  reader, in arrival order; getFrameOffset() gives each event's frame within that interval.
+ *
+ *  Events are scheduled one pump period (plus setLatency()) behind their arrival, so jitter of
+ *  the receive thread and the pump cycle shifts nothing and notes keep their relative timing.
+ *
+ *  Create with IAudioVoiceEngine::newMIDIEventQueue(). A queue accepts a single port and must
+ *  outlive it. Destroying a queue while the engine is pumping blocks until the pump finishes;
+ *  the mixing thread may destroy one outside of the reader's callbacks. Sysex messages longer
+ *  than MaxSysexBytes, or arriving while the ring is full, are dropped and counted. */
+class MIDIEventQueue {
+public:
+  static constexpr size_t MaxSysexBytes = 1024;
+
+private:
+  friend class BaseAudioVoiceEngine;
+  class Producer;
+
+  struct Event {
+    double m_time;
+    uint64_t m_sysexPos;
+    uint32_t m_sysexLen;
+    uint16_t m_value;
+    uint8_t m_kind;
+    uint8_t m_chan;
+    uint8_t m_a;
+    uint8_t m_b;
+  };
+
+  BaseAudioVoiceEngine* m_parent;
+  IMIDIReader& m_reader;
+  std::unique_ptr<Producer> m_producer;
+
+  size_t m_mask;
+  std::unique_ptr<Event[]> m_events;
+  size_t m_sysexMask;
+  std::unique_ptr<uint8_t[]> m_sysexData;
+  uint8_t m_sysexScratch[MaxSysexBytes];
+
+  /* Producer and consumer indices live on separate cache lines */
+  alignas(64) std::atomic<size_t> m_writeIdx = 0;
+  uint64_t m_sysexWritePos = 0;
+  alignas(64) std::atomic<size_t> m_readIdx = 0;
+  std::atomic<uint64_t> m_sysexReadPos = 0;
+  std::atomic<uint64_t> m_dropped = 0;
+  std::atomic<double> m_latency = 0.0;
+  size_t m_frameOffset = 0;
+
+  /* Receive thread */
+  bool _push(const Event& ev, const void* sysex);
+
+  /* Mixing thread: replay events up to the end of an interval whose first frame
+   * plays at intervalTime (monotonic seconds, already shifted by the pump latency) */
+  void _deliver(double intervalTime, double sampleRate, size_t frames);
+  void _dispatch(const Event& ev);
+
+public:
+  MIDIEventQueue(BaseAudioVoiceEngine& parent, IMIDIReader& reader, size_t capacity);
+  ~MIDIEventQueue();
+  MIDIEventQueue(const MIDIEventQueue&) = delete;
+  MIDIEventQueue& operator=(const MIDIEventQueue&) = delete;
+
+  /** Functor for opening the MIDI in port that feeds this queue */
+  ReceiveFunctor receiver();
+
+  /** Within a reader callback, the frame of the current 5ms interval the event lands on */
+  size_t getFrameOffset() const { return m_frameOffset; }
+
+  /** Additional scheduling delay in seconds, for receive paths with more jitter than one pump period */
+  void setLatency(double seconds) { m_latency.store(seconds, std::memory_order_relaxed); }
+
+  /** Events lost to a full ring or an oversized sysex */
+  uint64_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+  void _disown() { m_parent = nullptr; }
+};
+
+} // namespace boo
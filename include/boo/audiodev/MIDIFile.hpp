@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "boo/System.hpp"
+#include "boo/audiodev/MIDIDecoder.hpp"
+
+namespace boo {
+class IMIDIReader;
+
+/** Standard MIDI File (formats 0, 1 and 2) parsed into time-ordered event lists.
+ *  The tracks of a format 0/1 file are merged into one sequence; each track of a format 2
+ *  file is its own sequence with its own tempo map. Every event carries both its tick and
+ *  its time in seconds, resolved through the tempo map (or fixed SMPTE division) at load,
+ *  so playback and seeking never walk the file.
+ *
+ *  Event bytes are stored with explicit status in the form MIDIDecoder accepts; meta events
+ *  other than tempo and end-of-track are dropped. */
+class MIDIFile {
+public:
+  struct Event {
+    uint64_t m_tick;
+    double m_time;
+    uint32_t m_offset; /* Into the shared event byte store */
+    uint32_t m_length;
+  };
+
+private:
+  struct TempoPoint {
+    uint64_t m_tick;
+    double m_time;
+    double m_secondsPerTick;
+  };
+
+  struct Sequence {
+    std::vector<Event> m_events;
+    std::vector<TempoPoint> m_tempoMap;
+    uint64_t m_endTick = 0;
+    double m_duration = 0.0;
+  };
+
+  std::vector<uint8_t> m_data;
+  std::vector<Sequence> m_sequences;
+  unsigned m_format = 0;
+  uint16_t m_division = 0;
+
+  bool _parse(const uint8_t* data, size_t len);
+  bool _parseTrack(const uint8_t* data, size_t len, std::vector<Event>& events, std::vector<TempoPoint>& tempos,
+                   uint64_t& endTick);
+  void _buildTempoMap(Sequence& seq, std::vector<TempoPoint>& tempos) const;
+  static double _tickToSeconds(const Sequence& seq, uint64_t tick);
+
+public:
+  MIDIFile() = default;
+  explicit MIDIFile(const SystemChar* path) { open(path); }
+
+  bool open(const SystemChar* path);
+  bool load(const void* data, size_t len);
+  void clear();
+  bool isLoaded() const { return !m_sequences.empty(); }
+
+  unsigned getFormat() const { return m_format; }
+  size_t getSequenceCount() const { return m_sequences.size(); }
+  double getDuration(size_t seq = 0) const { return m_sequences[seq].m_duration; }
+
+  const std::vector<Event>& getEvents(size_t seq = 0) const { return m_sequences[seq].m_events; }
+  const uint8_t* getEventData(const Event& ev) const { return m_data.data() + ev.m_offset; }
+
+  /** Tempo map lookups; O(log n) in the number of tempo changes */
+  double tickToSeconds(uint64_t tick, size_t seq = 0) const;
+  uint64_t secondsToTick(double seconds, size_t seq = 0) const;
+
+  /** Index of the first event at or after seconds; O(log n) */
+  size_t findEvent(double seconds, size_t seq = 0) const;
+};
+
+/** Plays one sequence of a MIDIFile into an IMIDIReader in audio-interval steps.
+ *  Drive it from IAudioVoiceEngineCallback::on5MsInterval() with advanceFrames(); within
+ *  each reader callback getFrameOffset() gives the event's frame in that interval. */
+class MIDISequencer {
+  const MIDIFile& m_file;
+  IMIDIReader& m_reader;
+  MIDIDecoder m_decoder;
+  size_t m_sequence;
+  size_t m_next = 0;
+  double m_time = 0.0;
+  size_t m_frameOffset = 0;
+
+  void _dispatchUntil(double endTime, double sampleRate);
+
+public:
+  MIDISequencer(const MIDIFile& file, IMIDIReader& reader, size_t sequence = 0);
+
+  /** Dispatch every event in the next frames at sampleRate; returns false once the sequence has ended */
+  bool advanceFrames(size_t frames, double sampleRate);
+
+  /** Same, in seconds; getFrameOffset() stays 0 */
+  bool advance(double seconds);
+
+  /** Jump to a position in O(log n). Sends allNotesOff() on every channel so that no note
+   *  started before the new position keeps sounding; controllers are not chased */
+  void seek(double seconds);
+  void seekTick(uint64_t tick) { seek(m_file.tickToSeconds(tick, m_sequence)); }
+
+  double getTime() const { return m_time; }
+  bool isFinished() const { return m_next >= m_file.getEvents(m_sequence).size(); }
+  size_t getFrameOffset() const { return m_frameOffset; }
+};
+
+} // namespace boo
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdio>
 #include <cstdint>
@@ -8,6 +10,7 @@
 #include <vector>
 
 #include "boo/System.hpp"
+#include "boo/inputdev/InputLatency.hpp"
 
 #if _WIN32
 #include <hidsdi.h>
@@ -16,6 +19,7 @@
 namespace boo {
 class DeviceToken;
 class IHIDDevice;
+class HIDRecorder;
 
 enum class HIDReportType { Input, Output, Feature };
 
@@ -29,9 +33,24 @@ class DeviceBase : public std::enable_shared_from_this<DeviceBase> {
   std::shared_ptr<IHIDDevice> m_hidDev;
   void _deviceDisconnected();
 
+  /* Written on the I/O thread while the client starts and stops recording */
+  std::mutex m_recordLock;
+  std::unique_ptr<HIDRecorder> m_recorder;
+  std::atomic_bool m_recording = false;
+
+  InputLatencyTracker m_latency;
+
+protected:
+  /* Pads mark the end of decoding and of callback delivery for each report */
+  void _reportDecoded() { m_latency.decoded(); }
+  void _reportDelivered() { m_latency.delivered(); }
+
+  /** When the backend read the report being decoded */
+  std::chrono::steady_clock::time_point getReportArrival() const { return m_latency.arrival(); }
+
 public:
   DeviceBase(uint64_t typeHash, DeviceToken* token);
-  virtual ~DeviceBase() = default;
+  virtual ~DeviceBase();
 
   uint64_t getTypeHash() const { return m_typeHash; }
 
@@ -72,6 +91,23 @@ public:
                           uint32_t message = 0); // Prefer callback version
   virtual void receivedHIDReport(const uint8_t* /*data*/, size_t /*length*/, HIDReportType /*tp*/,
                                  uint32_t /*message*/) {}
+
+  /** Backends deliver pushed reports through here rather than calling receivedHIDReport(),
+   *  with the time the report was read from the device */
+  void _receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message,
+                          std::chrono::steady_clock::time_point arrival);
+
+  /** Capture the report descriptor and every input report and USB IN transfer to a file
+   *  for HIDReplay. Replaces any recording already in progress. */
+  bool startRecording(const SystemChar* path);
+  void stopRecording();
+  bool isRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+  /** Input report timing since the device opened (or the last reset): backend dispatch, pad decode,
+   *  end-to-end callback delivery and report interval, with the polling rate they imply.
+   *  For state read through a snapshot, its age is now minus InputSnapshot::m_arrival. */
+  InputLatencyStats getLatencyStats() const { return m_latency.stats(); }
+  void resetLatencyStats() { m_latency.reset(); }
 };
 
 template <class CB>
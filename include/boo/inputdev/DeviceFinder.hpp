@@ -18,11 +18,24 @@
 
 namespace boo {
 
+/* How opened devices are serviced */
+enum class HIDIOBackend {
+  ThreadPerDevice, /* Dedicated transfer thread per device */
+  Reactor          /* One epoll thread multiplexes every HID/USB device (Linux only) */
+};
+
+/* Where scanning looks for devices */
+enum class HIDDeviceEnumeration {
+  Platform, /* Hardware, through the platform listener */
+  Virtual   /* VirtualHIDDevice instances only, for headless testing */
+};
+
 class DeviceFinder {
 public:
   friend class HIDListenerIOKit;
   friend class HIDListenerUdev;
   friend class HIDListenerWinUSB;
+  friend class HIDListenerVirtual;
   static inline DeviceFinder* instance() { return skDevFinder; }
 
 private:
@@ -39,6 +52,11 @@ private:
   TDeviceTokens m_tokens;
   std::mutex m_tokensLock;
 
+  HIDIOBackend m_ioBackend = HIDIOBackend::ThreadPerDevice;
+  HIDDeviceEnumeration m_enumeration = HIDDeviceEnumeration::Platform;
+
+  IHIDListener* _listener();
+
   /* Friend methods for platform-listener to find/insert/remove
    * tokens with type-filtering */
   bool _hasToken(const std::string& path) const {
@@ -79,6 +97,14 @@ public:
   /* Manual device scanning */
   bool scanNow();
 
+  /* Backend for devices opened from now on; ignored where unsupported */
+  void setIOBackend(HIDIOBackend backend) { m_ioBackend = backend; }
+  HIDIOBackend getIOBackend() const { return m_ioBackend; }
+
+  /* Switching stops any scan in progress; tokens already found are kept */
+  void setDeviceEnumeration(HIDDeviceEnumeration enumeration);
+  HIDDeviceEnumeration getDeviceEnumeration() const { return m_enumeration; }
+
   virtual void deviceConnected(DeviceToken&) {}
   virtual void deviceDisconnected(DeviceToken&, DeviceBase*) {}
 
@@ -1,10 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <memory>
-#include <string>
-#include <typeindex>
+#include <string_view>
 #include <vector>
 
 namespace boo {
@@ -13,25 +13,50 @@ enum class DeviceType { None = 0, USB = 1, Bluetooth = 2, HID = 3, XInput = 4 };
 
 class DeviceToken;
 class DeviceBase;
+class IHIDDevice;
 
-#define dev_typeid(type) std::hash<std::string>()(#type)
+/* FNV-1a of the type name, so type IDs are compile-time constants */
+constexpr uint64_t DeviceTypeId(std::string_view name) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (char c : name) {
+    hash ^= uint8_t(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+#define dev_typeid(type) (::boo::DeviceTypeId(#type))
 
 struct DeviceSignature {
   using TDeviceSignatureSet = std::vector<const DeviceSignature*>;
-  using TFactoryLambda = std::function<std::shared_ptr<DeviceBase>(DeviceToken*)>;
+  using TFactoryLambda = std::shared_ptr<DeviceBase> (*)(DeviceToken*);
 
   const char* m_name = nullptr;
   uint64_t m_typeHash = 0;
   unsigned m_vid = 0;
   unsigned m_pid = 0;
-  TFactoryLambda m_factory;
+  TFactoryLambda m_factory = nullptr;
   DeviceType m_type{};
-  DeviceSignature() : m_typeHash(dev_typeid(DeviceSignature)) {} /* Sentinel constructor */
-  DeviceSignature(const char* name, uint64_t typeHash, unsigned vid, unsigned pid, TFactoryLambda&& factory,
-                  DeviceType type = DeviceType::None)
+  constexpr DeviceSignature() : m_typeHash(dev_typeid(DeviceSignature)) {} /* Sentinel constructor */
+  constexpr DeviceSignature(const char* name, uint64_t typeHash, unsigned vid, unsigned pid, TFactoryLambda factory,
+                            DeviceType type = DeviceType::None)
   : m_name(name), m_typeHash(typeHash), m_vid(vid), m_pid(pid), m_factory(factory), m_type(type) {}
   static bool DeviceMatchToken(const DeviceToken& token, const TDeviceSignatureSet& sigSet);
   static std::shared_ptr<DeviceBase> DeviceNew(DeviceToken& token);
+
+  /** O(1) lookup by VID/PID over BOO_DEVICE_SIGS and registered signatures; nullptr if none */
+  static const DeviceSignature* Find(unsigned vid, unsigned pid);
+
+  /** Add a signature at runtime; it takes precedence over a built-in one with the same VID/PID.
+   *  A DeviceFinder only sees signatures registered before it is constructed. */
+  static void Register(const DeviceSignature& sig);
+
+  /** Signatures registered so far with the given type hash */
+  static void FindRegistered(uint64_t typeHash, TDeviceSignatureSet& out);
+
+private:
+  /* Hardware backend, or the token's replay/virtual source */
+  static std::shared_ptr<IHIDDevice> HIDDeviceNew(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp);
 };
 
 #define DEVICE_SIG(name, vid, pid, type)                                                                               \
@@ -39,6 +64,76 @@ struct DeviceSignature {
                   [](DeviceToken* tok) -> std::shared_ptr<DeviceBase> { return std::make_shared<name>(tok); }, type)
 #define DEVICE_SIG_SENTINEL() DeviceSignature()
 
+/** Perfect hash from VID/PID to a signature, searched for at compile time.
+ *  Signatures with a zero VID and PID (matched by device class instead) are left out, and
+ *  where several share a VID/PID the first one wins, as with a linear scan. */
+class DeviceSignatureIndex {
+  const DeviceSignature* m_sigs;
+  const uint16_t* m_slots;
+  uint64_t m_seed;
+  uint32_t m_mask;
+
+public:
+  static constexpr uint16_t Empty = 0xffff;
+
+  static constexpr uint32_t Key(unsigned vid, unsigned pid) { return uint32_t(vid & 0xffff) << 16 | (pid & 0xffff); }
+  static constexpr uint32_t Slot(uint32_t key, uint64_t seed, uint32_t mask) {
+    uint64_t x = (key ^ seed) * 0x9e3779b97f4a7c15;
+    return uint32_t(x >> 32) & mask;
+  }
+
+  constexpr DeviceSignatureIndex(const DeviceSignature* sigs, const uint16_t* slots, uint64_t seed, uint32_t mask)
+  : m_sigs(sigs), m_slots(slots), m_seed(seed), m_mask(mask) {}
+
+  const DeviceSignature* find(unsigned vid, unsigned pid) const {
+    uint32_t key = Key(vid, pid);
+    uint16_t idx = m_slots[Slot(key, m_seed, m_mask)];
+    if (idx == Empty || Key(m_sigs[idx].m_vid, m_sigs[idx].m_pid) != key)
+      return nullptr;
+    return &m_sigs[idx];
+  }
+};
+
+/** Slot table backing a DeviceSignatureIndex; build with MakeDeviceSignatureTable() */
+template <size_t Size>
+struct DeviceSignatureTable {
+  std::array<uint16_t, Size> m_slots{};
+  uint64_t m_seed = 0;
+};
+
+template <size_t N>
+constexpr size_t DeviceSignatureTableSize() {
+  /* At most 25% load keeps the seed search short */
+  size_t size = 4;
+  while (size < 4 * N)
+    size <<= 1;
+  return size;
+}
+
+template <size_t N>
+constexpr auto MakeDeviceSignatureTable(const DeviceSignature (&sigs)[N]) {
+  constexpr size_t Size = DeviceSignatureTableSize<N>();
+  DeviceSignatureTable<Size> table;
+  for (uint64_t seed = 0;; ++seed) {
+    table.m_seed = seed;
+    table.m_slots.fill(DeviceSignatureIndex::Empty);
+    bool collision = false;
+    for (size_t i = 0; i < N && !collision; ++i) {
+      if (!sigs[i].m_name || (!sigs[i].m_vid && !sigs[i].m_pid))
+        continue;
+      uint32_t key = DeviceSignatureIndex::Key(sigs[i].m_vid, sigs[i].m_pid);
+      uint16_t& slot = table.m_slots[DeviceSignatureIndex::Slot(key, seed, Size - 1)];
+      if (slot == DeviceSignatureIndex::Empty)
+        slot = uint16_t(i);
+      else if (DeviceSignatureIndex::Key(sigs[slot].m_vid, sigs[slot].m_pid) != key)
+        collision = true;
+    }
+    if (!collision)
+      return table;
+  }
+}
+
 extern const DeviceSignature BOO_DEVICE_SIGS[];
+extern const DeviceSignatureIndex BOO_DEVICE_SIG_INDEX;
 
 } // namespace boo
@@ -7,10 +7,13 @@
 #include "boo/inputdev/DeviceSignature.hpp"
 
 namespace boo {
+class IHIDDeviceSource;
 
 class DeviceToken {
   friend struct DeviceSignature;
   friend class HIDListenerWinUSB;
+  friend class HIDReplay;
+  friend class HIDListenerVirtual;
   DeviceType m_devType;
   unsigned m_vendorId;
   unsigned m_productId;
@@ -21,6 +24,9 @@ class DeviceToken {
   friend class DeviceBase;
   std::shared_ptr<DeviceBase> m_connectedDev;
 
+  /* Non-hardware backend, if any */
+  std::shared_ptr<IHIDDeviceSource> m_hidSource;
+
   friend class DeviceFinder;
   void _deviceClose() {
     if (m_connectedDev)
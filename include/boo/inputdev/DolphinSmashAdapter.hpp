@@ -6,6 +6,7 @@
 
 #include "boo/System.hpp"
 #include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/InputSnapshot.hpp"
 
 namespace boo {
 
@@ -46,6 +47,12 @@ struct DolphinControllerState {
   void clamp();
 };
 
+/** All four ports, as published for polling; m_types[i] is None for an empty port */
+struct DolphinSmashAdapterState {
+  std::array<EDolphinControllerType, 4> m_types{};
+  std::array<DolphinControllerState, 4> m_controllers{};
+};
+
 struct IDolphinSmashAdapterCallback {
   virtual void controllerConnected([[maybe_unused]] unsigned idx, [[maybe_unused]] EDolphinControllerType type) {}
   virtual void controllerDisconnected([[maybe_unused]] unsigned idx) {}
@@ -61,6 +68,7 @@ class DolphinSmashAdapter final : public TDeviceBase<IDolphinSmashAdapterCallbac
   uint8_t m_rumbleRequest = 0;
   std::array<bool, 4> m_hardStop{};
   uint8_t m_rumbleState = 0xf; /* Force initial send of stop-rumble command */
+  InputSnapshotSlot<DolphinSmashAdapterState> m_snapshot;
   void deviceDisconnected() override;
   void initialCycle() override;
   void transferCycle() override;
@@ -75,6 +83,9 @@ public:
     m_knownControllers = 0;
   }
 
+  /** Lock-free poll of the latest report; false until the first one arrives */
+  bool getSnapshot(InputSnapshot<DolphinSmashAdapterState>& out) const { return m_snapshot.read(out); }
+
   void startRumble(size_t idx) {
     if (idx >= m_hardStop.size()) {
       return;
@@ -4,6 +4,7 @@
 
 #include "boo/System.hpp"
 #include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/InputSnapshot.hpp"
 
 namespace boo {
 
@@ -113,6 +114,7 @@ class DualshockPad final : public TDeviceBase<IDualshockPadCallback> {
   uint8_t m_rumbleIntensity[2];
   EDualshockLED m_led;
   DualshockOutReport m_report;
+  InputSnapshotSlot<DualshockPadState> m_snapshot;
   void deviceDisconnected() override;
   void initialCycle() override;
   void transferCycle() override;
@@ -137,6 +139,9 @@ public:
 
   void stopRumble(int motor) { m_rumbleRequest &= ~EDualshockMotor(motor); }
 
+  /** Lock-free poll of the latest report; false until the first one arrives */
+  bool getSnapshot(InputSnapshot<DualshockPadState>& out) const { return m_snapshot.read(out); }
+
   EDualshockLED getLED() const { return m_led; }
 
   void setLED(EDualshockLED led, bool on = true) {
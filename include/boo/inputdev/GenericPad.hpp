@@ -1,9 +1,13 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "boo/inputdev/DeviceBase.hpp"
 #include "boo/inputdev/HIDParser.hpp"
+#include "boo/inputdev/InputSnapshot.hpp"
 
 namespace boo {
 
@@ -14,7 +18,41 @@ struct IGenericPadCallback {
 };
 
 class GenericPad final : public TDeviceBase<IGenericPadCallback> {
+  struct AxisFilter {
+    HIDUsagePage m_usagePage;
+    HIDUsage m_usage;
+    int32_t m_deadzone;
+    int32_t m_epsilon;
+  };
+  struct ValueState {
+    int32_t m_center = 0;
+    int32_t m_deadzone = 0;
+    int32_t m_epsilon = 0;
+    int32_t m_last = 0;
+    bool m_reported = false;
+  };
+
   HIDParser m_parser;
+  std::unique_ptr<int32_t[]> m_values;
+
+  /* Delta reporting state; guarded by m_callbackLock */
+  bool m_deltaReporting = false;
+  std::vector<AxisFilter> m_axisFilters;
+  std::unique_ptr<ValueState[]> m_valueStates;
+  std::vector<std::pair<uint8_t, std::vector<uint8_t>>> m_lastReports;
+
+  /* Polled values: two buffers of m_snapshotCount values behind a seqlock. Allocated once by
+   * initialCycle() and published to readers through m_snapshotCount */
+  InputSnapshotSequence m_snapshotSeq;
+  std::unique_ptr<int32_t[]> m_snapshotValues;
+  std::chrono::steady_clock::time_point m_snapshotTimes[2];
+  std::chrono::steady_clock::time_point m_snapshotArrivals[2];
+  std::atomic<size_t> m_snapshotCount = 0;
+  void _publishSnapshot();
+
+  void _resetDeltaState();
+  bool _reportUnchanged(const uint8_t* data, size_t length);
+  bool _processReport(const uint8_t* data, size_t length);
 
 public:
   GenericPad(DeviceToken* token);
@@ -25,6 +63,20 @@ public:
   void receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override;
 
   void enumerateValues(const std::function<bool(const HIDMainItem& item)>& valueCB) const;
+
+  /** Lock-free poll of every input value, indexed as HIDParser::GetValueItem(); values are
+   *  unfiltered by delta reporting. false until the first report arrives */
+  bool getSnapshot(InputSnapshot<std::vector<int32_t>>& out) const;
+
+  /** When enabled, valueUpdate() fires only for values that differ from the last one reported,
+   *  and a report byte-identical to the previous report with its ID is dropped before decoding.
+   *  Off by default: every value of every report is delivered. */
+  void setDeltaReporting(bool enabled);
+
+  /** Per-axis thresholds for delta reporting, matched by usage. Values within deadzone of the
+   *  centre of the logical range read as the centre; changes of epsilon or less from the last
+   *  reported value are suppressed, except when reaching the centre or either end of the range. */
+  void setAxisFilter(HIDUsagePage usagePage, HIDUsage usage, int32_t deadzone, int32_t epsilon);
 };
 
 } // namespace boo
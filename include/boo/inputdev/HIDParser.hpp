@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -170,11 +171,15 @@ class HIDParser {
 public:
   enum class ParserStatus { OK, Done, Error };
 
+  /** Half-open range of value indices written by ExtractValues() */
+  using ValueRange = std::pair<uint32_t, uint32_t>;
+
 private:
   ParserStatus m_status = ParserStatus::OK;
 #if _WIN32
 #if !WINDOWS_STORE
   std::vector<HIDMainItem> m_itemPool;
+  std::vector<uint32_t> m_valueItems;
   mutable std::vector<HIDP_DATA> m_dataList;
   PHIDP_PREPARSED_DATA m_descriptorData = nullptr;
 #endif
@@ -186,6 +191,33 @@ private:
   std::pair<uint32_t, uint32_t> m_outputReports = {};
   std::pair<uint32_t, uint32_t> m_featureReports = {};
   bool m_multipleReports = false;
+
+  /* Compiled extraction plan: one op per non-constant input value, grouped per report ID.
+   * Each op reads a little-endian 64-bit word at its byte offset, so any field up to
+   * 32 bits wide is a single load, shift, mask and optional sign extension */
+  struct ExtractOp {
+    uint32_t m_byteOffset; /* From the start of the report, including any ID byte */
+    uint32_t m_mask;
+    uint8_t m_shift;
+    uint8_t m_signShift; /* 32 - width for fields with a negative logical minimum, else 0 */
+  };
+  struct ReportPlan {
+    uint32_t m_length; /* Bytes, including any ID byte */
+    uint32_t m_opsBegin;
+    uint32_t m_wideEnd; /* Ops before this may load 8 bytes without a bounds check */
+    uint32_t m_opsEnd;
+    uint32_t m_valueBase;
+  };
+  static constexpr uint16_t NoPlan = 0xffff;
+  std::unique_ptr<ExtractOp[]> m_extractOps;
+  std::unique_ptr<ReportPlan[]> m_reportPlans;
+  std::unique_ptr<uint32_t[]> m_valueItems; /* Value index -> item pool index */
+  uint32_t m_valueCount = 0;
+  std::array<uint16_t, 256> m_planIndex = {};
+  void _compilePlans();
+  ParserStatus _parseDescriptor(const uint8_t* descriptorData, size_t len);
+  void _assign(const HIDParser& other);
+
   static ParserStatus ParseItem(HIDReports& reportsOut, std::stack<HIDItemState>& stateStack,
                                 std::stack<HIDCollectionItem>& collectionStack, const uint8_t*& it, const uint8_t* end,
                                 bool& multipleReports);
@@ -197,14 +229,35 @@ public:
   ParserStatus Parse(const PHIDP_PREPARSED_DATA descriptorData);
 #endif
 #else
+  /** Successful parses are kept in a process-wide cache keyed by the XXH64 of the descriptor
+   *  bytes, so a device that reconnects copies its compiled state instead of re-parsing */
   ParserStatus Parse(const uint8_t* descriptorData, size_t len);
   static size_t CalculateMaxInputReportSize(const uint8_t* descriptorData, size_t len);
   static std::pair<HIDUsagePage, HIDUsage> GetApplicationUsage(const uint8_t* descriptorData, size_t len);
+
+  /** Persist the raw descriptors in the cache; loading parses them up front so that the
+   *  first connection of a known device after startup is already a cache hit */
+  static bool SaveDescriptorCache(const SystemChar* path);
+  static bool LoadDescriptorCache(const SystemChar* path);
+  static void ClearDescriptorCache();
 #endif
   operator bool() const { return m_status == ParserStatus::Done; }
   void EnumerateValues(const std::function<bool(const HIDMainItem& item)>& valueCB) const;
   void ScanValues(const std::function<bool(const HIDMainItem& item, int32_t value)>& valueCB, const uint8_t* data,
                   size_t len) const;
+
+  /** Whether input reports begin with a report ID byte */
+  bool HasReportIDs() const;
+
+  /** Number of non-constant input values, indexed in EnumerateValues() order */
+  size_t GetValueCount() const;
+  const HIDMainItem& GetValueItem(size_t idx) const;
+
+  /** Decode one input report into values, a caller-owned array of GetValueCount() entries.
+   *  Only the values carried by the report's ID are written; their index range is returned,
+   *  empty if the report is unknown or too short. Fields with a negative logical minimum
+   *  are sign-extended. */
+  ValueRange ExtractValues(const uint8_t* data, size_t len, int32_t* values) const;
 };
 
 } // namespace boo
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+#include "boo/System.hpp"
+
+namespace boo {
+class DeviceToken;
+
+enum class HIDReplayMode {
+  RealTime,        /* Reports are spaced as they were recorded */
+  AsFastAsPossible /* No waiting between reports, for benchmarks and regression tests */
+};
+
+/** Plays back a file written by DeviceBase::startRecording().
+ *  The token carries the recorded device type and VID/PID, so openAndGetDevice() creates the same
+ *  pad class as the original device, attached to a replay backend instead of hardware. Playback
+ *  begins at start(), leaving time to set a callback; reports then reach the pad through the normal
+ *  receivedHIDReport()/receiveUSBInterruptTransfer() paths on a playback thread. Output reports
+ *  (rumble, LEDs) are discarded. */
+class HIDReplay {
+public:
+  struct Recording;
+
+private:
+  std::shared_ptr<Recording> m_recording;
+  std::unique_ptr<DeviceToken> m_token;
+
+public:
+  HIDReplay();
+  ~HIDReplay();
+  HIDReplay(const HIDReplay&) = delete;
+  HIDReplay& operator=(const HIDReplay&) = delete;
+
+  bool open(const SystemChar* path, HIDReplayMode mode = HIDReplayMode::RealTime);
+  void close();
+
+  /** Token for the recorded device; its openAndGetDevice() creates the pad */
+  DeviceToken* getToken() const { return m_token.get(); }
+
+  /** Begin feeding reports to the opened device */
+  void start();
+
+  size_t getRecordCount() const;
+  std::chrono::microseconds getDuration() const;
+
+  /** Wait for playback to reach the end of the file, or for the device to be closed */
+  void waitFinished() const;
+  bool waitFinished(std::chrono::milliseconds timeout) const;
+};
+
+} // namespace boo
@@ -34,4 +34,7 @@ public:
 /* Platform-specific constructor */
 std::unique_ptr<IHIDListener> IHIDListenerNew(DeviceFinder& finder);
 
+/* Listener for VirtualHIDDevice instances */
+std::unique_ptr<IHIDListener> VirtualHIDListenerNew(DeviceFinder& finder);
+
 } // namespace boo
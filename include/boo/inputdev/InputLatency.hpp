@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace boo {
+
+/** p50/p99/max of one latency histogram */
+struct LatencySummary {
+  std::chrono::microseconds m_p50{};
+  std::chrono::microseconds m_p99{};
+  std::chrono::microseconds m_max{};
+  uint64_t m_count = 0;
+};
+
+/** Per-device input timing. Every stage is measured from when the backend read the report. */
+struct InputLatencyStats {
+  LatencySummary m_dispatch; /* Read until the pad starts decoding (backend queueing) */
+  LatencySummary m_decode;   /* Time the pad spends decoding a report */
+  LatencySummary m_delivery; /* Read until the pad's callbacks have returned */
+  LatencySummary m_interval; /* Between consecutive reports */
+  double m_pollingRate = 0.0; /* Reports per second at the (bucketed) median interval; 0 until two reports */
+};
+
+/** Log-linear histogram of microsecond durations: exact below 8us, then 8 buckets per power of two,
+ *  so percentiles are within about 6%. One writer (the device's I/O thread); any thread may read. */
+class LatencyHistogram {
+  static constexpr unsigned SubBucketBits = 3;
+  static constexpr unsigned SubBuckets = 1 << SubBucketBits;
+  static constexpr unsigned BucketCount = (32 - SubBucketBits + 1) * SubBuckets; /* Up to 2^32us */
+
+  std::array<std::atomic<uint64_t>, BucketCount> m_buckets{};
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<uint64_t> m_max{0};
+
+  static constexpr unsigned BucketIndex(uint32_t us) {
+    if (us < SubBuckets)
+      return us;
+    unsigned exp = 31;
+    while (!(us >> exp))
+      --exp;
+    unsigned sub = (us >> (exp - SubBucketBits)) & (SubBuckets - 1);
+    return (exp - SubBucketBits + 1) * SubBuckets + sub;
+  }
+
+  static constexpr uint64_t BucketMidpoint(unsigned idx) {
+    if (idx < SubBuckets)
+      return idx;
+    unsigned shift = idx / SubBuckets - 1;
+    uint64_t lower = uint64_t(SubBuckets + idx % SubBuckets) << shift;
+    return lower + ((uint64_t(1) << shift) >> 1);
+  }
+
+  /* Single writer, so plain load/store avoids locked read-modify-writes on the I/O thread */
+  static void Increment(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+public:
+  void record(std::chrono::steady_clock::duration duration) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    uint32_t clamped = us < 0 ? 0 : us > INT64_C(0xffffffff) ? 0xffffffff : uint32_t(us);
+    Increment(m_buckets[BucketIndex(clamped)]);
+    Increment(m_count);
+    if (clamped > m_max.load(std::memory_order_relaxed))
+      m_max.store(clamped, std::memory_order_relaxed);
+  }
+
+  /** Bucket midpoint below which the fraction p of samples fall, capped at the maximum */
+  std::chrono::microseconds percentile(double p) const {
+    uint64_t count = m_count.load(std::memory_order_relaxed);
+    if (!count)
+      return {};
+    uint64_t rank = uint64_t(p * double(count) + 0.5);
+    if (rank < 1)
+      rank = 1;
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < BucketCount; ++i) {
+      seen += m_buckets[i].load(std::memory_order_relaxed);
+      if (seen >= rank)
+        return std::chrono::microseconds(BucketMidpoint(i) < max ? BucketMidpoint(i) : max);
+    }
+    return std::chrono::microseconds(max);
+  }
+
+  LatencySummary summary() const {
+    return {percentile(0.5), percentile(0.99), std::chrono::microseconds(m_max.load(std::memory_order_relaxed)),
+            m_count.load(std::memory_order_relaxed)};
+  }
+
+  /** Samples recorded concurrently with a reset may be lost */
+  void reset() {
+    for (auto& bucket : m_buckets)
+      bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+};
+
+/** Timestamps one device's reports through the pad. Only the I/O thread calls arrived(), decoded()
+ *  and delivered(); stats() and reset() may be called from any thread. */
+class InputLatencyTracker {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point m_arrival{};
+  Clock::time_point m_decodeStart{};
+  Clock::time_point m_lastArrival{};
+  LatencyHistogram m_dispatch;
+  LatencyHistogram m_decode;
+  LatencyHistogram m_delivery;
+  LatencyHistogram m_interval;
+
+public:
+  void arrived(Clock::time_point arrival) {
+    m_decodeStart = Clock::now();
+    if (m_lastArrival != Clock::time_point{})
+      m_interval.record(arrival - m_lastArrival);
+    m_lastArrival = arrival;
+    m_arrival = arrival;
+    m_dispatch.record(m_decodeStart - arrival);
+  }
+  void decoded() { m_decode.record(Clock::now() - m_decodeStart); }
+  void delivered() { m_delivery.record(Clock::now() - m_arrival); }
+
+  /** When the report being decoded was read */
+  Clock::time_point arrival() const { return m_arrival; }
+
+  InputLatencyStats stats() const {
+    InputLatencyStats stats;
+    stats.m_dispatch = m_dispatch.summary();
+    stats.m_decode = m_decode.summary();
+    stats.m_delivery = m_delivery.summary();
+    stats.m_interval = m_interval.summary();
+    if (stats.m_interval.m_p50.count() > 0)
+      stats.m_pollingRate = 1000000.0 / double(stats.m_interval.m_p50.count());
+    return stats;
+  }
+
+  void reset() {
+    m_dispatch.reset();
+    m_decode.reset();
+    m_delivery.reset();
+    m_interval.reset();
+  }
+};
+
+} // namespace boo
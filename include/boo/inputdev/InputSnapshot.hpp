@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+namespace boo {
+
+/** Latest decoded state of a pad, as read by the polling API */
+template <typename State>
+struct InputSnapshot {
+  State m_state{};
+  /** Number of reports published so far; 0 until the first */
+  uint64_t m_reportCount = 0;
+  /** When the report was published, on the I/O thread */
+  std::chrono::steady_clock::time_point m_timestamp;
+  /** When the backend read the report; now minus this is the state's age */
+  std::chrono::steady_clock::time_point m_arrival;
+};
+
+/** Sequence counter for a single-writer, double-buffered seqlock.
+ *  Publish n writes buffer (n & 1) while the counter is odd (2n - 1), then makes it even (2n).
+ *  A reader copies the last complete publish and only retries if the writer has lapped it
+ *  by starting on the same buffer again, so readers never block the writer or each other. */
+class InputSnapshotSequence {
+  std::atomic<uint64_t> m_sequence{0};
+
+public:
+  /** Writer: returns the publish number; write buffer (n & 1) then call endWrite(n) */
+  uint64_t beginWrite() {
+    uint64_t n = m_sequence.load(std::memory_order_relaxed) / 2 + 1;
+    m_sequence.store(2 * n - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return n;
+  }
+  void endWrite(uint64_t n) { m_sequence.store(2 * n, std::memory_order_release); }
+
+  /** Reader: returns the last complete publish (0 if none); copy buffer (n & 1) then call endRead(n) */
+  uint64_t beginRead() const { return m_sequence.load(std::memory_order_acquire) / 2; }
+  bool endRead(uint64_t n) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_sequence.load(std::memory_order_relaxed) < 2 * n + 3;
+  }
+};
+
+/** Lock-free slot holding a pad's latest state. Written only by the device's I/O thread;
+ *  read() may be called from any number of threads. */
+template <typename State>
+class InputSnapshotSlot {
+  static_assert(std::is_trivially_copyable_v<State>, "snapshot state is copied while it may be rewritten");
+  InputSnapshotSequence m_sequence;
+  InputSnapshot<State> m_buffers[2];
+
+public:
+  void publish(const State& state, std::chrono::steady_clock::time_point arrival) {
+    uint64_t n = m_sequence.beginWrite();
+    InputSnapshot<State>& buf = m_buffers[n & 1];
+    buf.m_state = state;
+    buf.m_reportCount = n;
+    buf.m_timestamp = std::chrono::steady_clock::now();
+    buf.m_arrival = arrival;
+    m_sequence.endWrite(n);
+  }
+  void publish(const State& state) { publish(state, std::chrono::steady_clock::now()); }
+
+  /** Copy out the latest state; false if nothing has been published yet */
+  bool read(InputSnapshot<State>& out) const {
+    while (true) {
+      uint64_t n = m_sequence.beginRead();
+      if (n == 0)
+        return false;
+      out = m_buffers[n & 1];
+      if (m_sequence.endRead(n))
+        return true;
+    }
+  }
+};
+
+} // namespace boo
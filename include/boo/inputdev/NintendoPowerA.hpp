@@ -1,5 +1,6 @@
 #pragma once
 #include "DeviceBase.hpp"
+#include "InputSnapshot.hpp"
 #include "boo/System.hpp"
 
 namespace boo {
@@ -35,6 +36,7 @@ struct INintendoPowerACallback {
 
 class NintendoPowerA final : public TDeviceBase<INintendoPowerACallback> {
   NintendoPowerAState m_last{};
+  InputSnapshotSlot<NintendoPowerAState> m_snapshot;
   void deviceDisconnected() override;
   void initialCycle() override;
   void transferCycle() override;
@@ -44,5 +46,8 @@ class NintendoPowerA final : public TDeviceBase<INintendoPowerACallback> {
 public:
   explicit NintendoPowerA(DeviceToken*);
   ~NintendoPowerA() override;
+
+  /** Lock-free poll of the latest report; false until the first one arrives */
+  bool getSnapshot(InputSnapshot<NintendoPowerAState>& out) const { return m_snapshot.read(out); }
 };
 } // namespace boo
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/DeviceSignature.hpp"
+
+namespace boo {
+
+/** A report or transfer a pad sent to a virtual device (rumble, LEDs, handshakes) */
+struct VirtualHIDOutput {
+  bool m_usbTransfer = false; /* From sendUSBInterruptTransfer() rather than sendHIDReport() */
+  HIDReportType m_type = HIDReportType::Output;
+  uint32_t m_message = 0;
+  std::vector<uint8_t> m_data;
+};
+
+/** In-process stand-in for a HID or USB device, for exercising pad classes without hardware.
+ *  Constructing one plugs it in: a DeviceFinder enumerating HIDDeviceEnumeration::Virtual reports
+ *  it like a hotplugged device (or on scanNow()), and openAndGetDevice() creates the pad class
+ *  matching its VID/PID. Destroying it unplugs it.
+ *  There is no I/O thread: initialCycle() runs on open, and each inject call drives the pad on the
+ *  calling thread, serialized with the other calls on the same device. */
+class VirtualHIDDevice {
+public:
+  struct State;
+  using OutputCallback = std::function<void(const VirtualHIDOutput&)>;
+
+private:
+  std::shared_ptr<State> m_state;
+
+public:
+  VirtualHIDDevice(DeviceType type, unsigned vid, unsigned pid, std::string_view productName = {},
+                   std::vector<uint8_t> descriptor = {});
+  ~VirtualHIDDevice();
+  VirtualHIDDevice(const VirtualHIDDevice&) = delete;
+  VirtualHIDDevice& operator=(const VirtualHIDDevice&) = delete;
+
+  /** Unique per device; also the token's device path */
+  std::string_view getDevicePath() const;
+
+  /** Whether a pad is currently open on this device */
+  bool isOpen() const;
+
+  /** Deliver an input report as a push-model backend would; false if no pad is open */
+  bool injectHIDReport(const uint8_t* data, size_t length, uint32_t message = 0);
+
+  /** Run transferCycle() with this as the next interrupt IN transfer, as a pull-model backend would */
+  bool injectUSBTransfer(const uint8_t* data, size_t length);
+
+  /** Run transferCycle() with no transfer pending */
+  bool runTransferCycle();
+
+  /** Data returned when the pad calls receiveHIDReport() with this type and report ID */
+  void setReportResponse(HIDReportType tp, uint32_t message, std::vector<uint8_t> data);
+
+  /** Called for each output as it is sent; outputs are queued for takeOutputs() while unset */
+  void setOutputCallback(OutputCallback callback);
+  std::vector<VirtualHIDOutput> takeOutputs();
+};
+
+} // namespace boo
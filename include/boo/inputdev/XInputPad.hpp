@@ -5,6 +5,7 @@
 #include "boo/System.hpp"
 #include "boo/inputdev/DeviceBase.hpp"
 #include "boo/inputdev/DeviceSignature.hpp"
+#include "boo/inputdev/InputSnapshot.hpp"
 
 namespace boo {
 
@@ -35,6 +36,7 @@ class XInputPad final : public TDeviceBase<IXInputPadCallback> {
   friend class HIDListenerWinUSB;
   uint16_t m_rumbleRequest[2] = {};
   uint16_t m_rumbleState[2] = {};
+  InputSnapshotSlot<XInputPadState> m_snapshot;
 
 public:
   XInputPad(DeviceToken* token) : TDeviceBase<IXInputPadCallback>(dev_typeid(XInputPad), token) {}
@@ -43,6 +45,8 @@ public:
     if (m_callback)
       m_callback->controllerDisconnected();
   }
+  /** Lock-free poll of the latest report; false until the first one arrives */
+  bool getSnapshot(InputSnapshot<XInputPadState>& out) const { return m_snapshot.read(out); }
   void startRumble(EXInputMotor motors, uint16_t intensity) {
     if (True(motors & EXInputMotor::Left))
       m_rumbleRequest[0] = intensity;
@@ -0,0 +1,347 @@
+#include "lib/audiodev/AudioVoiceEngine.hpp"
+
+#include "lib/audiodev/LinuxMidi.hpp"
+
+#include <array>
+#include <cstring>
+
+#include <logvisor/logvisor.hpp>
+
+namespace boo {
+static logvisor::Module Log("boo::ALSAPCM");
+
+static const uint64_t StereoChans = (1 << SND_CHMAP_FL) | (1 << SND_CHMAP_FR);
+
+static const uint64_t QuadChans =
+    (1 << SND_CHMAP_FL) | (1 << SND_CHMAP_FR) | (1 << SND_CHMAP_RL) | (1 << SND_CHMAP_RR);
+
+static const uint64_t S51Chans = (1 << SND_CHMAP_FL) | (1 << SND_CHMAP_FR) | (1 << SND_CHMAP_RL) |
+                                 (1 << SND_CHMAP_RR) | (1 << SND_CHMAP_FC) | (1 << SND_CHMAP_LFE);
+
+static const uint64_t S71Chans = (1 << SND_CHMAP_FL) | (1 << SND_CHMAP_FR) | (1 << SND_CHMAP_RL) |
+                                 (1 << SND_CHMAP_RR) | (1 << SND_CHMAP_FC) | (1 << SND_CHMAP_LFE) |
+                                 (1 << SND_CHMAP_SL) | (1 << SND_CHMAP_SR);
+
+/** Talks to an ALSA PCM directly; mixed samples are written straight into the
+ *  device's mmap ring buffer without an intermediate copy or sound-server hop */
+struct ALSAAudioVoiceEngine : LinuxMidi {
+  snd_pcm_t* m_pcm = nullptr;
+  std::string m_deviceName;
+  unsigned m_requestedChannels;
+  snd_pcm_uframes_t m_bufferFrames = 0;
+
+  /* Interleaved formats attempted in order of preference */
+  static constexpr std::array<std::pair<snd_pcm_format_t, soxr_datatype_t>, 3> Formats = {{
+      {SND_PCM_FORMAT_FLOAT, SOXR_FLOAT32_I},
+      {SND_PCM_FORMAT_S32, SOXR_INT32_I},
+      {SND_PCM_FORMAT_S16, SOXR_INT16_I},
+  }};
+
+  void _closePCM() {
+    if (m_pcm) {
+      snd_pcm_close(m_pcm);
+      m_pcm = nullptr;
+    }
+  }
+
+  void _parseAudioChannelSet(const snd_pcm_chmap_t* chm) {
+    ChannelMap& chmapOut = m_mixInfo.m_channelMap;
+    m_mixInfo.m_channels = AudioChannelSet::Unknown;
+
+    uint64_t chBits = 0;
+    chmapOut.m_channelCount = chm->channels;
+    for (unsigned c = 0; c < chm->channels; ++c) {
+      /* Positions run past 31 (up to SND_CHMAP_LAST); none of the sets matched below use those */
+      if (chm->pos[c] < 64)
+        chBits |= uint64_t(1) << chm->pos[c];
+      switch (chm->pos[c]) {
+      case SND_CHMAP_FL:
+        chmapOut.m_channels[c] = AudioChannel::FrontLeft;
+        break;
+      case SND_CHMAP_FR:
+        chmapOut.m_channels[c] = AudioChannel::FrontRight;
+        break;
+      case SND_CHMAP_RL:
+        chmapOut.m_channels[c] = AudioChannel::RearLeft;
+        break;
+      case SND_CHMAP_RR:
+        chmapOut.m_channels[c] = AudioChannel::RearRight;
+        break;
+      case SND_CHMAP_FC:
+        chmapOut.m_channels[c] = AudioChannel::FrontCenter;
+        break;
+      case SND_CHMAP_LFE:
+        chmapOut.m_channels[c] = AudioChannel::LFE;
+        break;
+      case SND_CHMAP_SL:
+        chmapOut.m_channels[c] = AudioChannel::SideLeft;
+        break;
+      case SND_CHMAP_SR:
+        chmapOut.m_channels[c] = AudioChannel::SideRight;
+        break;
+      default:
+        chmapOut.m_channels[c] = AudioChannel::Unknown;
+        break;
+      }
+    }
+
+    if ((chBits & S71Chans) == S71Chans)
+      m_mixInfo.m_channels = AudioChannelSet::Surround71;
+    else if ((chBits & S51Chans) == S51Chans)
+      m_mixInfo.m_channels = AudioChannelSet::Surround51;
+    else if ((chBits & QuadChans) == QuadChans)
+      m_mixInfo.m_channels = AudioChannelSet::Quad;
+    else if ((chBits & StereoChans) == StereoChans)
+      m_mixInfo.m_channels = AudioChannelSet::Stereo;
+  }
+
+  /* Plugins such as 'null' or 'file' don't report a channel map; assume the
+   * conventional ALSA ordering for the negotiated channel count */
+  void _defaultChannelSet(unsigned chanCount) {
+    ChannelMap& chmapOut = m_mixInfo.m_channelMap;
+    static const std::array<AudioChannel, 8> DefaultOrder = {
+        AudioChannel::FrontLeft,   AudioChannel::FrontRight, AudioChannel::RearLeft, AudioChannel::RearRight,
+        AudioChannel::FrontCenter, AudioChannel::LFE,        AudioChannel::SideLeft, AudioChannel::SideRight};
+    chmapOut.m_channelCount = chanCount;
+    for (unsigned c = 0; c < chanCount; ++c)
+      chmapOut.m_channels[c] = c < DefaultOrder.size() ? DefaultOrder[c] : AudioChannel::Unknown;
+    if (chanCount >= 8)
+      m_mixInfo.m_channels = AudioChannelSet::Surround71;
+    else if (chanCount >= 6)
+      m_mixInfo.m_channels = AudioChannelSet::Surround51;
+    else if (chanCount >= 4)
+      m_mixInfo.m_channels = AudioChannelSet::Quad;
+    else if (chanCount >= 2)
+      m_mixInfo.m_channels = AudioChannelSet::Stereo;
+    else
+      m_mixInfo.m_channels = AudioChannelSet::Unknown;
+  }
+
+  bool _setupPCM() {
+    _closePCM();
+
+    int err;
+    if ((err = snd_pcm_open(&m_pcm, m_deviceName.c_str(), SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK)) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("Unable to snd_pcm_open({}): {}"), m_deviceName, snd_strerror(err));
+      m_pcm = nullptr;
+      return false;
+    }
+
+    snd_pcm_hw_params_t* hwParams;
+    snd_pcm_hw_params_alloca(&hwParams);
+    snd_pcm_hw_params_any(m_pcm, hwParams);
+
+    if ((err = snd_pcm_hw_params_set_access(m_pcm, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("{} does not support mmap interleaved access: {}"), m_deviceName,
+                 snd_strerror(err));
+      _closePCM();
+      return false;
+    }
+
+    snd_pcm_format_t pcmFormat = SND_PCM_FORMAT_UNKNOWN;
+    for (const auto& [fmt, soxrFmt] : Formats) {
+      if (!snd_pcm_hw_params_test_format(m_pcm, hwParams, fmt)) {
+        pcmFormat = fmt;
+        m_mixInfo.m_sampleFormat = soxrFmt;
+        m_mixInfo.m_bitsPerSample = snd_pcm_format_physical_width(fmt);
+        break;
+      }
+    }
+    if (pcmFormat == SND_PCM_FORMAT_UNKNOWN || snd_pcm_hw_params_set_format(m_pcm, hwParams, pcmFormat) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("{} supports none of float, S32 or S16 sample formats"), m_deviceName);
+      _closePCM();
+      return false;
+    }
+
+    unsigned chanCount = m_requestedChannels;
+    unsigned rate = 48000;
+    if (snd_pcm_hw_params_set_channels_near(m_pcm, hwParams, &chanCount) < 0 ||
+        snd_pcm_hw_params_set_rate_near(m_pcm, hwParams, &rate, nullptr) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("Unable to negotiate channels/rate for {}"), m_deviceName);
+      _closePCM();
+      return false;
+    }
+
+    /* Period tracks the 5ms mix interval; keep a few periods queued to ride out scheduling jitter */
+    snd_pcm_uframes_t periodFrames = rate * 5 / 1000;
+    snd_pcm_hw_params_set_period_size_near(m_pcm, hwParams, &periodFrames, nullptr);
+    m_bufferFrames = periodFrames * 4;
+    snd_pcm_hw_params_set_buffer_size_near(m_pcm, hwParams, &m_bufferFrames);
+
+    if ((err = snd_pcm_hw_params(m_pcm, hwParams)) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("Unable to snd_pcm_hw_params(): {}"), snd_strerror(err));
+      _closePCM();
+      return false;
+    }
+    snd_pcm_hw_params_get_period_size(hwParams, &periodFrames, nullptr);
+    snd_pcm_hw_params_get_buffer_size(hwParams, &m_bufferFrames);
+
+    snd_pcm_sw_params_t* swParams;
+    snd_pcm_sw_params_alloca(&swParams);
+    snd_pcm_sw_params_current(m_pcm, swParams);
+    snd_pcm_sw_params_set_avail_min(m_pcm, swParams, periodFrames);
+    snd_pcm_sw_params_set_start_threshold(m_pcm, swParams, m_bufferFrames - m_bufferFrames % periodFrames);
+    if ((err = snd_pcm_sw_params(m_pcm, swParams)) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("Unable to snd_pcm_sw_params(): {}"), snd_strerror(err));
+      _closePCM();
+      return false;
+    }
+
+    if (snd_pcm_chmap_t* chm = snd_pcm_get_chmap(m_pcm)) {
+      _parseAudioChannelSet(chm);
+      free(chm);
+    } else {
+      _defaultChannelSet(chanCount);
+    }
+
+    m_5msFrames = rate * 5 / 1000;
+    m_mixInfo.m_sampleRate = rate;
+    m_mixInfo.m_periodFrames = periodFrames;
+
+    Log.report(logvisor::Info, FMT_STRING("Opened {}: {} Hz, {} channels, {}-bit, {} frame period"), m_deviceName, rate,
+               chanCount, m_mixInfo.m_bitsPerSample, periodFrames);
+
+    _resetSampleRate();
+    return true;
+  }
+
+  ALSAAudioVoiceEngine(const char* device, unsigned numChans) : m_deviceName(device), m_requestedChannels(numChans) {
+    _setupPCM();
+  }
+
+  ~ALSAAudioVoiceEngine() override { _closePCM(); }
+
+  std::vector<std::pair<std::string, std::string>> enumerateAudioOutputs() const override {
+    std::vector<std::pair<std::string, std::string>> ret;
+    void** hints;
+    if (snd_device_name_hint(-1, "pcm", &hints) < 0)
+      return ret;
+
+    for (void** h = hints; *h; ++h) {
+      char* name = snd_device_name_get_hint(*h, "NAME");
+      char* desc = snd_device_name_get_hint(*h, "DESC");
+      char* ioid = snd_device_name_get_hint(*h, "IOID");
+      /* A null IOID means the PCM is bidirectional */
+      if (name && (!ioid || !strcmp(ioid, "Output")))
+        ret.emplace_back(name, desc ? desc : name);
+      free(name);
+      free(desc);
+      free(ioid);
+    }
+
+    snd_device_name_free_hint(hints);
+    return ret;
+  }
+
+  std::string getCurrentAudioOutput() const override { return m_deviceName; }
+
+  bool setCurrentAudioOutput(const char* name) override {
+    std::string oldName = std::move(m_deviceName);
+    m_deviceName = name;
+    if (_setupPCM())
+      return true;
+    m_deviceName = std::move(oldName);
+    _setupPCM();
+    return false;
+  }
+
+  bool _recover(int err) {
+    if ((err = snd_pcm_recover(m_pcm, err, 1)) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("Unable to recover PCM: {}"), snd_strerror(err));
+      return false;
+    }
+    return true;
+  }
+
+  template <typename T>
+  void _pumpMmap(snd_pcm_uframes_t frames) {
+    while (frames) {
+      const snd_pcm_channel_area_t* areas;
+      snd_pcm_uframes_t offset;
+      snd_pcm_uframes_t mapFrames = frames;
+      int err;
+      if ((err = snd_pcm_mmap_begin(m_pcm, &areas, &offset, &mapFrames)) < 0) {
+        _recover(err);
+        return;
+      }
+
+      /* Interleaved access: every channel shares area 0's base address and stride */
+      T* data = reinterpret_cast<T*>(static_cast<uint8_t*>(areas[0].addr) + areas[0].first / 8 +
+                                     offset * (areas[0].step / 8));
+      _pumpAndMixVoices(mapFrames, data);
+
+      snd_pcm_sframes_t committed = snd_pcm_mmap_commit(m_pcm, offset, mapFrames);
+      if (committed < 0 || snd_pcm_uframes_t(committed) != mapFrames) {
+        _recover(committed >= 0 ? -EPIPE : int(committed));
+        return;
+      }
+      frames -= mapFrames;
+    }
+  }
+
+  void pumpAndMixVoices() override {
+    if (!m_pcm) {
+      /* Dummy pump mode - use failsafe defaults for 1/60sec of samples */
+      m_mixInfo.m_sampleRate = 32000.0;
+      m_mixInfo.m_sampleFormat = SOXR_FLOAT32_I;
+      m_mixInfo.m_bitsPerSample = 32;
+      m_5msFrames = 32000 / 60;
+      m_mixInfo.m_periodFrames = m_5msFrames;
+      m_mixInfo.m_channels = AudioChannelSet::Stereo;
+      m_mixInfo.m_channelMap.m_channelCount = 2;
+      m_mixInfo.m_channelMap.m_channels[0] = AudioChannel::FrontLeft;
+      m_mixInfo.m_channelMap.m_channels[1] = AudioChannel::FrontRight;
+      _pumpAndMixVoices(m_5msFrames, (float*)nullptr);
+      return;
+    }
+
+    snd_pcm_sframes_t avail = snd_pcm_avail_update(m_pcm);
+    if (avail < 0) {
+      _recover(int(avail));
+      return;
+    }
+
+    /* Only mix whole periods so every 5ms interval lands in one contiguous write */
+    snd_pcm_uframes_t frames = snd_pcm_uframes_t(avail) / m_mixInfo.m_periodFrames * m_mixInfo.m_periodFrames;
+    if (!frames) {
+      /* The PCM is non-blocking; block here until a period frees up (avail_min) so client
+       * pump loops do not spin. Time out after a few periods in case the device stalls. */
+      int timeoutMs = int(4000 * m_mixInfo.m_periodFrames / m_mixInfo.m_sampleRate) + 1;
+      int err = snd_pcm_wait(m_pcm, timeoutMs);
+      if (err < 0) {
+        _recover(err);
+        return;
+      }
+      if (err == 0)
+        return;
+      if ((avail = snd_pcm_avail_update(m_pcm)) < 0) {
+        _recover(int(avail));
+        return;
+      }
+      frames = snd_pcm_uframes_t(avail) / m_mixInfo.m_periodFrames * m_mixInfo.m_periodFrames;
+      if (!frames)
+        return;
+    }
+
+    switch (m_mixInfo.m_sampleFormat) {
+    case SOXR_INT16_I:
+      _pumpMmap<int16_t>(frames);
+      break;
+    case SOXR_INT32_I:
+      _pumpMmap<int32_t>(frames);
+      break;
+    default:
+      _pumpMmap<float>(frames);
+      break;
+    }
+  }
+};
+
+std::unique_ptr<IAudioVoiceEngine> NewALSAAudioVoiceEngine(const char* device, int numChans) {
+  auto ret = std::make_unique<ALSAAudioVoiceEngine>(device, unsigned(numChans));
+  if (!ret->m_pcm)
+    return {};
+  return ret;
+}
+
+} // namespace boo
@@ -322,8 +322,8 @@ struct AQSAudioVoiceEngine : BaseAudioVoiceEngine {
   static void MIDIReceiveProc(const MIDIPacketList* pktlist, IMIDIReceiver* readProcRefCon, void*) {
     const MIDIPacket* packet = &pktlist->packet[0];
     for (int i = 0; i < pktlist->numPackets; ++i) {
-      std::vector<uint8_t> bytes(std::cbegin(packet->data), std::cbegin(packet->data) + packet->length);
-      readProcRefCon->m_receiver(std::move(bytes), AudioConvertHostTimeToNanos(packet->timeStamp) / 1.0e9);
+      readProcRefCon->m_receiver(packet->data, packet->length,
+                                 AudioConvertHostTimeToNanos(packet->timeStamp) / 1.0e9);
       packet = MIDIPacketNext(packet);
     }
   }
@@ -863,4 +863,11 @@ std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine() {
   return ret;
 }
 
+std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine(const char* outputName) {
+  auto ret = NewAudioVoiceEngine();
+  if (!ret || !ret->setCurrentAudioOutput(outputName))
+    return {};
+  return ret;
+}
+
 } // namespace boo
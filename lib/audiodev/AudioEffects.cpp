@@ -0,0 +1,580 @@
+#include "boo/audiodev/AudioEffects.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if __SSE__
+#include <immintrin.h>
+#endif
+
+#undef min
+#undef max
+
+namespace boo {
+
+static constexpr float Pi = 3.14159265358979323846f;
+
+/* Four channel lanes (or four delay lines) of one frame */
+#if __SSE__
+struct F4 {
+  __m128 v;
+};
+static inline F4 Load(const float* p) { return {_mm_load_ps(p)}; }
+static inline F4 LoadU(const float* p) { return {_mm_loadu_ps(p)}; }
+static inline void Store(float* p, F4 a) { _mm_store_ps(p, a.v); }
+static inline void StoreU(float* p, F4 a) { _mm_storeu_ps(p, a.v); }
+static inline F4 Splat(float s) { return {_mm_set1_ps(s)}; }
+static inline F4 operator+(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+static inline F4 operator-(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+static inline F4 operator*(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+static inline F4 Max(F4 a, F4 b) { return {_mm_max_ps(a.v, b.v)}; }
+static inline F4 Abs(F4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.f), a.v)}; }
+static inline float HMax(F4 a) {
+  __m128 m = _mm_max_ps(a.v, _mm_movehl_ps(a.v, a.v));
+  return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+}
+/* Unnormalized 4x4 Walsh-Hadamard transform */
+static inline F4 Hadamard(F4 a) {
+  __m128 sw = _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 b = _mm_add_ps(_mm_mul_ps(a.v, _mm_set_ps(-1.f, 1.f, -1.f, 1.f)), sw);
+  __m128 sw2 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2));
+  return {_mm_add_ps(_mm_mul_ps(b, _mm_set_ps(-1.f, -1.f, 1.f, 1.f)), sw2)};
+}
+#else
+struct F4 {
+  float v[4];
+};
+static inline F4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+static inline F4 LoadU(const float* p) { return Load(p); }
+static inline void Store(float* p, F4 a) { std::copy(a.v, a.v + 4, p); }
+static inline void StoreU(float* p, F4 a) { Store(p, a); }
+static inline F4 Splat(float s) { return {{s, s, s, s}}; }
+static inline F4 operator+(F4 a, F4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+static inline F4 operator-(F4 a, F4 b) { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+static inline F4 operator*(F4 a, F4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+static inline F4 Max(F4 a, F4 b) {
+  return {{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}};
+}
+static inline F4 Abs(F4 a) { return {{std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]), std::fabs(a.v[3])}}; }
+static inline float HMax(F4 a) { return std::max(std::max(a.v[0], a.v[1]), std::max(a.v[2], a.v[3])); }
+static inline F4 Hadamard(F4 a) {
+  float b0 = a.v[0] + a.v[1], b1 = a.v[0] - a.v[1], b2 = a.v[2] + a.v[3], b3 = a.v[2] - a.v[3];
+  return {{b0 + b2, b1 + b3, b0 - b2, b1 - b3}};
+}
+#endif
+
+bool AudioEffectParam::_smooth(float coef) {
+  float target = get();
+  if (m_cur == target)
+    return false;
+  m_cur += (target - m_cur) * coef;
+  if (std::fabs(target - m_cur) <= 1e-5f * std::max(1.f, std::fabs(target)))
+    m_cur = target;
+  return true;
+}
+
+AudioEffect::AudioEffect(AudioChannelSet set, double maxSampleRate)
+: m_channels(std::clamp(ChannelCount(set), 1u, MaxChannels))
+, m_stride((m_channels + 3) & ~3u)
+, m_maxSampleRate(maxSampleRate) {
+  std::fill(std::begin(m_block), std::end(m_block), 0.f);
+}
+
+void AudioEffect::setBypass(bool bypass) {
+  if (!bypass && m_bypass.load(std::memory_order_relaxed))
+    m_resetPending.store(true, std::memory_order_relaxed);
+  m_bypass.store(bypass, std::memory_order_release);
+}
+
+void AudioEffect::_updateSampleRate(double sampleRate) {
+  m_sampleRate = sampleRate;
+  float smoothTime = std::max(m_smoothTime.load(std::memory_order_relaxed), 1e-4f);
+  m_smoothCoef = float(1.0 - std::exp(-double(ControlFrames) / (smoothTime * sampleRate)));
+  _setSampleRate(sampleRate);
+}
+
+void AudioEffect::resetOutputSampleRate(double sampleRate) { _updateSampleRate(sampleRate); }
+
+void AudioEffect::_run(float* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) {
+  if (sampleRate != m_sampleRate)
+    _updateSampleRate(sampleRate);
+  if (m_resetPending.exchange(false, std::memory_order_acquire))
+    _reset();
+
+  /* Recursive filters decay into denormals; flush them for the duration of the call */
+#if __SSE__
+  unsigned csr = _mm_getcsr();
+  _mm_setcsr(csr | 0x8040);
+#endif
+
+  unsigned inStride = chanMap.m_channelCount;
+  unsigned chans = std::min(inStride, m_channels);
+  for (size_t f = 0; f < frameCount;) {
+    size_t frames = std::min(ControlFrames, frameCount - f);
+    float* in = audio + f * inStride;
+    for (size_t i = 0; i < frames; ++i) {
+      for (unsigned c = 0; c < chans; ++c)
+        m_block[i * m_stride + c] = in[i * inStride + c];
+      for (unsigned c = chans; c < m_stride; ++c)
+        m_block[i * m_stride + c] = 0.f;
+    }
+    _process(m_block, frames);
+    for (size_t i = 0; i < frames; ++i)
+      for (unsigned c = 0; c < chans; ++c)
+        in[i * inStride + c] = m_block[i * m_stride + c];
+    f += frames;
+  }
+
+#if __SSE__
+  _mm_setcsr(csr);
+#endif
+}
+
+/* applyEffect() is const in the callback interface; effect state is owned by the mixing thread */
+void AudioEffect::applyEffect(float* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const {
+  const_cast<AudioEffect*>(this)->_run(audio, frameCount, chanMap, sampleRate);
+}
+
+/* Linearly interpolated read of a frame-interleaved ring buffer, delay in frames (>= 1) */
+static inline F4 ReadDelayed(const float* buf, size_t capacity, unsigned stride, size_t write, float delay,
+                             unsigned lane) {
+  double pos = double(write) - delay;
+  if (pos < 0.0)
+    pos += double(capacity);
+  size_t i0 = size_t(pos);
+  float t = float(pos - double(i0));
+  if (i0 >= capacity)
+    i0 -= capacity;
+  size_t i1 = i0 + 1 == capacity ? 0 : i0 + 1;
+  F4 a = LoadU(buf + i0 * stride + lane);
+  F4 b = LoadU(buf + i1 * stride + lane);
+  return a + (b - a) * Splat(t);
+}
+
+/* Biquad */
+
+AudioEffectBiquad::AudioEffectBiquad(AudioChannelSet set, Type type, float frequency, float q, float gainDb,
+                                     double maxSampleRate)
+: AudioEffect(set, maxSampleRate)
+, m_type(type)
+, m_curType(type)
+, m_frequency(frequency)
+, m_q(q)
+, m_gainDb(gainDb) {}
+
+void AudioEffectBiquad::_reset() {
+  std::fill(std::begin(m_z1), std::end(m_z1), 0.f);
+  std::fill(std::begin(m_z2), std::end(m_z2), 0.f);
+  m_frequency._snap();
+  m_q._snap();
+  m_gainDb._snap();
+  m_dirty = true;
+}
+
+void AudioEffectBiquad::_setSampleRate(double) { m_dirty = true; }
+
+void AudioEffectBiquad::_computeCoefs() {
+  double nyquist = m_sampleRate * 0.5;
+  double freq = std::clamp(double(m_frequency._value()), 1.0, nyquist * 0.99);
+  double w0 = 2.0 * Pi * freq / m_sampleRate;
+  double cosw = std::cos(w0);
+  double alpha = std::sin(w0) / (2.0 * std::max(double(m_q._value()), 0.01));
+  double A = std::pow(10.0, m_gainDb._value() / 40.0);
+  double b0, b1, b2, a0, a1, a2;
+
+  switch (m_curType) {
+  case Type::LowPass:
+    b1 = 1.0 - cosw;
+    b0 = b2 = b1 * 0.5;
+    a0 = 1.0 + alpha, a1 = -2.0 * cosw, a2 = 1.0 - alpha;
+    break;
+  case Type::HighPass:
+    b1 = -(1.0 + cosw);
+    b0 = b2 = -b1 * 0.5;
+    a0 = 1.0 + alpha, a1 = -2.0 * cosw, a2 = 1.0 - alpha;
+    break;
+  case Type::BandPass:
+    b0 = alpha, b1 = 0.0, b2 = -alpha;
+    a0 = 1.0 + alpha, a1 = -2.0 * cosw, a2 = 1.0 - alpha;
+    break;
+  case Type::Notch:
+    b0 = 1.0, b1 = -2.0 * cosw, b2 = 1.0;
+    a0 = 1.0 + alpha, a1 = -2.0 * cosw, a2 = 1.0 - alpha;
+    break;
+  case Type::Peaking:
+    b0 = 1.0 + alpha * A, b1 = -2.0 * cosw, b2 = 1.0 - alpha * A;
+    a0 = 1.0 + alpha / A, a1 = -2.0 * cosw, a2 = 1.0 - alpha / A;
+    break;
+  case Type::LowShelf: {
+    double sq = 2.0 * std::sqrt(A) * alpha;
+    b0 = A * ((A + 1.0) - (A - 1.0) * cosw + sq);
+    b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw);
+    b2 = A * ((A + 1.0) - (A - 1.0) * cosw - sq);
+    a0 = (A + 1.0) + (A - 1.0) * cosw + sq;
+    a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosw);
+    a2 = (A + 1.0) + (A - 1.0) * cosw - sq;
+    break;
+  }
+  case Type::HighShelf:
+  default: {
+    double sq = 2.0 * std::sqrt(A) * alpha;
+    b0 = A * ((A + 1.0) + (A - 1.0) * cosw + sq);
+    b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw);
+    b2 = A * ((A + 1.0) + (A - 1.0) * cosw - sq);
+    a0 = (A + 1.0) - (A - 1.0) * cosw + sq;
+    a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosw);
+    a2 = (A + 1.0) - (A - 1.0) * cosw - sq;
+    break;
+  }
+  }
+
+  m_b0 = float(b0 / a0);
+  m_b1 = float(b1 / a0);
+  m_b2 = float(b2 / a0);
+  m_a1 = float(a1 / a0);
+  m_a2 = float(a2 / a0);
+}
+
+void AudioEffectBiquad::_process(float* block, size_t frames) {
+  Type type = m_type.load(std::memory_order_relaxed);
+  if (type != m_curType) {
+    m_curType = type;
+    m_dirty = true;
+  }
+  bool moved = m_frequency._smooth(m_smoothCoef);
+  moved |= m_q._smooth(m_smoothCoef);
+  moved |= m_gainDb._smooth(m_smoothCoef);
+  if (moved || m_dirty) {
+    _computeCoefs();
+    m_dirty = false;
+  }
+
+  /* Transposed direct form II, all channel lanes at once */
+  const F4 b0 = Splat(m_b0), b1 = Splat(m_b1), b2 = Splat(m_b2), a1 = Splat(m_a1), a2 = Splat(m_a2);
+  for (unsigned g = 0; g < m_stride; g += 4) {
+    F4 z1 = Load(m_z1 + g), z2 = Load(m_z2 + g);
+    float* x = block + g;
+    for (size_t f = 0; f < frames; ++f, x += m_stride) {
+      F4 in = Load(x);
+      F4 out = b0 * in + z1;
+      z1 = b1 * in - a1 * out + z2;
+      z2 = b2 * in - a2 * out;
+      Store(x, out);
+    }
+    Store(m_z1 + g, z1);
+    Store(m_z2 + g, z2);
+  }
+}
+
+/* Delay */
+
+AudioEffectDelay::AudioEffectDelay(AudioChannelSet set, float maxSeconds, float seconds, float feedback, float mix,
+                                   double maxSampleRate)
+: AudioEffect(set, maxSampleRate)
+, m_capacity(size_t(std::ceil(std::max(maxSeconds, 0.f) * maxSampleRate)) + 2)
+, m_time(seconds)
+, m_feedback(feedback)
+, m_mix(mix) {
+  m_buffer.resize(m_capacity * m_stride);
+}
+
+void AudioEffectDelay::_reset() {
+  std::fill(m_buffer.begin(), m_buffer.end(), 0.f);
+  m_write = 0;
+  m_time._snap();
+  m_feedback._snap();
+  m_mix._snap();
+  m_curDelay = std::clamp(float(m_time._value() * m_sampleRate), 1.f, float(m_capacity - 2));
+}
+
+void AudioEffectDelay::_setSampleRate(double sampleRate) {
+  m_curDelay = std::clamp(float(m_time._value() * sampleRate), 1.f, float(m_capacity - 2));
+}
+
+void AudioEffectDelay::_process(float* block, size_t frames) {
+  float mix0 = m_mix._value();
+  m_time._smooth(m_smoothCoef);
+  m_feedback._smooth(m_smoothCoef);
+  m_mix._smooth(m_smoothCoef);
+
+  /* Delay time and wet level ramp across the block so modulation does not step */
+  float delay = m_curDelay;
+  float target = std::clamp(float(m_time._value() * m_sampleRate), 1.f, float(m_capacity - 2));
+  float delayStep = (target - delay) / float(frames);
+  float mix = mix0, mixStep = (m_mix._value() - mix0) / float(frames);
+  const F4 fb = Splat(std::clamp(m_feedback._value(), -0.99f, 0.99f));
+
+  float* x = block;
+  for (size_t f = 0; f < frames; ++f, x += m_stride) {
+    delay += delayStep;
+    mix += mixStep;
+    const F4 mixV = Splat(mix);
+    float* w = m_buffer.data() + m_write * m_stride;
+    for (unsigned g = 0; g < m_stride; g += 4) {
+      F4 in = Load(x + g);
+      F4 wet = ReadDelayed(m_buffer.data(), m_capacity, m_stride, m_write, delay, g);
+      StoreU(w + g, in + wet * fb);
+      Store(x + g, in + (wet - in) * mixV);
+    }
+    if (++m_write == m_capacity)
+      m_write = 0;
+  }
+  m_curDelay = target;
+}
+
+/* Chorus */
+
+AudioEffectChorus::AudioEffectChorus(AudioChannelSet set, float delaySeconds, float depthSeconds, float rateHz,
+                                     float mix, double maxSampleRate)
+: AudioEffect(set, maxSampleRate)
+, m_capacity(size_t(std::ceil(MaxDelaySeconds * maxSampleRate)) + 2)
+, m_delay(delaySeconds)
+, m_depth(depthSeconds)
+, m_rate(rateHz)
+, m_mix(mix) {
+  m_buffer.resize(m_capacity * m_stride);
+}
+
+void AudioEffectChorus::_reset() {
+  std::fill(m_buffer.begin(), m_buffer.end(), 0.f);
+  m_write = 0;
+  m_lfoPhase = 0.0;
+  m_delay._snap();
+  m_depth._snap();
+  m_rate._snap();
+  m_mix._snap();
+  _setSampleRate(m_sampleRate);
+}
+
+void AudioEffectChorus::_setSampleRate(double sampleRate) {
+  float maxDelay = float(m_capacity - 2);
+  for (unsigned c = 0; c < MaxChannels; ++c)
+    m_curDelay[c] = std::clamp(float(m_delay._value() * sampleRate), 1.f, maxDelay);
+}
+
+void AudioEffectChorus::_process(float* block, size_t frames) {
+  float mix0 = m_mix._value();
+  m_delay._smooth(m_smoothCoef);
+  m_depth._smooth(m_smoothCoef);
+  m_rate._smooth(m_smoothCoef);
+  m_mix._smooth(m_smoothCoef);
+
+  /* The LFO is evaluated at block boundaries and each lane's delay ramps linearly between */
+  m_lfoPhase += m_rate._value() * double(frames) / m_sampleRate;
+  m_lfoPhase -= std::floor(m_lfoPhase);
+  float maxDelay = float(m_capacity - 2);
+  float depth = m_depth._value();
+  float base = std::min(m_delay._value(), MaxDelaySeconds - depth);
+  alignas(16) float delay[MaxChannels];
+  alignas(16) float delayStep[MaxChannels];
+  for (unsigned c = 0; c < m_stride; ++c) {
+    float lfo = 0.5f + 0.5f * std::sin(2.f * Pi * float(m_lfoPhase + 0.25 * c));
+    float target = std::clamp(float((base + depth * lfo) * m_sampleRate), 1.f, maxDelay);
+    delay[c] = m_curDelay[c];
+    delayStep[c] = (target - delay[c]) / float(frames);
+    m_curDelay[c] = target;
+  }
+
+  float mix = mix0, mixStep = (m_mix._value() - mix0) / float(frames);
+  const float* buf = m_buffer.data();
+  float* x = block;
+  for (size_t f = 0; f < frames; ++f, x += m_stride) {
+    mix += mixStep;
+    const F4 mixV = Splat(mix);
+    float* w = m_buffer.data() + m_write * m_stride;
+    for (unsigned g = 0; g < m_stride; g += 4) {
+      /* Each lane reads at its own position; gather then interpolate together */
+      alignas(16) float a[4], b[4], t[4];
+      for (unsigned l = 0; l < 4; ++l) {
+        unsigned c = g + l;
+        delay[c] += delayStep[c];
+        double pos = double(m_write) - delay[c];
+        if (pos < 0.0)
+          pos += double(m_capacity);
+        size_t i0 = size_t(pos);
+        t[l] = float(pos - double(i0));
+        if (i0 >= m_capacity)
+          i0 -= m_capacity;
+        size_t i1 = i0 + 1 == m_capacity ? 0 : i0 + 1;
+        a[l] = buf[i0 * m_stride + c];
+        b[l] = buf[i1 * m_stride + c];
+      }
+      F4 av = Load(a);
+      F4 wet = av + (Load(b) - av) * Load(t);
+      F4 in = Load(x + g);
+      StoreU(w + g, in);
+      Store(x + g, in + (wet - in) * mixV);
+    }
+    if (++m_write == m_capacity)
+      m_write = 0;
+  }
+}
+
+/* Reverb */
+
+/* Mutually prime-ish line lengths in ms; each further channel is stretched a little so
+ * the channels decorrelate */
+static constexpr float ReverbLineMs[] = {29.7f, 37.1f, 41.1f, 43.7f};
+static constexpr float ReverbChannelSpread = 0.023f;
+static constexpr float ReverbInputGain = 0.35f;
+
+/* Alternate output taps give neighbouring channels uncorrelated tails */
+alignas(16) static constexpr float ReverbTapSigns[2][4] = {{0.5f, 0.5f, 0.5f, 0.5f}, {0.5f, -0.5f, 0.5f, -0.5f}};
+
+AudioEffectReverb::AudioEffectReverb(AudioChannelSet set, float decaySeconds, float damping, float mix,
+                                     double maxSampleRate)
+: AudioEffect(set, maxSampleRate), m_decay(decaySeconds), m_damping(damping), m_mix(mix) {
+  size_t offset = 0;
+  for (unsigned c = 0; c < MaxChannels; ++c) {
+    for (unsigned l = 0; l < Lines; ++l) {
+      double ms = ReverbLineMs[l] * (1.0 + ReverbChannelSpread * c);
+      m_lineOffset[c][l] = offset;
+      m_lineCapacity[c][l] = c < m_channels ? size_t(std::ceil(ms * maxSampleRate / 1000.0)) + 1 : 1;
+      m_lineLength[c][l] = m_lineCapacity[c][l];
+      offset += m_lineCapacity[c][l];
+    }
+  }
+  m_buffer.resize(offset);
+}
+
+void AudioEffectReverb::_reset() {
+  std::fill(m_buffer.begin(), m_buffer.end(), 0.f);
+  for (unsigned c = 0; c < MaxChannels; ++c)
+    for (unsigned l = 0; l < Lines; ++l)
+      m_linePos[c][l] = 0, m_damp[c][l] = 0.f;
+  m_decay._snap();
+  m_damping._snap();
+  m_mix._snap();
+  m_dirty = true;
+}
+
+void AudioEffectReverb::_setSampleRate(double sampleRate) {
+  for (unsigned c = 0; c < m_channels; ++c) {
+    for (unsigned l = 0; l < Lines; ++l) {
+      double ms = ReverbLineMs[l] * (1.0 + ReverbChannelSpread * c);
+      m_lineLength[c][l] = std::clamp(size_t(ms * sampleRate / 1000.0), size_t(1), m_lineCapacity[c][l]);
+      m_linePos[c][l] %= m_lineLength[c][l];
+    }
+  }
+  m_dirty = true;
+}
+
+void AudioEffectReverb::_computeGains() {
+  /* Each pass through a line must lose (length / RT60) * 60dB */
+  double decay = std::max(double(m_decay._value()), 0.01);
+  for (unsigned c = 0; c < m_channels; ++c)
+    for (unsigned l = 0; l < Lines; ++l)
+      m_lineGain[c][l] = float(std::pow(10.0, -3.0 * double(m_lineLength[c][l]) / (m_sampleRate * decay)));
+}
+
+void AudioEffectReverb::_process(float* block, size_t frames) {
+  float mix0 = m_mix._value();
+  if (m_decay._smooth(m_smoothCoef) || m_dirty) {
+    _computeGains();
+    m_dirty = false;
+  }
+  m_damping._smooth(m_smoothCoef);
+  m_mix._smooth(m_smoothCoef);
+  float mixStep = (m_mix._value() - mix0) / float(frames);
+
+  /* Damping is a one-pole lowpass inside each line's feedback path */
+  const F4 dampCoef = Splat(1.f - 0.85f * std::clamp(m_damping._value(), 0.f, 1.f));
+  const F4 half = Splat(0.5f);
+  for (unsigned c = 0; c < m_channels; ++c) {
+    const F4 taps = Load(ReverbTapSigns[c & 1]);
+    const F4 gain = Load(m_lineGain[c]);
+    F4 damp = Load(m_damp[c]);
+    float* lines[Lines];
+    for (unsigned l = 0; l < Lines; ++l)
+      lines[l] = m_buffer.data() + m_lineOffset[c][l];
+    size_t* pos = m_linePos[c];
+    const size_t* len = m_lineLength[c];
+
+    float mix = mix0;
+    float* x = block + c;
+    for (size_t f = 0; f < frames; ++f, x += m_stride) {
+      mix += mixStep;
+      alignas(16) float out[Lines] = {lines[0][pos[0]], lines[1][pos[1]], lines[2][pos[2]], lines[3][pos[3]]};
+      F4 v = Load(out);
+      damp = damp + (v - damp) * dampCoef;
+      F4 fb = Hadamard(damp) * half * gain + Splat(*x * ReverbInputGain);
+      alignas(16) float in[Lines];
+      Store(in, fb);
+      alignas(16) float tap[Lines];
+      Store(tap, v * taps);
+      for (unsigned l = 0; l < Lines; ++l) {
+        lines[l][pos[l]] = in[l];
+        if (++pos[l] == len[l])
+          pos[l] = 0;
+      }
+      float wet = (tap[0] + tap[1]) + (tap[2] + tap[3]);
+      *x += (wet - *x) * mix;
+    }
+    Store(m_damp[c], damp);
+  }
+}
+
+/* Compressor */
+
+AudioEffectCompressor::AudioEffectCompressor(AudioChannelSet set, float thresholdDb, float ratio, float attackSeconds,
+                                             float releaseSeconds, float makeupDb, double maxSampleRate)
+: AudioEffect(set, maxSampleRate)
+, m_threshold(thresholdDb)
+, m_ratio(ratio)
+, m_attack(attackSeconds)
+, m_release(releaseSeconds)
+, m_makeup(makeupDb) {}
+
+void AudioEffectCompressor::_reset() {
+  m_threshold._snap();
+  m_ratio._snap();
+  m_attack._snap();
+  m_release._snap();
+  m_makeup._snap();
+  m_env = 0.f;
+  m_gain = std::pow(10.f, m_makeup._value() / 20.f);
+  m_gainReduction.store(0.f, std::memory_order_relaxed);
+}
+
+void AudioEffectCompressor::_setSampleRate(double) {}
+
+void AudioEffectCompressor::_process(float* block, size_t frames) {
+  m_threshold._smooth(m_smoothCoef);
+  m_ratio._smooth(m_smoothCoef);
+  m_attack._smooth(m_smoothCoef);
+  m_release._smooth(m_smoothCoef);
+  m_makeup._smooth(m_smoothCoef);
+  float att = 1.f - std::exp(-1.f / (std::max(m_attack._value(), 1e-5f) * float(m_sampleRate)));
+  float rel = 1.f - std::exp(-1.f / (std::max(m_release._value(), 1e-5f) * float(m_sampleRate)));
+
+  /* Linked peak detector; the envelope runs per frame */
+  float env = m_env;
+  const float* x = block;
+  for (size_t f = 0; f < frames; ++f, x += m_stride) {
+    F4 peak = Abs(Load(x));
+    for (unsigned g = 4; g < m_stride; g += 4)
+      peak = Max(peak, Abs(Load(x + g)));
+    float p = HMax(peak);
+    env += (p - env) * (p > env ? att : rel);
+  }
+  m_env = env;
+
+  /* Gain is computed once per block and ramped across it */
+  float envDb = 20.f * std::log10(std::max(env, 1e-9f));
+  float over = envDb - m_threshold._value();
+  float reduction = over > 0.f ? over * (1.f - 1.f / std::max(m_ratio._value(), 1.f)) : 0.f;
+  m_gainReduction.store(reduction, std::memory_order_relaxed);
+  float target = std::pow(10.f, (m_makeup._value() - reduction) / 20.f);
+  float gain = m_gain, step = (target - gain) / float(frames);
+
+  float* y = block;
+  for (size_t f = 0; f < frames; ++f, y += m_stride) {
+    gain += step;
+    const F4 gainV = Splat(gain);
+    for (unsigned g = 0; g < m_stride; g += 4)
+      Store(y + g, Load(y + g) * gainV);
+  }
+  m_gain = target;
+}
+
+} // namespace boo
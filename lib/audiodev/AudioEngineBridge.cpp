@@ -0,0 +1,109 @@
+#include "boo/audiodev/AudioEngineBridge.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace boo {
+
+/* Largest correction applied to the rate ratio; real device clocks differ by far less */
+static constexpr double MaxDriftCorrection = 0.005;
+
+/* Smoothing applied per destination interval to the fill-level error */
+static constexpr double FillErrorSmoothing = 0.01;
+
+/* Fill level (in multiples of the target) beyond which queued audio is dropped to catch up */
+static constexpr size_t ResyncFactor = 3;
+
+static inline int16_t ConvertSample(float in) {
+  return int16_t(std::lrint(std::clamp(in * 32768.f, -32768.f, 32767.f)));
+}
+
+AudioEngineBridge::AudioEngineBridge(ObjToken<IAudioSubmixTap> sourceTap, double sourceRate, IAudioVoiceEngine& dest,
+                                     double latencyMs, AudioResamplerType resampler)
+: m_tap(std::move(sourceTap)), m_targetFrames(std::max(size_t(1), size_t(sourceRate * latencyMs / 1000.0))) {
+  if (!m_tap)
+    return;
+  m_voice = dest.allocateNewStereoVoice(sourceRate, this, true, resampler);
+  if (m_voice)
+    m_voice->start();
+}
+
+AudioEngineBridge::~AudioEngineBridge() {
+  if (m_voice)
+    m_voice->stop();
+}
+
+size_t AudioEngineBridge::_queuedFrames() {
+  if (const AudioTapBlock* block = m_tap->peekBlock())
+    m_blockFrames = block->m_frames;
+  size_t queued = m_tap->getQueuedBlockCount() * m_blockFrames;
+  return queued > m_blockOffset ? queued - m_blockOffset : 0;
+}
+
+void AudioEngineBridge::preSupplyAudio(IAudioVoice& voice, double dt) {
+  size_t fill = _queuedFrames();
+
+  if (!m_primed) {
+    if (fill < m_targetFrames)
+      return;
+    m_primed = true;
+    m_fillError = 0.0;
+  }
+
+  /* The destination stalled or started late; skip ahead instead of carrying the extra latency */
+  if (fill > m_targetFrames * ResyncFactor) {
+    while (fill > m_targetFrames && m_tap->peekBlock()) {
+      m_tap->popBlock();
+      m_blockOffset = 0;
+      fill = _queuedFrames();
+    }
+  }
+
+  /* Consume slightly faster when the source clock runs ahead, slower when it lags */
+  double error = (double(fill) - double(m_targetFrames)) / double(m_targetFrames);
+  m_fillError += (error - m_fillError) * FillErrorSmoothing;
+  double ratio = 1.0 + std::clamp(m_fillError * MaxDriftCorrection, -MaxDriftCorrection, MaxDriftCorrection);
+  if (std::fabs(ratio - m_driftRatio) > 1e-6) {
+    m_driftRatio = ratio;
+    voice.setPitchRatio(ratio, true);
+  }
+}
+
+size_t AudioEngineBridge::supplyAudio(IAudioVoice& voice, size_t frames, int16_t* data) {
+  size_t done = 0;
+  while (m_primed && done < frames) {
+    const AudioTapBlock* block = m_tap->peekBlock();
+    if (!block) {
+      /* Ran dry; output silence until the target latency is buffered again */
+      ++m_underruns;
+      m_primed = false;
+      break;
+    }
+
+    size_t count = std::min(block->m_frames - m_blockOffset, frames - done);
+    unsigned chans = block->m_channelCount;
+    const float* src = block->m_samples + m_blockOffset * chans;
+    int16_t* dst = data + done * 2;
+    if (chans >= 2) {
+      for (size_t f = 0; f < count; ++f, src += chans, dst += 2) {
+        dst[0] = ConvertSample(src[0]);
+        dst[1] = ConvertSample(src[1]);
+      }
+    } else {
+      for (size_t f = 0; f < count; ++f, ++src, dst += 2)
+        dst[0] = dst[1] = ConvertSample(*src);
+    }
+
+    done += count;
+    m_blockOffset += count;
+    if (m_blockOffset >= block->m_frames) {
+      m_tap->popBlock();
+      m_blockOffset = 0;
+    }
+  }
+
+  std::fill(data + done * 2, data + frames * 2, int16_t(0));
+  return frames;
+}
+
+} // namespace boo
@@ -0,0 +1,339 @@
+#include "lib/audiodev/AudioFileWriter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if !_WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <logvisor/logvisor.hpp>
+
+#undef min
+#undef max
+
+namespace boo {
+
+static logvisor::Module Log("boo::AudioFileWriter");
+
+/* JUNK chunk reserved after the RIFF header; rewritten as ds64 for RF64 */
+static constexpr size_t DS64Offset = 12;
+static constexpr uint32_t DS64Size = 28;
+static constexpr size_t FmtOffset = DS64Offset + 8 + DS64Size;
+
+static size_t RoundUp(size_t v, size_t align) { return (v + align - 1) / align * align; }
+
+static uint8_t* AllocAligned(size_t bytes) {
+  return static_cast<uint8_t*>(::operator new(bytes, std::align_val_t(AudioFileWriter::Alignment)));
+}
+
+static void FreeAligned(uint8_t* p) {
+  if (p)
+    ::operator delete(p, std::align_val_t(AudioFileWriter::Alignment));
+}
+
+template <typename T>
+static void Put(uint8_t* dst, T val) {
+  std::memcpy(dst, &val, sizeof(T));
+}
+
+AudioFileWriter::AudioFileWriter(const WAVOutOptions& options) : m_options(options) {
+  m_chunkBytes = RoundUp(std::max(options.m_writeBytes, Alignment), Alignment);
+  m_ringBytes = RoundUp(std::max(options.m_bufferBytes, m_chunkBytes * 2), m_chunkBytes);
+}
+
+AudioFileWriter::~AudioFileWriter() {
+  close();
+  FreeAligned(m_ring);
+  FreeAligned(m_header);
+}
+
+void AudioFileWriter::_buildHeader(uint64_t dataBytes) {
+  uint8_t* h = m_header;
+  std::memset(h, 0, m_dataOffset);
+
+  uint64_t riffBytes = m_dataOffset + dataBytes - 8;
+  bool rf64 = riffBytes > UINT32_MAX;
+  std::memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+  Put<uint32_t>(h + 4, rf64 ? UINT32_MAX : uint32_t(riffBytes));
+  std::memcpy(h + 8, "WAVE", 4);
+
+  std::memcpy(h + DS64Offset, rf64 ? "ds64" : "JUNK", 4);
+  Put<uint32_t>(h + DS64Offset + 4, DS64Size);
+  if (rf64) {
+    Put<uint64_t>(h + DS64Offset + 8, riffBytes);
+    Put<uint64_t>(h + DS64Offset + 16, dataBytes);
+    Put<uint64_t>(h + DS64Offset + 24, dataBytes / (4 * m_channels));
+  }
+
+  uint8_t* fmt = h + FmtOffset;
+  bool extensible = m_speakerMask != 0;
+  uint32_t fmtSize = extensible ? 40 : 16;
+  uint16_t blockAlign = uint16_t(4 * m_channels);
+  std::memcpy(fmt, "fmt ", 4);
+  Put<uint32_t>(fmt + 4, fmtSize);
+  Put<uint16_t>(fmt + 8, extensible ? 0xFFFE : 3);
+  Put<uint16_t>(fmt + 10, uint16_t(m_channels));
+  Put<uint32_t>(fmt + 12, m_sampleRate);
+  Put<uint32_t>(fmt + 16, m_sampleRate * blockAlign);
+  Put<uint16_t>(fmt + 20, blockAlign);
+  Put<uint16_t>(fmt + 22, 32);
+  if (extensible) {
+    Put<uint16_t>(fmt + 24, 22);
+    Put<uint16_t>(fmt + 26, 32);
+    Put<uint32_t>(fmt + 28, m_speakerMask);
+    std::memcpy(fmt + 32, "\x03\x00\x00\x00\x00\x00\x10\x00\x80\x00\x00\xaa\x00\x38\x9b\x71", 16);
+  }
+
+  /* Pad so the sample data begins on an aligned boundary */
+  uint8_t* pad = fmt + 8 + fmtSize;
+  uint8_t* data = h + m_dataOffset - 8;
+  std::memcpy(pad, "JUNK", 4);
+  Put<uint32_t>(pad + 4, uint32_t(data - pad - 8));
+
+  std::memcpy(data, "data", 4);
+  Put<uint32_t>(data + 4, rf64 ? UINT32_MAX : uint32_t(dataBytes));
+}
+
+void AudioFileWriter::_writeHeader(uint64_t dataBytes) {
+  _buildHeader(dataBytes);
+  if (!_writeAt(m_header, m_dataOffset, 0))
+    return;
+#if _WIN32
+  fflush(m_fp);
+#elif __APPLE__
+  fsync(m_fd);
+#else
+  fdatasync(m_fd);
+#endif
+}
+
+#if _WIN32
+bool AudioFileWriter::_writeAt(const void* data, size_t bytes, uint64_t offset) {
+  if (m_failed)
+    return false;
+  if (_fseeki64(m_fp, int64_t(offset), SEEK_SET) || fwrite(data, 1, bytes, m_fp) != bytes) {
+    Log.report(logvisor::Error, FMT_STRING("unable to write {} bytes at {}"), bytes, offset);
+    m_failed = true;
+    return false;
+  }
+  return true;
+}
+
+void AudioFileWriter::_disableDirect() {}
+
+void AudioFileWriter::_closeFile() {
+  if (m_fp)
+    fclose(m_fp);
+  m_fp = nullptr;
+}
+
+bool AudioFileWriter::open(const char* path, unsigned channels, uint32_t sampleRate, uint32_t speakerMask) {
+  m_fp = fopen(path, "wb");
+  if (!m_fp)
+    return false;
+  _start(channels, sampleRate, speakerMask);
+  return true;
+}
+
+bool AudioFileWriter::open(const wchar_t* path, unsigned channels, uint32_t sampleRate, uint32_t speakerMask) {
+  m_fp = _wfopen(path, L"wb");
+  if (!m_fp)
+    return false;
+  _start(channels, sampleRate, speakerMask);
+  return true;
+}
+#else
+bool AudioFileWriter::_writeAt(const void* data, size_t bytes, uint64_t offset) {
+  if (m_failed)
+    return false;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  while (bytes) {
+    ssize_t ret = pwrite(m_fd, p, bytes, off_t(offset));
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+      Log.report(logvisor::Error, FMT_STRING("unable to write {} bytes at {}: {}"), bytes, offset, strerror(errno));
+      m_failed = true;
+      return false;
+    }
+    p += ret;
+    bytes -= size_t(ret);
+    offset += uint64_t(ret);
+  }
+  return true;
+}
+
+void AudioFileWriter::_disableDirect() {
+#ifdef O_DIRECT
+  if (m_direct) {
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+    m_direct = false;
+  }
+#endif
+}
+
+void AudioFileWriter::_closeFile() {
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = -1;
+}
+
+bool AudioFileWriter::open(const char* path, unsigned channels, uint32_t sampleRate, uint32_t speakerMask) {
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+  if (m_options.m_directIO) {
+    m_fd = ::open(path, flags | O_DIRECT, 0644);
+    if (m_fd >= 0)
+      m_direct = true;
+    else
+      Log.report(logvisor::Warning, FMT_STRING("direct I/O unavailable for {}; using buffered writes"), path);
+  }
+#endif
+  if (m_fd < 0)
+    m_fd = ::open(path, flags, 0644);
+  if (m_fd < 0)
+    return false;
+#if __APPLE__
+  if (m_options.m_directIO)
+    fcntl(m_fd, F_NOCACHE, 1);
+#endif
+  _start(channels, sampleRate, speakerMask);
+  return true;
+}
+#endif
+
+void AudioFileWriter::_start(unsigned channels, uint32_t sampleRate, uint32_t speakerMask) {
+  m_channels = channels;
+  m_sampleRate = sampleRate;
+  m_speakerMask = speakerMask;
+  m_dataOffset = Alignment;
+  if (!m_ring)
+    m_ring = AllocAligned(m_ringBytes);
+  if (!m_header)
+    m_header = AllocAligned(m_dataOffset);
+  m_writePos.store(0);
+  m_readPos.store(0);
+  m_notifiedPos = 0;
+  m_stop.store(false);
+  m_failed = false;
+  _buildHeader(0);
+  _writeAt(m_header, m_dataOffset, 0);
+  m_thread = std::thread([this]() { _run(); });
+}
+
+void AudioFileWriter::write(const float* samples, size_t count) {
+  if (!m_ring || m_stop.load(std::memory_order_relaxed))
+    return;
+
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(samples);
+  size_t bytes = count * sizeof(float);
+  uint64_t w = m_writePos.load(std::memory_order_relaxed);
+  while (bytes) {
+    uint64_t r = m_readPos.load(std::memory_order_acquire);
+    size_t space = m_ringBytes - size_t(w - r);
+    if (!space) {
+      /* Writer is a full ring behind; nothing to do but wait for it */
+      m_stalls.fetch_add(1, std::memory_order_relaxed);
+      std::unique_lock<std::mutex> lk(m_lock);
+      m_dataCv.notify_one();
+      m_spaceCv.wait(lk, [&]() { return m_readPos.load(std::memory_order_acquire) != r; });
+      continue;
+    }
+    size_t off = size_t(w % m_ringBytes);
+    size_t n = std::min({bytes, space, m_ringBytes - off});
+    std::memcpy(m_ring + off, src, n);
+    src += n;
+    bytes -= n;
+    w += n;
+    m_writePos.store(w, std::memory_order_release);
+  }
+
+  /* Wake the writer once per chunk rather than once per block */
+  if (w - m_notifiedPos >= m_chunkBytes) {
+    m_notifiedPos = w;
+    { std::lock_guard<std::mutex> lk(m_lock); }
+    m_dataCv.notify_one();
+  }
+}
+
+void AudioFileWriter::_drain(uint64_t upTo) {
+  uint64_t pos = m_readPos.load(std::memory_order_relaxed);
+  while (pos < upTo) {
+    /* Chunks never straddle the end of the ring since its size is a multiple of the chunk size */
+    size_t n = size_t(std::min(upTo - pos, uint64_t(m_chunkBytes)));
+    if (n < m_chunkBytes)
+      _disableDirect();
+    _writeAt(m_ring + pos % m_ringBytes, n, m_dataOffset + pos);
+    pos += n;
+    m_readPos.store(pos, std::memory_order_release);
+    { std::lock_guard<std::mutex> lk(m_lock); }
+    m_spaceCv.notify_one();
+  }
+}
+
+void AudioFileWriter::_run() {
+  logvisor::RegisterThreadName("Boo Audio File Writer");
+
+  using Clock = std::chrono::steady_clock;
+  const bool fixups = m_options.m_headerFixupSeconds > 0.0;
+  const auto interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(fixups ? m_options.m_headerFixupSeconds : 1.0));
+  auto nextFixup = Clock::now() + interval;
+  uint64_t fixedBytes = 0;
+
+  auto ready = [&]() {
+    return m_stop.load(std::memory_order_acquire) ||
+           m_writePos.load(std::memory_order_acquire) - m_readPos.load(std::memory_order_relaxed) >= m_chunkBytes;
+  };
+
+  for (;;) {
+    /* Bounded so a writer that is always behind (offline renders) still reaches the fixup check */
+    uint64_t r = m_readPos.load(std::memory_order_relaxed);
+    uint64_t whole = (m_writePos.load(std::memory_order_acquire) - r) / m_chunkBytes;
+    if (whole) {
+      r += std::min(whole, uint64_t(MaxChunksPerPass)) * m_chunkBytes;
+      _drain(r);
+    }
+
+    if (fixups && Clock::now() >= nextFixup) {
+      if (r != fixedBytes) {
+        _writeHeader(r);
+        fixedBytes = r;
+      }
+      nextFixup = Clock::now() + interval;
+    }
+
+    if (whole)
+      continue;
+    if (m_stop.load(std::memory_order_acquire))
+      break;
+
+    std::unique_lock<std::mutex> lk(m_lock);
+    if (fixups)
+      m_dataCv.wait_until(lk, nextFixup, ready);
+    else
+      m_dataCv.wait(lk, ready);
+  }
+
+  uint64_t end = m_writePos.load(std::memory_order_acquire);
+  _drain(end);
+  _writeHeader(end);
+}
+
+void AudioFileWriter::close() {
+  if (!m_thread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lk(m_lock);
+    m_stop.store(true, std::memory_order_release);
+  }
+  m_dataCv.notify_one();
+  m_thread.join();
+  _closeFile();
+}
+
+} // namespace boo
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#include "boo/audiodev/IAudioVoiceEngine.hpp"
+
+namespace boo {
+
+/** Streams 32-bit float PCM into a WAV file from a background thread.
+ *  The mixing thread copies each block into a single-producer/single-consumer byte ring;
+ *  the writer thread drains it in fixed, 4KiB-aligned chunks so the file sees large
+ *  aligned writes (and can be opened for direct I/O).
+ *
+ *  The header reserves a JUNK chunk that becomes the ds64 chunk once the file passes
+ *  4GiB (RF64), and pads so that sample data starts on a 4KiB boundary. The writer
+ *  rewrites the header sizes periodically, so a file cut short by a crash still parses. */
+class AudioFileWriter {
+public:
+  static constexpr size_t Alignment = 4096;
+
+private:
+  /* Chunks written between header fixup checks */
+  static constexpr unsigned MaxChunksPerPass = 16;
+
+  WAVOutOptions m_options;
+  size_t m_chunkBytes = 0;
+  size_t m_ringBytes = 0;
+  uint8_t* m_ring = nullptr;
+  uint8_t* m_header = nullptr;
+  size_t m_dataOffset = 0;
+  unsigned m_channels = 0;
+  uint32_t m_sampleRate = 0;
+  uint32_t m_speakerMask = 0;
+
+#if _WIN32
+  FILE* m_fp = nullptr;
+#else
+  int m_fd = -1;
+  bool m_direct = false;
+#endif
+
+  /* Totals in bytes; m_writePos is owned by the mixing thread, m_readPos by the writer */
+  std::atomic<uint64_t> m_writePos = 0;
+  std::atomic<uint64_t> m_readPos = 0;
+  uint64_t m_notifiedPos = 0;
+  std::atomic<uint64_t> m_stalls = 0;
+  std::atomic_bool m_stop = false;
+  bool m_failed = false;
+
+  std::mutex m_lock;
+  std::condition_variable m_dataCv;
+  std::condition_variable m_spaceCv;
+  std::thread m_thread;
+
+  bool _writeAt(const void* data, size_t bytes, uint64_t offset);
+  void _disableDirect();
+  void _buildHeader(uint64_t dataBytes);
+  void _writeHeader(uint64_t dataBytes);
+  void _drain(uint64_t upTo);
+  void _run();
+  void _start(unsigned channels, uint32_t sampleRate, uint32_t speakerMask);
+  void _closeFile();
+
+public:
+  explicit AudioFileWriter(const WAVOutOptions& options);
+  ~AudioFileWriter();
+  AudioFileWriter(const AudioFileWriter&) = delete;
+  AudioFileWriter& operator=(const AudioFileWriter&) = delete;
+
+  /** Create the file and start the writer thread; speakerMask 0 writes a plain IEEE-float format chunk */
+  bool open(const char* path, unsigned channels, uint32_t sampleRate, uint32_t speakerMask);
+#if _WIN32
+  bool open(const wchar_t* path, unsigned channels, uint32_t sampleRate, uint32_t speakerMask);
+#endif
+
+  bool isOpen() const { return m_thread.joinable(); }
+
+  /** Mixing thread: queue interleaved samples; only blocks while the ring is completely full */
+  void write(const float* samples, size_t count);
+
+  /** Flush everything queued, finalize the header and close the file */
+  void close();
+
+  /** Number of times write() had to wait on the writer thread */
+  uint64_t getStallCount() const { return m_stalls.load(std::memory_order_relaxed); }
+};
+
+} // namespace boo
@@ -0,0 +1,118 @@
+#include "lib/audiodev/AudioOutputStage.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if __SSE__
+#include <immintrin.h>
+#endif
+
+#undef min
+#undef max
+
+namespace boo {
+
+/* Scale factors map the [-1, 1] float bus onto the full integer range.
+ * The int32 upper limit is the largest float below 2^31. */
+static constexpr float Scale16 = 32768.f;
+static constexpr float Min16 = -32768.f;
+static constexpr float Max16 = 32767.f;
+static constexpr float Scale32 = 2147483648.f;
+static constexpr float Min32 = -2147483648.f;
+static constexpr float Max32 = 2147483520.f;
+
+static inline int16_t ConvertSample16(float in) { return int16_t(std::lrint(std::clamp(in, Min16, Max16))); }
+static inline int32_t ConvertSample32(float in) { return int32_t(std::lrint(std::clamp(in, Min32, Max32))); }
+
+float AudioOutputStage::_beginInterval(float targetVol, size_t frames, float& step) {
+  float startVol = m_curVol;
+  step = (frames && targetVol != startVol) ? (targetVol - startVol) / float(frames) : 0.f;
+  m_curVol = targetVol;
+  return startVol;
+}
+
+void AudioOutputStage::process(const float* in, int16_t* out, size_t frames, unsigned chanCount, float targetVol) {
+  float step;
+  float gain = _beginInterval(targetVol, frames, step) * Scale16;
+
+  if (step != 0.f) {
+    step *= Scale16;
+    for (size_t f = 0; f < frames; ++f, gain += step)
+      for (unsigned c = 0; c < chanCount; ++c)
+        *out++ = ConvertSample16(*in++ * gain);
+    return;
+  }
+
+  size_t samples = frames * chanCount;
+  size_t s = 0;
+#if __SSE__
+  const __m128 gainVec = _mm_set1_ps(gain);
+  const __m128 minVec = _mm_set1_ps(Min16);
+  const __m128 maxVec = _mm_set1_ps(Max16);
+  for (; s + 8 <= samples; s += 8) {
+    __m128 lo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + s), gainVec), minVec), maxVec);
+    __m128 hi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + s + 4), gainVec), minVec), maxVec);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + s), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+  }
+#endif
+  for (; s < samples; ++s)
+    out[s] = ConvertSample16(in[s] * gain);
+}
+
+void AudioOutputStage::process(const float* in, int32_t* out, size_t frames, unsigned chanCount, float targetVol) {
+  float step;
+  float gain = _beginInterval(targetVol, frames, step) * Scale32;
+
+  if (step != 0.f) {
+    step *= Scale32;
+    for (size_t f = 0; f < frames; ++f, gain += step)
+      for (unsigned c = 0; c < chanCount; ++c)
+        *out++ = ConvertSample32(*in++ * gain);
+    return;
+  }
+
+  size_t samples = frames * chanCount;
+  size_t s = 0;
+#if __SSE__
+  const __m128 gainVec = _mm_set1_ps(gain);
+  const __m128 minVec = _mm_set1_ps(Min32);
+  const __m128 maxVec = _mm_set1_ps(Max32);
+  for (; s + 4 <= samples; s += 4) {
+    __m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + s), gainVec), minVec), maxVec);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + s), _mm_cvtps_epi32(v));
+  }
+#endif
+  for (; s < samples; ++s)
+    out[s] = ConvertSample32(in[s] * gain);
+}
+
+void AudioOutputStage::process(const float* in, float* out, size_t frames, unsigned chanCount, float targetVol) {
+  float step;
+  float gain = _beginInterval(targetVol, frames, step);
+
+  /* Float backends clip on their own; over-range values are passed through untouched */
+  if (step != 0.f) {
+    for (size_t f = 0; f < frames; ++f, gain += step)
+      for (unsigned c = 0; c < chanCount; ++c)
+        *out++ = *in++ * gain;
+    return;
+  }
+
+  size_t samples = frames * chanCount;
+  if (gain == 1.f) {
+    if (in != out)
+      std::copy(in, in + samples, out);
+    return;
+  }
+
+  size_t s = 0;
+#if __SSE__
+  const __m128 gainVec = _mm_set1_ps(gain);
+  for (; s + 4 <= samples; s += 4)
+    _mm_storeu_ps(out + s, _mm_mul_ps(_mm_loadu_ps(in + s), gainVec));
+#endif
+  for (; s < samples; ++s)
+    out[s] = in[s] * gain;
+}
+
+} // namespace boo
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace boo {
+
+/** Final pass from the engine's float mix bus into the backend's sample format.
+ *  Master volume, volume ramping, clamping and format conversion all happen in
+ *  a single sweep over each mixed interval. */
+class AudioOutputStage {
+  float m_curVol = 1.f;
+
+  /* Returns gain for the first frame and per-frame increment, ramping towards
+   * targetVol across the interval when the master volume has changed */
+  float _beginInterval(float targetVol, size_t frames, float& step);
+
+public:
+  /** Process one interval; float output may alias input for in-place processing */
+  void process(const float* in, int16_t* out, size_t frames, unsigned chanCount, float targetVol);
+  void process(const float* in, int32_t* out, size_t frames, unsigned chanCount, float targetVol);
+  void process(const float* in, float* out, size_t frames, unsigned chanCount, float targetVol);
+
+  /** Jump to volume without ramping (e.g. when output device is reset) */
+  void resetVolume(float vol) { m_curVol = vol; }
+};
+
+} // namespace boo
@@ -0,0 +1,50 @@
+#include "lib/audiodev/AudioQualityWatchdog.hpp"
+
+namespace boo {
+
+/* Periods to let a transition take effect before the load is judged again */
+static constexpr unsigned SettlePeriods = 8;
+
+void AudioQualityWatchdog::setConfig(const AudioWatchdogConfig& config) {
+  m_config = config;
+  m_load = 0.0;
+  m_settle = 0;
+  m_calmPeriods = 0;
+  if (!m_config.m_enabled)
+    m_level.store(AudioQualityLevel::Full, std::memory_order_relaxed);
+}
+
+bool AudioQualityWatchdog::endPeriod(size_t frames, double sampleRate) {
+  if (!m_config.m_enabled || !frames || sampleRate <= 0.0)
+    return false;
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+  double load = elapsed / (frames / sampleRate);
+
+  /* Follow spikes quickly, decay slowly */
+  m_load += (load - m_load) * (load > m_load ? 0.5 : 0.05);
+
+  if (m_settle) {
+    --m_settle;
+    return false;
+  }
+
+  int level = int(m_level.load(std::memory_order_relaxed));
+  if (m_load > m_config.m_degradeLoad && level < int(AudioQualityLevel::BypassEffects)) {
+    ++level;
+  } else if (m_load < m_config.m_recoverLoad && level > int(AudioQualityLevel::Full)) {
+    if (++m_calmPeriods < m_config.m_recoverPeriods)
+      return false;
+    --level;
+  } else {
+    m_calmPeriods = 0;
+    return false;
+  }
+
+  m_calmPeriods = 0;
+  m_settle = SettlePeriods;
+  m_level.store(AudioQualityLevel(level), std::memory_order_relaxed);
+  return true;
+}
+
+} // namespace boo
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "boo/audiodev/IAudioVoiceEngine.hpp"
+
+namespace boo {
+
+/** Compares time spent mixing each pump cycle against the playback time it produced.
+ *  A smoothed load above the configured threshold steps the quality level down one
+ *  notch at a time; a sustained load below the recovery threshold steps it back up. */
+class AudioQualityWatchdog {
+  AudioWatchdogConfig m_config;
+  std::atomic<AudioQualityLevel> m_level = AudioQualityLevel::Full;
+  std::chrono::steady_clock::time_point m_start;
+  double m_load = 0.0;
+  unsigned m_settle = 0;
+  unsigned m_calmPeriods = 0;
+
+public:
+  void setConfig(const AudioWatchdogConfig& config);
+  const AudioWatchdogConfig& config() const { return m_config; }
+  AudioQualityLevel level() const { return m_level.load(std::memory_order_relaxed); }
+  double load() const { return m_load; }
+
+  void beginPeriod() {
+    if (m_config.m_enabled)
+      m_start = std::chrono::steady_clock::now();
+  }
+
+  /** Returns true if the quality level changed as a result of this period */
+  bool endPeriod(size_t frames, double sampleRate);
+};
+
+} // namespace boo
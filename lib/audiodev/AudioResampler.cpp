@@ -0,0 +1,248 @@
+#include "lib/audiodev/AudioResampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if __SSE__
+#include <immintrin.h>
+#endif
+
+#undef min
+#undef max
+
+namespace boo {
+
+/* Input frames buffered per refill, beyond the kernel's history and look-ahead */
+static constexpr size_t WindowFrames = 512;
+
+/* Output frames whose positions are computed ahead of each kernel pass */
+static constexpr size_t ChunkFrames = 64;
+
+static constexpr size_t SincTaps = 8;
+static constexpr size_t SincPhases = 32;
+static constexpr double SincCutoff = 0.9;
+
+/* Blackman-windowed sinc, one normalized row per fractional phase (plus the closing phase for
+ * interpolating between rows) */
+struct SincTable {
+  alignas(16) float m_coefs[SincPhases + 1][SincTaps];
+
+  SincTable() {
+    constexpr double Pi = 3.14159265358979323846;
+    for (size_t p = 0; p <= SincPhases; ++p) {
+      double frac = double(p) / SincPhases;
+      double sum = 0.0;
+      double row[SincTaps];
+      for (size_t t = 0; t < SincTaps; ++t) {
+        double x = double(t) - double(SincTaps / 2 - 1) - frac;
+        double n = (x + SincTaps / 2.0) / SincTaps;
+        double window = 0.42 - 0.5 * std::cos(2.0 * Pi * n) + 0.08 * std::cos(4.0 * Pi * n);
+        double sinc = x == 0.0 ? 1.0 : std::sin(Pi * SincCutoff * x) / (Pi * SincCutoff * x);
+        row[t] = sinc * window;
+        sum += row[t];
+      }
+      for (size_t t = 0; t < SincTaps; ++t)
+        m_coefs[p][t] = float(row[t] / sum);
+    }
+  }
+};
+static const SincTable SincCoefs;
+
+static inline float Hermite(float xm1, float x0, float x1, float x2, float t) {
+  float c1 = 0.5f * (x1 - xm1);
+  float c2 = xm1 - 2.5f * x0 + 2.f * x1 - 0.5f * x2;
+  float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+  return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+AudioResampler::AudioResampler(AudioResamplerType type, unsigned channels) : m_type(type), m_chans(channels) {
+  switch (type) {
+  case AudioResamplerType::Hermite:
+    m_left = 1;
+    m_right = 2;
+    break;
+  case AudioResamplerType::Sinc:
+    m_left = SincTaps / 2 - 1;
+    m_right = SincTaps / 2;
+    break;
+  default:
+    m_left = 0;
+    m_right = 1;
+    break;
+  }
+  for (unsigned c = 0; c < m_chans; ++c)
+    m_buf[c].resize(WindowFrames + m_left + m_right + 1);
+  reset();
+}
+
+void AudioResampler::reset() {
+  for (unsigned c = 0; c < m_chans; ++c)
+    std::fill(m_buf[c].begin(), m_buf[c].begin() + m_left, 0.f);
+  m_fill = m_left;
+  m_pos = double(m_left);
+  m_flushed = false;
+}
+
+void AudioResampler::setRatio(double ratio, size_t slewFrames) {
+  m_stepTarget = ratio;
+  m_slewRemaining = slewFrames;
+  if (slewFrames)
+    m_stepDelta = (ratio - m_step) / double(slewFrames);
+  else
+    m_step = ratio;
+}
+
+bool AudioResampler::_refill(InputFn input, void* ctx) {
+  /* Slide the window down to the oldest frame the kernel still needs */
+  size_t base = size_t(m_pos);
+  size_t drop = std::min(base > m_left ? base - m_left : 0, m_fill);
+  if (drop) {
+    for (unsigned c = 0; c < m_chans; ++c)
+      std::copy(m_buf[c].begin() + drop, m_buf[c].begin() + m_fill, m_buf[c].begin());
+    m_fill -= drop;
+    m_pos -= double(drop);
+  }
+
+  if (m_flushed)
+    return false;
+
+  size_t space = m_buf[0].size() - m_fill;
+  int16_t* data;
+  size_t got = input(ctx, &data, space);
+  if (!got) {
+    /* Pad the look-ahead with silence so the final input frames are still played out */
+    for (unsigned c = 0; c < m_chans; ++c)
+      std::fill(m_buf[c].begin() + m_fill, m_buf[c].begin() + m_fill + m_right, 0.f);
+    m_fill += m_right;
+    m_flushed = true;
+    return true;
+  }
+
+  got = std::min(got, space);
+  for (unsigned c = 0; c < m_chans; ++c) {
+    float* dst = m_buf[c].data() + m_fill;
+    const int16_t* src = data + c;
+    for (size_t f = 0; f < got; ++f, src += m_chans)
+      dst[f] = *src * (1.f / 32768.f);
+  }
+  m_fill += got;
+  return true;
+}
+
+size_t AudioResampler::process(float* out, size_t frames, InputFn input, void* ctx) {
+  size_t idx[ChunkFrames];
+  alignas(16) float frac[ChunkFrames];
+
+  size_t done = 0;
+  while (done < frames) {
+    size_t count = 0;
+    size_t maxCount = std::min(ChunkFrames, frames - done);
+    while (count < maxCount) {
+      size_t i = size_t(m_pos);
+      if (i + m_right >= m_fill)
+        break;
+      idx[count] = i;
+      frac[count] = float(m_pos - double(i));
+      ++count;
+
+      m_pos += m_step;
+      if (m_slewRemaining) {
+        m_step += m_stepDelta;
+        if (!--m_slewRemaining)
+          m_step = m_stepTarget;
+      }
+    }
+
+    if (count) {
+      _kernel(out + done * m_chans, idx, frac, count);
+      done += count;
+    } else if (!_refill(input, ctx)) {
+      break;
+    }
+  }
+
+  return done;
+}
+
+void AudioResampler::_kernel(float* out, const size_t* idx, const float* frac, size_t count) const {
+  for (unsigned c = 0; c < m_chans; ++c) {
+    const float* x = m_buf[c].data();
+    float* o = out + c;
+    size_t k = 0;
+
+    switch (m_type) {
+    case AudioResamplerType::Sinc:
+      for (; k < count; ++k) {
+        float phase = frac[k] * SincPhases;
+        size_t p = std::min(size_t(phase), SincPhases - 1);
+        float t = phase - float(p);
+        const float* r0 = SincCoefs.m_coefs[p];
+        const float* r1 = SincCoefs.m_coefs[p + 1];
+        const float* xs = x + idx[k] - m_left;
+#if __SSE__
+        __m128 tv = _mm_set1_ps(t);
+        __m128 c0 = _mm_add_ps(_mm_load_ps(r0), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(r1), _mm_load_ps(r0)), tv));
+        __m128 c1 = _mm_add_ps(_mm_load_ps(r0 + 4), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(r1 + 4), _mm_load_ps(r0 + 4)), tv));
+        __m128 acc = _mm_add_ps(_mm_mul_ps(c0, _mm_loadu_ps(xs)), _mm_mul_ps(c1, _mm_loadu_ps(xs + 4)));
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+        o[k * m_chans] = _mm_cvtss_f32(acc);
+#else
+        float acc = 0.f;
+        for (size_t j = 0; j < SincTaps; ++j)
+          acc += (r0[j] + (r1[j] - r0[j]) * t) * xs[j];
+        o[k * m_chans] = acc;
+#endif
+      }
+      break;
+
+    case AudioResamplerType::Hermite:
+#if __SSE__
+      for (; k + 4 <= count; k += 4) {
+        const size_t* i = idx + k;
+        __m128 xm1 = _mm_set_ps(x[i[3] - 1], x[i[2] - 1], x[i[1] - 1], x[i[0] - 1]);
+        __m128 x0 = _mm_set_ps(x[i[3]], x[i[2]], x[i[1]], x[i[0]]);
+        __m128 x1 = _mm_set_ps(x[i[3] + 1], x[i[2] + 1], x[i[1] + 1], x[i[0] + 1]);
+        __m128 x2 = _mm_set_ps(x[i[3] + 2], x[i[2] + 2], x[i[1] + 2], x[i[0] + 2]);
+        __m128 t = _mm_load_ps(frac + k);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+        __m128 c2 = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(xm1, _mm_mul_ps(_mm_set1_ps(2.5f), x0)), _mm_add_ps(x1, x1)),
+                               _mm_mul_ps(half, x2));
+        __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(x0, x1)));
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c3, t), c2), t), c1), t), x0);
+        alignas(16) float ys[4];
+        _mm_store_ps(ys, y);
+        for (size_t j = 0; j < 4; ++j)
+          o[(k + j) * m_chans] = ys[j];
+      }
+#endif
+      for (; k < count; ++k) {
+        const float* xs = x + idx[k];
+        o[k * m_chans] = Hermite(xs[-1], xs[0], xs[1], xs[2], frac[k]);
+      }
+      break;
+
+    default:
+#if __SSE__
+      for (; k + 4 <= count; k += 4) {
+        const size_t* i = idx + k;
+        __m128 a = _mm_set_ps(x[i[3]], x[i[2]], x[i[1]], x[i[0]]);
+        __m128 b = _mm_set_ps(x[i[3] + 1], x[i[2] + 1], x[i[1] + 1], x[i[0] + 1]);
+        __m128 y = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_load_ps(frac + k)));
+        alignas(16) float ys[4];
+        _mm_store_ps(ys, y);
+        for (size_t j = 0; j < 4; ++j)
+          o[(k + j) * m_chans] = ys[j];
+      }
+#endif
+      for (; k < count; ++k) {
+        const float* xs = x + idx[k];
+        o[k * m_chans] = xs[0] + (xs[1] - xs[0]) * frac[k];
+      }
+      break;
+    }
+  }
+}
+
+} // namespace boo
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "boo/audiodev/IAudioVoice.hpp"
+
+namespace boo {
+
+/** Lightweight interpolating resampler for voices that trade fidelity for cheap,
+ *  continuously variable pitch. Input is pulled through the same callback contract
+ *  as soxr's input function and kept planar in float so kernels can load taps
+ *  contiguously; output is interleaved float. */
+class AudioResampler {
+public:
+  using InputFn = size_t (*)(void* ctx, int16_t** data, size_t frames);
+
+private:
+  AudioResamplerType m_type;
+  unsigned m_chans;
+  size_t m_left;  /* History frames needed behind the interpolation point */
+  size_t m_right; /* Look-ahead frames needed past it */
+
+  /* Planar input window; m_pos indexes it fractionally */
+  std::array<std::vector<float>, 2> m_buf;
+  size_t m_fill = 0;
+  double m_pos = 0.0;
+  bool m_flushed = false;
+
+  /* Input frames advanced per output frame, optionally slewing towards a target */
+  double m_step = 1.0;
+  double m_stepTarget = 1.0;
+  double m_stepDelta = 0.0;
+  size_t m_slewRemaining = 0;
+
+  bool _refill(InputFn input, void* ctx);
+  void _kernel(float* out, const size_t* idx, const float* frac, size_t count) const;
+
+public:
+  AudioResampler(AudioResamplerType type, unsigned channels);
+
+  /** Clear history, e.g. when the source restarts */
+  void reset();
+
+  /** Set input/output rate ratio, ramped linearly over slewFrames output frames */
+  void setRatio(double ratio, size_t slewFrames);
+
+  /** Produce up to frames interleaved output frames; fewer once input is exhausted */
+  size_t process(float* out, size_t frames, InputFn input, void* ctx);
+};
+
+} // namespace boo
@@ -0,0 +1,268 @@
+#include "lib/audiodev/AudioSampleDecoder.hpp"
+
+#include <algorithm>
+
+#if __SSE__
+#include <immintrin.h>
+#endif
+
+#undef min
+#undef max
+
+namespace boo {
+
+/* DSPADPCM: 8-byte frames; predictor/scale header byte followed by 14 signed nibbles */
+static constexpr size_t DSPFrameBytes = 8;
+static constexpr size_t DSPFrameSamples = 14;
+
+static constexpr int16_t IMAStepTable[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static constexpr int8_t IMAIndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static uint16_t ReadLE16(const uint8_t* ptr) { return uint16_t(ptr[0] | (ptr[1] << 8)); }
+
+/* Expands a frame's nibbles to (nibble * scale) << 11 ahead of the sequential predictor pass */
+static void DSPExpandFrame(const uint8_t* in, int32_t out[16]) {
+  unsigned shift = (in[0] & 0xf) + 11;
+#if __SSE__
+  __m128i bytes = _mm_srli_si128(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)), 1);
+  /* Each byte into the top of a 16-bit lane; arithmetic shifts sign-extend either nibble */
+  __m128i lanes = _mm_unpacklo_epi8(_mm_setzero_si128(), bytes);
+  __m128i hi = _mm_srai_epi16(lanes, 12);
+  __m128i lo = _mm_srai_epi16(_mm_slli_epi16(lanes, 4), 12);
+  __m128i n0 = _mm_unpacklo_epi16(hi, lo);
+  __m128i n1 = _mm_unpackhi_epi16(hi, lo);
+  __m128i count = _mm_cvtsi32_si128(int(shift));
+  auto widen = [&](__m128i v) { return _mm_sll_epi32(_mm_srai_epi32(v, 16), count); };
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), widen(_mm_unpacklo_epi16(n0, n0)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), widen(_mm_unpackhi_epi16(n0, n0)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), widen(_mm_unpacklo_epi16(n1, n1)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), widen(_mm_unpackhi_epi16(n1, n1)));
+#else
+  for (size_t i = 0; i < DSPFrameSamples / 2; ++i) {
+    int32_t b = in[1 + i];
+    out[i * 2] = int32_t(uint32_t((b >> 4) ^ 8) - 8u) * (int32_t(1) << shift);
+    out[i * 2 + 1] = int32_t(uint32_t((b & 0xf) ^ 8) - 8u) * (int32_t(1) << shift);
+  }
+#endif
+}
+
+size_t AudioSampleDecoder::MaxFrames(const AudioSampleData& sample) {
+  if (!sample.m_data || sample.m_channelCount < 1 || sample.m_channelCount > 2)
+    return 0;
+  size_t chans = sample.m_channelCount;
+
+  switch (sample.m_format) {
+  case AudioSampleFormat::PCM16:
+    return sample.m_dataSize ? sample.m_dataSize / (2 * chans) : sample.m_frameCount;
+  case AudioSampleFormat::DSPADPCM: {
+    size_t planeBytes = sample.m_dataSize;
+    if (chans > 1) {
+      if (sample.m_channelStride > sample.m_dataSize)
+        return 0;
+      planeBytes = std::min(sample.m_channelStride, sample.m_dataSize - sample.m_channelStride);
+    }
+    return planeBytes / DSPFrameBytes * DSPFrameSamples;
+  }
+  case AudioSampleFormat::IMAADPCM: {
+    /* Per-channel 4-byte header, then 4-byte words of 8 nibbles interleaved across channels */
+    size_t headerBytes = 4 * chans;
+    if (sample.m_blockAlign <= headerBytes || (sample.m_blockAlign - headerBytes) % headerBytes)
+      return 0;
+    size_t blockFrames = (sample.m_blockAlign - headerBytes) * 2 / chans + 1;
+    size_t blocks = sample.m_dataSize / sample.m_blockAlign;
+    size_t ret = blocks * blockFrames;
+    size_t partial = sample.m_dataSize % sample.m_blockAlign;
+    if (partial >= headerBytes)
+      ret += (partial - headerBytes) / headerBytes * 8 + 1;
+    return ret;
+  }
+  }
+  return 0;
+}
+
+AudioSampleDecoder::AudioSampleDecoder(const AudioSampleData& sample)
+: m_sample(sample), m_chans(sample.m_channelCount), m_cache(CacheFrames * sample.m_channelCount) {
+  if (m_sample.m_format == AudioSampleFormat::IMAADPCM) {
+    m_blockFramesMax = (m_sample.m_blockAlign - 4 * m_chans) * 2 / m_chans + 1;
+    m_block.resize(m_blockFramesMax * m_chans);
+    m_nibbles.resize(m_sample.m_blockAlign * 2);
+  }
+}
+
+void AudioSampleDecoder::seek(size_t frame) {
+  m_cacheFrames = m_cacheRead = 0;
+  if (m_sample.m_format != AudioSampleFormat::DSPADPCM) {
+    m_pos = frame;
+    return;
+  }
+
+  m_pos = 0;
+  for (unsigned c = 0; c < m_chans; ++c) {
+    m_hist1[c] = m_sample.m_dsp[c].m_hist1;
+    m_hist2[c] = m_sample.m_dsp[c].m_hist2;
+  }
+  while (m_pos < frame)
+    _fill(frame);
+  m_cacheFrames = m_cacheRead = 0;
+}
+
+size_t AudioSampleDecoder::_fill(size_t limit) {
+  size_t count = std::min(CacheFrames, limit - m_pos);
+
+  if (m_sample.m_format == AudioSampleFormat::DSPADPCM) {
+    if (m_sample.isLooped()) {
+      /* Break refills at the loop start so the predictor state there can be kept for wrapping */
+      if (m_pos < m_sample.m_loopStart)
+        count = std::min(count, m_sample.m_loopStart - m_pos);
+      else if (m_pos == m_sample.m_loopStart && !m_loopHistValid) {
+        std::copy(m_hist1, m_hist1 + 2, m_loopHist1);
+        std::copy(m_hist2, m_hist2 + 2, m_loopHist2);
+        m_loopHistValid = true;
+      }
+    }
+    _decodeDSP(m_cache.data(), count);
+  } else {
+    _decodeIMA(m_cache.data(), count);
+  }
+
+  m_pos += count;
+  m_cacheFrames = count;
+  m_cacheRead = 0;
+  return count;
+}
+
+size_t AudioSampleDecoder::supply(int16_t** data, size_t frames) {
+  if (m_cacheRead == m_cacheFrames) {
+    size_t end = m_sample.isLooped() ? m_sample.m_loopEnd : m_sample.m_frameCount;
+    if (m_pos >= end) {
+      if (!m_sample.isLooped())
+        return 0;
+
+      m_pos = m_sample.m_loopStart;
+      if (m_sample.m_format == AudioSampleFormat::DSPADPCM) {
+        /* Prefer state recorded on the way in; otherwise trust the file's loop context */
+        for (unsigned c = 0; c < m_chans; ++c) {
+          m_hist1[c] = m_loopHistValid ? m_loopHist1[c] : m_sample.m_dsp[c].m_loopHist1;
+          m_hist2[c] = m_loopHistValid ? m_loopHist2[c] : m_sample.m_dsp[c].m_loopHist2;
+        }
+      }
+    }
+    _fill(end);
+  }
+
+  size_t ret = std::min(frames, m_cacheFrames - m_cacheRead);
+  *data = m_cache.data() + m_cacheRead * m_chans;
+  m_cacheRead += ret;
+  return ret;
+}
+
+void AudioSampleDecoder::_decodeDSP(int16_t* out, size_t frames) {
+  const uint8_t* base = static_cast<const uint8_t*>(m_sample.m_data);
+  alignas(16) int32_t scaled[16];
+
+  for (unsigned c = 0; c < m_chans; ++c) {
+    const uint8_t* plane = base + c * m_sample.m_channelStride;
+    const auto& coefs = m_sample.m_dsp[c].m_coefs;
+    int32_t hist1 = m_hist1[c];
+    int32_t hist2 = m_hist2[c];
+    int16_t* dst = out + c;
+
+    size_t pos = m_pos;
+    size_t done = 0;
+    while (done < frames) {
+      const uint8_t* in = plane + pos / DSPFrameSamples * DSPFrameBytes;
+      size_t sub = pos % DSPFrameSamples;
+      size_t count = std::min(DSPFrameSamples - sub, frames - done);
+
+      DSPExpandFrame(in, scaled);
+      int64_t coef1 = coefs[(in[0] >> 4) & 7][0];
+      int64_t coef2 = coefs[(in[0] >> 4) & 7][1];
+      for (size_t i = sub; i < sub + count; ++i) {
+        int64_t sample = (scaled[i] + 1024 + coef1 * hist1 + coef2 * hist2) >> 11;
+        hist2 = hist1;
+        hist1 = int32_t(std::clamp<int64_t>(sample, -32768, 32767));
+        *dst = int16_t(hist1);
+        dst += m_chans;
+      }
+
+      pos += count;
+      done += count;
+    }
+
+    m_hist1[c] = hist1;
+    m_hist2[c] = hist2;
+  }
+}
+
+void AudioSampleDecoder::_decodeIMABlock(size_t block) {
+  const uint8_t* in = static_cast<const uint8_t*>(m_sample.m_data) + block * m_sample.m_blockAlign;
+  size_t headerBytes = 4 * m_chans;
+  size_t blockBytes = std::min(size_t(m_sample.m_blockAlign), m_sample.m_dataSize - block * m_sample.m_blockAlign);
+  size_t groups = (blockBytes - headerBytes) / headerBytes;
+
+  /* Split every data byte into low-then-high nibbles up front; the predictor pass below is sequential */
+  const uint8_t* data = in + headerBytes;
+  size_t dataBytes = groups * headerBytes;
+  for (size_t i = 0; i < dataBytes; ++i) {
+    m_nibbles[i * 2] = data[i] & 0xf;
+    m_nibbles[i * 2 + 1] = data[i] >> 4;
+  }
+
+  for (unsigned c = 0; c < m_chans; ++c) {
+    int32_t pred = int16_t(ReadLE16(in + c * 4));
+    int32_t index = std::min(int32_t(in[c * 4 + 2]), 88);
+    int16_t* dst = m_block.data() + c;
+    *dst = int16_t(pred);
+    dst += m_chans;
+
+    for (size_t g = 0; g < groups; ++g) {
+      const uint8_t* nib = m_nibbles.data() + (g * m_chans + c) * 8;
+      for (size_t i = 0; i < 8; ++i) {
+        uint8_t n = nib[i];
+        int32_t step = IMAStepTable[index];
+        int32_t diff = step >> 3;
+        if (n & 1)
+          diff += step >> 2;
+        if (n & 2)
+          diff += step >> 1;
+        if (n & 4)
+          diff += step;
+        pred = std::clamp(n & 8 ? pred - diff : pred + diff, -32768, 32767);
+        index = std::clamp(index + IMAIndexTable[n], 0, 88);
+        *dst = int16_t(pred);
+        dst += m_chans;
+      }
+    }
+  }
+
+  m_blockIdx = block;
+  m_blockFrames = 1 + groups * 8;
+}
+
+void AudioSampleDecoder::_decodeIMA(int16_t* out, size_t frames) {
+  size_t pos = m_pos;
+  size_t done = 0;
+  while (done < frames) {
+    size_t block = pos / m_blockFramesMax;
+    size_t sub = pos % m_blockFramesMax;
+    if (block != m_blockIdx)
+      _decodeIMABlock(block);
+    if (sub >= m_blockFrames)
+      break; /* Past a truncated final block; excluded by MaxFrames() */
+
+    size_t count = std::min(m_blockFrames - sub, frames - done);
+    std::copy(m_block.data() + sub * m_chans, m_block.data() + (sub + count) * m_chans, out + done * m_chans);
+    pos += count;
+    done += count;
+  }
+  std::fill(out + done * m_chans, out + frames * m_chans, 0);
+}
+
+} // namespace boo
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "boo/audiodev/IAudioVoice.hpp"
+
+namespace boo {
+
+/** Decodes compressed AudioSampleData ahead of the resampler.
+ *  Each refill decodes up to CacheFrames in whole codec blocks so the per-interval
+ *  cost stays flat; the resampler reads straight out of the cache. */
+class AudioSampleDecoder {
+  const AudioSampleData& m_sample;
+  unsigned m_chans;
+
+  /* Decode-ahead cache of interleaved frames */
+  std::vector<int16_t> m_cache;
+  size_t m_cacheFrames = 0;
+  size_t m_cacheRead = 0;
+
+  /* Next frame to be decoded */
+  size_t m_pos = 0;
+
+  /* DSPADPCM predictor history; captured at the loop start on first pass */
+  int32_t m_hist1[2] = {};
+  int32_t m_hist2[2] = {};
+  bool m_loopHistValid = false;
+  int32_t m_loopHist1[2] = {};
+  int32_t m_loopHist2[2] = {};
+
+  /* IMAADPCM blocks are independent; the most recent one is kept fully decoded */
+  size_t m_blockFramesMax = 0;
+  size_t m_blockIdx = SIZE_MAX;
+  size_t m_blockFrames = 0;
+  std::vector<int16_t> m_block;
+  std::vector<uint8_t> m_nibbles;
+
+  size_t _fill(size_t limit);
+  void _decodeDSP(int16_t* out, size_t frames);
+  void _decodeIMA(int16_t* out, size_t frames);
+  void _decodeIMABlock(size_t block);
+
+public:
+  static constexpr size_t CacheFrames = 1024;
+
+  /** Number of frames actually backed by the sample's m_dataSize; 0 if the codec parameters are invalid */
+  static size_t MaxFrames(const AudioSampleData& sample);
+
+  /** sample must outlive the decoder and already be sanitized */
+  explicit AudioSampleDecoder(const AudioSampleData& sample);
+
+  /** Reposition decoding; DSPADPCM decodes forward from the start to recover predictor state */
+  void seek(size_t frame);
+
+  /** Same contract as the soxr input function; returns 0 at the end of a non-looped sample */
+  size_t supply(int16_t** data, size_t frames);
+};
+
+} // namespace boo
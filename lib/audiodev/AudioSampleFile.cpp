@@ -0,0 +1,266 @@
+#include "boo/audiodev/AudioSampleFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <logvisor/logvisor.hpp>
+
+#include "lib/audiodev/AudioSampleDecoder.hpp"
+
+namespace boo {
+static logvisor::Module Log("boo::AudioSampleFile");
+
+static uint32_t ReadLE32(const uint8_t* ptr) {
+  return uint32_t(ptr[0]) | (uint32_t(ptr[1]) << 8) | (uint32_t(ptr[2]) << 16) | (uint32_t(ptr[3]) << 24);
+}
+
+static uint16_t ReadLE16(const uint8_t* ptr) { return uint16_t(ptr[0] | (ptr[1] << 8)); }
+
+static uint32_t ReadBE32(const uint8_t* ptr) {
+  return (uint32_t(ptr[0]) << 24) | (uint32_t(ptr[1]) << 16) | (uint32_t(ptr[2]) << 8) | uint32_t(ptr[3]);
+}
+
+static uint16_t ReadBE16(const uint8_t* ptr) { return uint16_t((ptr[0] << 8) | ptr[1]); }
+
+/* DSP-ADPCM nibble addresses count the header nibbles of each 16-nibble frame */
+static size_t DSPNibbleToSample(uint32_t nibble) { return nibble / 16 * 14 + (nibble % 16 >= 2 ? nibble % 16 - 2 : 0); }
+
+AudioSampleFile& AudioSampleFile::operator=(AudioSampleFile&& other) noexcept {
+  close();
+  std::swap(m_view, other.m_view);
+  std::swap(m_viewSize, other.m_viewSize);
+#if _WIN32
+  std::swap(m_mapping, other.m_mapping);
+#endif
+  std::swap(m_sample, other.m_sample);
+  return *this;
+}
+
+bool AudioSampleFile::_parse() {
+  const uint8_t* base = static_cast<const uint8_t*>(m_view);
+  if (m_viewSize >= 12 && !std::memcmp(base, "RIFF", 4) && !std::memcmp(base + 8, "WAVE", 4))
+    return _parseWAVE();
+  return _parseDSP();
+}
+
+bool AudioSampleFile::_parseDSP() {
+  const uint8_t* base = static_cast<const uint8_t*>(m_view);
+  /* Header: sample count, nibble count, rate, loop flag, format (0 = ADPCM), loop start/end
+   * nibbles, current address, 16 coefficients, gain, ps, hist1/2, loop ps, loop hist1/2 */
+  if (m_viewSize < 0x60 || ReadBE16(base + 0xE) != 0 || !ReadBE32(base + 0x8)) {
+    Log.report(logvisor::Error, FMT_STRING("not a RIFF WAVE or DSP-ADPCM file"));
+    return false;
+  }
+
+  m_sample.m_format = AudioSampleFormat::DSPADPCM;
+  m_sample.m_data = base + 0x60;
+  m_sample.m_dataSize = m_viewSize - 0x60;
+  m_sample.m_channelCount = 1;
+  m_sample.m_frameCount = ReadBE32(base);
+  m_sample.m_sampleRate = ReadBE32(base + 0x8);
+  m_sample.m_loopStart = 0;
+  m_sample.m_loopEnd = 0;
+  if (ReadBE16(base + 0xC)) {
+    m_sample.m_loopStart = DSPNibbleToSample(ReadBE32(base + 0x10));
+    m_sample.m_loopEnd = DSPNibbleToSample(ReadBE32(base + 0x14)) + 1;
+  }
+
+  AudioSampleData::DSPChannel& chan = m_sample.m_dsp[0];
+  for (int i = 0; i < 8; ++i) {
+    chan.m_coefs[i][0] = int16_t(ReadBE16(base + 0x1C + i * 4));
+    chan.m_coefs[i][1] = int16_t(ReadBE16(base + 0x1C + i * 4 + 2));
+  }
+  chan.m_hist1 = int16_t(ReadBE16(base + 0x40));
+  chan.m_hist2 = int16_t(ReadBE16(base + 0x42));
+  chan.m_loopHist1 = int16_t(ReadBE16(base + 0x46));
+  chan.m_loopHist2 = int16_t(ReadBE16(base + 0x48));
+
+  return true;
+}
+
+bool AudioSampleFile::_parseWAVE() {
+  const uint8_t* base = static_cast<const uint8_t*>(m_view);
+
+  const uint8_t* fmt = nullptr;
+  const uint8_t* data = nullptr;
+  size_t dataSize = 0;
+  const uint8_t* smpl = nullptr;
+  size_t smplSize = 0;
+  const uint8_t* fact = nullptr;
+
+  size_t offset = 12;
+  while (offset + 8 <= m_viewSize) {
+    const uint8_t* chunk = base + offset;
+    size_t chunkSize = ReadLE32(chunk + 4);
+    size_t avail = m_viewSize - offset - 8;
+    if (chunkSize > avail)
+      chunkSize = avail; /* Tolerate truncated files (e.g. an unfinished recording) */
+    if (!std::memcmp(chunk, "fmt ", 4) && chunkSize >= 16)
+      fmt = chunk + 8;
+    else if (!std::memcmp(chunk, "fact", 4) && chunkSize >= 4)
+      fact = chunk + 8;
+    else if (!std::memcmp(chunk, "data", 4))
+      data = chunk + 8, dataSize = chunkSize;
+    else if (!std::memcmp(chunk, "smpl", 4))
+      smpl = chunk + 8, smplSize = chunkSize;
+    offset += 8 + chunkSize + (chunkSize & 1);
+  }
+
+  if (!fmt || !data) {
+    Log.report(logvisor::Error, FMT_STRING("WAVE file missing 'fmt ' or 'data' chunk"));
+    return false;
+  }
+
+  uint16_t formatTag = ReadLE16(fmt);
+  uint16_t channels = ReadLE16(fmt + 2);
+  uint32_t sampleRate = ReadLE32(fmt + 4);
+  uint16_t bitsPerSample = ReadLE16(fmt + 14);
+  /* WAVE_FORMAT_EXTENSIBLE carries the real format tag at the head of its SubFormat GUID */
+  if (formatTag == 0xFFFE && ReadLE16(fmt + 16) >= 22)
+    formatTag = ReadLE16(fmt + 24);
+
+  bool pcm16 = formatTag == 1 && bitsPerSample == 16;
+  bool imaAdpcm = formatTag == 0x11 && bitsPerSample == 4;
+  if ((!pcm16 && !imaAdpcm) || channels < 1 || channels > 2) {
+    Log.report(logvisor::Error, FMT_STRING("unsupported WAVE format {} ({} channels, {} bits)"), formatTag, channels,
+               bitsPerSample);
+    return false;
+  }
+
+  m_sample.m_data = data;
+  m_sample.m_dataSize = dataSize;
+  m_sample.m_channelCount = channels;
+  m_sample.m_sampleRate = sampleRate;
+  m_sample.m_loopStart = 0;
+  m_sample.m_loopEnd = 0;
+
+  if (imaAdpcm) {
+    m_sample.m_format = AudioSampleFormat::IMAADPCM;
+    m_sample.m_blockAlign = ReadLE16(fmt + 12);
+    /* 'fact' holds the exact length; the final block is otherwise assumed full */
+    m_sample.m_frameCount = fact ? ReadLE32(fact) : SIZE_MAX;
+    m_sample.m_frameCount = std::min(m_sample.m_frameCount, AudioSampleDecoder::MaxFrames(m_sample));
+    if (!m_sample.m_frameCount) {
+      Log.report(logvisor::Error, FMT_STRING("invalid IMA ADPCM block alignment {}"), m_sample.m_blockAlign);
+      m_sample = {};
+      return false;
+    }
+  } else {
+    m_sample.m_format = AudioSampleFormat::PCM16;
+    m_sample.m_frameCount = dataSize / (2 * channels);
+  }
+
+  /* smpl: 36-byte header (loop count at +28), then 24-byte loops; loop end is inclusive */
+  if (smpl && smplSize >= 60 && ReadLE32(smpl + 28) > 0) {
+    m_sample.m_loopStart = ReadLE32(smpl + 36 + 8);
+    m_sample.m_loopEnd = size_t(ReadLE32(smpl + 36 + 12)) + 1;
+  }
+
+  return true;
+}
+
+#if _WIN32
+bool AudioSampleFile::open(const SystemChar* path) {
+  close();
+
+  HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    Log.report(logvisor::Error, FMT_STRING(L"unable to open '{}'"), path);
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || !size.QuadPart) {
+    CloseHandle(file);
+    return false;
+  }
+
+  m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!m_mapping) {
+    Log.report(logvisor::Error, FMT_STRING(L"unable to map '{}'"), path);
+    return false;
+  }
+
+  m_view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!m_view) {
+    Log.report(logvisor::Error, FMT_STRING(L"unable to map '{}'"), path);
+    close();
+    return false;
+  }
+  m_viewSize = size_t(size.QuadPart);
+
+  if (!_parse()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void AudioSampleFile::close() {
+  if (m_view)
+    UnmapViewOfFile(m_view);
+  if (m_mapping)
+    CloseHandle(m_mapping);
+  m_view = nullptr;
+  m_mapping = nullptr;
+  m_viewSize = 0;
+  m_sample = {};
+}
+#else
+bool AudioSampleFile::open(const SystemChar* path) {
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    Log.report(logvisor::Error, FMT_STRING("unable to open '{}': {}"), path, strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) || !st.st_size) {
+    ::close(fd);
+    return false;
+  }
+
+  void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    Log.report(logvisor::Error, FMT_STRING("unable to mmap '{}': {}"), path, strerror(errno));
+    return false;
+  }
+  m_view = view;
+  m_viewSize = size_t(st.st_size);
+
+  if (!_parse()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void AudioSampleFile::close() {
+  if (m_view)
+    munmap(m_view, m_viewSize);
+  m_view = nullptr;
+  m_viewSize = 0;
+  m_sample = {};
+}
+#endif
+
+} // namespace boo
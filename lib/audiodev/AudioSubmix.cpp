@@ -1,4 +1,5 @@
 #include "lib/audiodev/AudioSubmix.hpp"
+#include "lib/audiodev/AudioSubmixTap.hpp"
 #include "lib/audiodev/AudioVoice.hpp"
 #include "lib/audiodev/AudioVoiceEngine.hpp"
 
@@ -15,7 +16,11 @@ AudioSubmix::AudioSubmix(BaseAudioVoiceEngine& root, IAudioSubmixCallback* cb, i
     setSendLevel(m_head->m_mainSubmix.get(), 1.f, false);
 }
 
-AudioSubmix::~AudioSubmix() { m_head->m_submixesDirty = true; }
+AudioSubmix::~AudioSubmix() {
+  m_head->m_submixesDirty = true;
+  for (AudioSubmixTap* tap : m_taps)
+    tap->m_submix = nullptr;
+}
 
 AudioSubmix*& AudioSubmix::_getHeadPtr(BaseAudioVoiceEngine* head) { return head->m_submixHead; }
 std::unique_lock<std::recursive_mutex> AudioSubmix::_getHeadLock(BaseAudioVoiceEngine* head) {
@@ -65,79 +70,62 @@ std::list<AudioSubmix*> AudioSubmix::_linearizeC3() {
   return ret;
 }
 
-template <typename T>
 void AudioSubmix::_zeroFill() {
-  if (_getScratch<T>().size())
-    std::fill(_getScratch<T>().begin(), _getScratch<T>().end(), 0);
+  if (m_scratch.size())
+    std::fill(m_scratch.begin(), m_scratch.end(), 0.f);
 }
 
-template void AudioSubmix::_zeroFill<int16_t>();
-template void AudioSubmix::_zeroFill<int32_t>();
-template void AudioSubmix::_zeroFill<float>();
-
-template <typename T>
-T* AudioSubmix::_getMergeBuf(size_t frames) {
-  if (_getRedirect<T>())
-    return _getRedirect<T>();
+float* AudioSubmix::_getMergeBuf(size_t frames) {
+  if (m_redirect)
+    return m_redirect;
 
   size_t sampleCount = frames * m_head->clientMixInfo().m_channelMap.m_channelCount;
-  if (_getScratch<T>().size() < sampleCount)
-    _getScratch<T>().resize(sampleCount);
+  if (m_scratch.size() < sampleCount)
+    m_scratch.resize(sampleCount);
 
-  return _getScratch<T>().data();
+  return m_scratch.data();
 }
 
-template int16_t* AudioSubmix::_getMergeBuf<int16_t>(size_t frames);
-template int32_t* AudioSubmix::_getMergeBuf<int32_t>(size_t frames);
-template float* AudioSubmix::_getMergeBuf<float>(size_t frames);
-
-template <typename T>
-constexpr T ClampInt(float in) {
-  if (std::is_floating_point<T>()) {
-    return in; // Allow subsequent mixing stages to work with over-saturated values
-  } else {
-    constexpr T MAX = std::numeric_limits<T>::max();
-    constexpr T MIN = std::numeric_limits<T>::min();
-
-    if (in < MIN)
-      return MIN;
-    else if (in > static_cast<float>(MAX))
-      return MAX;
-    else
-      return in;
-  }
+bool AudioSubmix::_effectActive() const {
+  if (!m_cb || !m_cb->canApplyEffect())
+    return false;
+  return !m_head->m_bypassOptionalEffects || !m_cb->isEffectOptional();
 }
 
-template <typename T>
 size_t AudioSubmix::_pumpAndMix(size_t frames) {
   const ChannelMap& chMap = m_head->clientMixInfo().m_channelMap;
   size_t chanCount = chMap.m_channelCount;
 
-  if (_getRedirect<T>()) {
-    if (m_cb && m_cb->canApplyEffect())
-      m_cb->applyEffect(_getRedirect<T>(), frames, chMap, m_head->mixInfo().m_sampleRate);
-    _getRedirect<T>() += chanCount * frames;
+  if (m_redirect) {
+    if (_effectActive())
+      m_cb->applyEffect(m_redirect, frames, chMap, m_head->mixInfo().m_sampleRate);
+    for (AudioSubmixTap* tap : m_taps)
+      tap->_capture(m_redirect, frames, chanCount);
+    m_redirect += chanCount * frames;
   } else {
     size_t sampleCount = frames * chanCount;
-    if (_getScratch<T>().size() < sampleCount)
-      _getScratch<T>().resize(sampleCount);
-    if (m_cb && m_cb->canApplyEffect())
-      m_cb->applyEffect(_getScratch<T>().data(), frames, chMap, m_head->mixInfo().m_sampleRate);
-
+    if (m_scratch.size() < sampleCount)
+      m_scratch.resize(sampleCount);
+    if (_effectActive())
+      m_cb->applyEffect(m_scratch.data(), frames, chMap, m_head->mixInfo().m_sampleRate);
+    for (AudioSubmixTap* tap : m_taps)
+      tap->_capture(m_scratch.data(), frames, chanCount);
+
+    /* Bus headroom is unbounded in float; clamping is deferred to the output stage */
     size_t curSlewFrame = m_slewFrames;
     for (auto& smx : m_sendGains) {
       curSlewFrame = m_curSlewFrame;
       AudioSubmix& sm = *reinterpret_cast<AudioSubmix*>(smx.first);
-      auto it = _getScratch<T>().begin();
-      T* dataOut = sm._getMergeBuf<T>(frames);
+      auto it = m_scratch.begin();
+      float* dataOut = sm._getMergeBuf(frames);
 
       for (size_t f = 0; f < frames; ++f) {
         if (m_slewFrames && curSlewFrame < m_slewFrames) {
-          double t = curSlewFrame / double(m_slewFrames);
-          double omt = 1.0 - t;
+          float t = curSlewFrame / float(m_slewFrames);
+          float omt = 1.f - t;
 
           for (unsigned c = 0; c < chanCount; ++c) {
-            *dataOut = ClampInt<T>(*dataOut + *it * (smx.second[1] * t + smx.second[0] * omt));
+            *dataOut += *it * (smx.second[1] * t + smx.second[0] * omt);
             ++it;
             ++dataOut;
           }
@@ -145,7 +133,7 @@ size_t AudioSubmix::_pumpAndMix(size_t frames) {
           ++curSlewFrame;
         } else {
           for (unsigned c = 0; c < chanCount; ++c) {
-            *dataOut = ClampInt<T>(*dataOut + *it * smx.second[1]);
+            *dataOut += *it * smx.second[1];
             ++it;
             ++dataOut;
           }
@@ -158,11 +146,9 @@ size_t AudioSubmix::_pumpAndMix(size_t frames) {
   return frames;
 }
 
-template size_t AudioSubmix::_pumpAndMix<int16_t>(size_t frames);
-template size_t AudioSubmix::_pumpAndMix<int32_t>(size_t frames);
-template size_t AudioSubmix::_pumpAndMix<float>(size_t frames);
-
 void AudioSubmix::_resetOutputSampleRate() {
+  for (AudioSubmixTap* tap : m_taps)
+    tap->_reserve(m_head->m_5msFrames, m_head->clientMixInfo().m_channelMap.m_channelCount);
   if (m_cb)
     m_cb->resetOutputSampleRate(m_head->mixInfo().m_sampleRate);
 }
@@ -192,16 +178,19 @@ const AudioVoiceEngineMixInfo& AudioSubmix::mixInfo() const { return m_head->mix
 
 double AudioSubmix::getSampleRate() const { return mixInfo().m_sampleRate; }
 
-SubmixFormat AudioSubmix::getSampleFormat() const {
-  switch (mixInfo().m_sampleFormat) {
-  case SOXR_INT16_I:
-  default:
-    return SubmixFormat::Int16;
-  case SOXR_INT32_I:
-    return SubmixFormat::Int32;
-  case SOXR_FLOAT32_I:
-    return SubmixFormat::Float;
-  }
+SubmixFormat AudioSubmix::getSampleFormat() const { return SubmixFormat::Float; }
+
+ObjToken<IAudioSubmixTap> AudioSubmix::allocateTap(size_t blockCount) {
+  auto lk = _getHeadLock(m_head);
+  auto* tap = new AudioSubmixTap(*this, blockCount, m_head->m_5msFrames,
+                                 m_head->clientMixInfo().m_channelMap.m_channelCount);
+  m_taps.push_back(tap);
+  return {tap};
+}
+
+void AudioSubmix::_removeTap(AudioSubmixTap* tap) {
+  auto lk = _getHeadLock(m_head);
+  m_taps.erase(std::find(m_taps.begin(), m_taps.end(), tap));
 }
 
 } // namespace boo
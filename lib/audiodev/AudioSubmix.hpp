@@ -22,6 +22,7 @@ struct WAVOutVoiceEngine;
 namespace boo {
 class BaseAudioVoiceEngine;
 class AudioVoice;
+class AudioSubmixTap;
 struct AudioVoiceEngineMixInfo;
 /* Output gains for each mix-send/channel */
 
@@ -29,6 +30,7 @@ class AudioSubmix : public ListNode<AudioSubmix, BaseAudioVoiceEngine*, IAudioSu
   friend class BaseAudioVoiceEngine;
   friend class AudioVoiceMono;
   friend class AudioVoiceStereo;
+  friend class AudioSubmixTap;
   friend struct WASAPIAudioVoiceEngine;
   friend struct ::AudioUnitVoiceEngine;
   friend struct ::VSTVoiceEngine;
@@ -48,19 +50,15 @@ class AudioSubmix : public ListNode<AudioSubmix, BaseAudioVoiceEngine*, IAudioSu
   /* Output gains for each mix-send/channel */
   std::unordered_map<IAudioSubmix*, std::array<float, 2>> m_sendGains;
 
-  /* Temporary scratch buffers for accumulating submix audio */
-  std::vector<int16_t> m_scratch16;
-  std::vector<int32_t> m_scratch32;
-  std::vector<float> m_scratchFlt;
-  template <typename T>
-  std::vector<T>& _getScratch();
+  /* Temporary scratch buffer for accumulating submix audio (float mix bus) */
+  std::vector<float> m_scratch;
 
-  /* Override scratch buffers with alternate destination */
-  int16_t* m_redirect16 = nullptr;
-  int32_t* m_redirect32 = nullptr;
-  float* m_redirectFlt = nullptr;
-  template <typename T>
-  T*& _getRedirect();
+  /* Override scratch buffer with alternate destination */
+  float* m_redirect = nullptr;
+
+  /* Loopback captures fed after effects are applied */
+  std::vector<AudioSubmixTap*> m_taps;
+  void _removeTap(AudioSubmixTap* tap);
 
   /* C3-linearization support (to mitigate a potential diamond problem on 'clever' submix routes) */
   bool _isDirectDependencyOf(AudioSubmix* send);
@@ -68,15 +66,15 @@ class AudioSubmix : public ListNode<AudioSubmix, BaseAudioVoiceEngine*, IAudioSu
   static bool _mergeC3(std::list<AudioSubmix*>& output, std::vector<std::list<AudioSubmix*>>& lists);
 
   /* Fill scratch buffers with silence for new mix cycle */
-  template <typename T>
   void _zeroFill();
 
   /* Receive audio from a single voice / submix */
-  template <typename T>
-  T* _getMergeBuf(size_t frames);
+  float* _getMergeBuf(size_t frames);
+
+  /* Effect callback is ready and not bypassed by the engine's watchdog */
+  bool _effectActive() const;
 
   /* Mix scratch buffers into sends */
-  template <typename T>
   size_t _pumpAndMix(size_t frames);
 
   void _resetOutputSampleRate();
@@ -93,32 +91,7 @@ public:
   const AudioVoiceEngineMixInfo& mixInfo() const;
   double getSampleRate() const override;
   SubmixFormat getSampleFormat() const override;
+  ObjToken<IAudioSubmixTap> allocateTap(size_t blockCount) override;
 };
 
-template <>
-inline std::vector<int16_t>& AudioSubmix::_getScratch() {
-  return m_scratch16;
-}
-template <>
-inline std::vector<int32_t>& AudioSubmix::_getScratch() {
-  return m_scratch32;
-}
-template <>
-inline std::vector<float>& AudioSubmix::_getScratch() {
-  return m_scratchFlt;
-}
-
-template <>
-inline int16_t*& AudioSubmix::_getRedirect<int16_t>() {
-  return m_redirect16;
-}
-template <>
-inline int32_t*& AudioSubmix::_getRedirect<int32_t>() {
-  return m_redirect32;
-}
-template <>
-inline float*& AudioSubmix::_getRedirect<float>() {
-  return m_redirectFlt;
-}
-
 } // namespace boo
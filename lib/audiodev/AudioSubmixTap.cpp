@@ -0,0 +1,79 @@
+#include "lib/audiodev/AudioSubmixTap.hpp"
+#include "lib/audiodev/AudioSubmix.hpp"
+#include "lib/audiodev/AudioVoiceEngine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace boo {
+
+AudioSubmixTap::AudioSubmixTap(AudioSubmix& submix, size_t blockCount, size_t blockFrames, unsigned chanCount)
+: m_submix(&submix), m_blockSamples(blockFrames * chanCount) {
+  size_t count = 2;
+  while (count < blockCount)
+    count <<= 1;
+  m_mask = count - 1;
+  m_blocks = std::make_unique<AudioTapBlock[]>(count);
+  m_sampleData = std::make_unique<float[]>(count * m_blockSamples);
+  for (size_t i = 0; i < count; ++i)
+    m_blocks[i].m_samples = &m_sampleData[i * m_blockSamples];
+}
+
+AudioSubmixTap::~AudioSubmixTap() {
+  if (m_submix)
+    m_submix->_removeTap(this);
+}
+
+void AudioSubmixTap::_reserve(size_t blockFrames, unsigned chanCount) {
+  size_t blockSamples = blockFrames * chanCount;
+  if (blockSamples <= m_blockSamples)
+    return;
+  /* Blocks are repointed as they are next written, so unread blocks stay intact */
+  m_retiredData.push_back(std::move(m_sampleData));
+  m_sampleData = std::make_unique<float[]>((m_mask + 1) * blockSamples);
+  m_blockSamples = blockSamples;
+}
+
+void AudioSubmixTap::_capture(const float* samples, size_t frames, unsigned chanCount) {
+  uint64_t framePos = m_framePos;
+  m_framePos += frames;
+
+  size_t sampleCount = frames * chanCount;
+  size_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+  if (writeIdx - m_readIdx.load(std::memory_order_acquire) > m_mask) {
+    m_overruns.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  /* Normally reserved ahead by AudioSubmix::_resetOutputSampleRate() */
+  if (sampleCount > m_blockSamples)
+    _reserve(frames, chanCount);
+
+  AudioTapBlock& block = m_blocks[writeIdx & m_mask];
+  block.m_samples = &m_sampleData[(writeIdx & m_mask) * m_blockSamples];
+  block.m_framePos = framePos;
+  block.m_timestampNs = uint64_t(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+  block.m_frames = frames;
+  block.m_channelCount = chanCount;
+  std::memcpy(const_cast<float*>(block.m_samples), samples, sampleCount * sizeof(float));
+
+  m_writeIdx.store(writeIdx + 1, std::memory_order_release);
+}
+
+const AudioTapBlock* AudioSubmixTap::peekBlock() {
+  size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+  if (readIdx == m_writeIdx.load(std::memory_order_acquire))
+    return nullptr;
+  return &m_blocks[readIdx & m_mask];
+}
+
+void AudioSubmixTap::popBlock() {
+  size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+  if (readIdx != m_writeIdx.load(std::memory_order_acquire))
+    m_readIdx.store(readIdx + 1, std::memory_order_release);
+}
+
+} // namespace boo
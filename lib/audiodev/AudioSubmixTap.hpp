@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "boo/audiodev/IAudioSubmix.hpp"
+
+namespace boo {
+class AudioSubmix;
+
+/** Wait-free SPSC ring of preallocated interval blocks fed by AudioSubmix::_pumpAndMix() */
+class AudioSubmixTap : public IAudioSubmixTap {
+  friend class AudioSubmix;
+
+  /* Tapped submix; cleared if the submix is destroyed first */
+  AudioSubmix* m_submix;
+
+  size_t m_mask;
+  size_t m_blockSamples;
+  std::unique_ptr<AudioTapBlock[]> m_blocks;
+  std::unique_ptr<float[]> m_sampleData;
+
+  /* Storage outgrown by a sample rate or channel count increase; kept until destruction
+   * since the consumer may still be reading a block from it */
+  std::vector<std::unique_ptr<float[]>> m_retiredData;
+
+  /* Producer-only running frame position */
+  uint64_t m_framePos = 0;
+
+  /* Producer and consumer indices live on separate cache lines */
+  alignas(64) std::atomic<size_t> m_writeIdx = 0;
+  alignas(64) std::atomic<size_t> m_readIdx = 0;
+  std::atomic<uint64_t> m_overruns = 0;
+
+  /* Called from the mixing thread once per interval */
+  void _capture(const float* samples, size_t frames, unsigned chanCount);
+
+  /* Producer side: grow blocks to hold an interval of this size */
+  void _reserve(size_t blockFrames, unsigned chanCount);
+
+public:
+  AudioSubmixTap(AudioSubmix& submix, size_t blockCount, size_t blockFrames, unsigned chanCount);
+  ~AudioSubmixTap() override;
+
+  const AudioTapBlock* peekBlock() override;
+  void popBlock() override;
+  size_t getQueuedBlockCount() const override {
+    return m_writeIdx.load(std::memory_order_acquire) - m_readIdx.load(std::memory_order_relaxed);
+  }
+  uint64_t getOverrunCount() const override { return m_overruns.load(std::memory_order_relaxed); }
+};
+
+} // namespace boo
@@ -1,6 +1,7 @@
 #include "AudioVoice.hpp"
 #include "AudioVoiceEngine.hpp"
 #include "logvisor/logvisor.hpp"
+#include <algorithm>
 #include <cmath>
 
 namespace boo {
@@ -9,18 +10,252 @@ static logvisor::Module Log("boo::AudioVoice");
 static AudioMatrixMono DefaultMonoMtx;
 static AudioMatrixStereo DefaultStereoMtx;
 
-AudioVoice::AudioVoice(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, bool dynamicRate)
-: ListNode<AudioVoice, BaseAudioVoiceEngine*, IAudioVoice>(&root), m_cb(cb), m_dynamicRate(dynamicRate) {}
+AudioVoice::AudioVoice(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, unsigned channelCount, bool dynamicRate,
+                       AudioResamplerType resampler)
+: ListNode<AudioVoice, BaseAudioVoiceEngine*, IAudioVoice>(&root)
+, m_cb(cb)
+, m_channelCount(channelCount)
+, m_resamplerType(resampler)
+, m_dynamicRate(dynamicRate) {}
 
-AudioVoice::~AudioVoice() { soxr_delete(m_src); }
+AudioVoice::~AudioVoice() {
+  soxr_delete(m_src);
+  soxr_delete(m_srcStandby);
+}
 
 AudioVoice*& AudioVoice::_getHeadPtr(BaseAudioVoiceEngine* head) { return head->m_voiceHead; }
 std::unique_lock<std::recursive_mutex> AudioVoice::_getHeadLock(BaseAudioVoiceEngine* head) {
   return std::unique_lock<std::recursive_mutex>{head->m_dataMutex};
 }
 
+void AudioVoice::_resetSampleRate(double sampleRate) {
+  soxr_delete(m_src);
+  m_src = nullptr;
+  soxr_delete(m_srcStandby);
+  m_srcStandby = nullptr;
+
+  double rateOut = m_head->mixInfo().m_sampleRate;
+  m_sampleRateIn = sampleRate;
+  m_sampleRateOut = rateOut;
+  m_sampleRatio = m_sampleRateIn / m_sampleRateOut;
+  m_resetSampleRate = false;
+
+  m_bypassSRC = !m_dynamicRate && sampleRate == rateOut;
+  if (m_bypassSRC) {
+    m_interp.reset();
+    return;
+  }
+
+  if (m_resamplerType != AudioResamplerType::SoXR) {
+    if (!m_interp)
+      m_interp = std::make_unique<AudioResampler>(m_resamplerType, m_channelCount);
+    m_interp->reset();
+    m_interp->setRatio(m_sampleRatio, 0);
+    _setPitchRatio(m_pitchRatio, false);
+    return;
+  }
+
+  m_reducedSRC = m_head->m_watchdog.level() >= AudioQualityLevel::ReducedResampling;
+  m_src = _createSRC(m_reducedSRC);
+  if (!m_src)
+    return;
+  m_srcStandby = _createSRC(!m_reducedSRC);
+  m_srcHistory.resize(SRCHistoryFrames * m_channelCount);
+  m_srcHistoryPos = 0;
+  m_srcHistoryFill = 0;
+  m_srcReplayRemaining = 0;
+  _setPitchRatio(m_pitchRatio, false);
+}
+
+soxr_t AudioVoice::_createSRC(bool reduced) {
+  soxr_io_spec_t ioSpec = soxr_io_spec(SOXR_INT16_I, SOXR_FLOAT32_I);
+  soxr_quality_spec_t qSpec = soxr_quality_spec(reduced ? SOXR_LQ : SOXR_20_BITQ, m_dynamicRate ? SOXR_VR : 0);
+
+  soxr_error_t err;
+  soxr_t src = soxr_create(m_sampleRateIn, m_sampleRateOut, m_channelCount, &err, &ioSpec, &qSpec, nullptr);
+
+  if (!src) {
+    Log.report(logvisor::Fatal, FMT_STRING("unable to create soxr resampler: {}"), soxr_strerror(err));
+    return nullptr;
+  }
+
+  soxr_set_input_fn(src, soxr_input_fn_t(SRCInputFn), this, 0);
+  return src;
+}
+
+void AudioVoice::_swapSRC() {
+  bool reduced = !m_reducedSRC;
+  if (!reduced) {
+    /* Leaving the overload, so there is headroom to rebuild the stale full-quality filter */
+    soxr_delete(m_srcStandby);
+    m_srcStandby = _createSRC(false);
+    if (!m_srcStandby)
+      return;
+  }
+
+  double outgoingDelay = soxr_delay(m_src);
+  std::swap(m_src, m_srcStandby);
+  m_reducedSRC = reduced;
+  if (m_dynamicRate)
+    soxr_set_io_ratio(m_src, m_sampleRatio, 0);
+  _primeSRC(outgoingDelay);
+
+  if (!reduced) {
+    /* Unfed low-quality filter ready for the next overload */
+    soxr_delete(m_srcStandby);
+    m_srcStandby = _createSRC(true);
+  }
+}
+
+void AudioVoice::_primeSRC(double outgoingDelay) {
+  /* Replay the buffered input through the incoming filter and discard its output up to the
+   * frame the outgoing filter would have produced next. The incoming filter then continues
+   * from the live source with its history warm, instead of cutting in cold. */
+  m_srcReplayRemaining = m_srcHistoryFill;
+  m_srcReplayPos = (m_srcHistoryPos + SRCHistoryFrames - m_srcHistoryFill) % SRCHistoryFrames;
+  double skip = double(m_srcHistoryFill) / m_sampleRatio - outgoingDelay;
+  size_t discard = skip > 0.0 ? size_t(skip + 0.5) : 0;
+
+  std::vector<float>& scratch = m_head->m_scratchPre;
+  size_t chunk = scratch.size() / m_channelCount;
+  while (discard && chunk) {
+    size_t got = soxr_output(m_src, scratch.data(), std::min(discard, chunk));
+    if (!got)
+      break;
+    discard -= got;
+  }
+  m_srcReplayRemaining = 0;
+}
+
+void AudioVoice::_clearResampler() {
+  if (m_src) {
+    /* Only the active soxr has been fed; the standby is unfed, or rebuilt before it is swapped back in */
+    soxr_clear(m_src);
+    m_srcHistoryPos = 0;
+    m_srcHistoryFill = 0;
+    m_srcReplayRemaining = 0;
+  } else if (m_interp) {
+    m_interp->reset();
+  }
+}
+
+void AudioVoice::_recordSRCHistory(const int16_t* data, size_t frames) {
+  if (frames > SRCHistoryFrames) {
+    data += (frames - SRCHistoryFrames) * m_channelCount;
+    frames = SRCHistoryFrames;
+  }
+  m_srcHistoryFill = std::min(m_srcHistoryFill + frames, SRCHistoryFrames);
+  while (frames) {
+    size_t thisFrames = std::min(frames, SRCHistoryFrames - m_srcHistoryPos);
+    std::copy(data, data + thisFrames * m_channelCount, m_srcHistory.data() + m_srcHistoryPos * m_channelCount);
+    m_srcHistoryPos = (m_srcHistoryPos + thisFrames) % SRCHistoryFrames;
+    data += thisFrames * m_channelCount;
+    frames -= thisFrames;
+  }
+}
+
+size_t AudioVoice::SRCInputFn(AudioVoice* ctx, int16_t** data, size_t frames) {
+  if (ctx->m_srcReplayRemaining) {
+    size_t replay = std::min({frames, ctx->m_srcReplayRemaining, SRCHistoryFrames - ctx->m_srcReplayPos});
+    *data = ctx->m_srcHistory.data() + ctx->m_srcReplayPos * ctx->m_channelCount;
+    ctx->m_srcReplayPos = (ctx->m_srcReplayPos + replay) % SRCHistoryFrames;
+    ctx->m_srcReplayRemaining -= replay;
+    return replay;
+  }
+  size_t got = SRCCallback(ctx, data, frames);
+  ctx->_recordSRCHistory(*data, got);
+  return got;
+}
+
+void AudioVoice::_setSample(const AudioSampleData& sample, size_t startFrame) {
+  m_sample = sample;
+  m_sample.m_frameCount = std::min(m_sample.m_frameCount, AudioSampleDecoder::MaxFrames(m_sample));
+  m_sample.m_loopEnd = std::min(m_sample.m_loopEnd, m_sample.m_frameCount);
+  if (!m_sample.isLooped())
+    m_sample.m_loopStart = m_sample.m_loopEnd = 0;
+  m_sampleStart = std::min(startFrame, m_sample.m_frameCount);
+  m_samplePos = m_sampleStart;
+  m_sampleEnded = false;
+
+  if (m_sample.m_format != AudioSampleFormat::PCM16) {
+    m_decoder = std::make_unique<AudioSampleDecoder>(m_sample);
+    m_decoder->seek(m_sampleStart);
+  }
+}
+
+size_t AudioVoice::_supplySample(int16_t** data, size_t frames) {
+  if (m_decoder) {
+    size_t ret = m_decoder->supply(data, frames);
+    m_sampleEnded = !ret;
+    return ret;
+  }
+
+  size_t end = m_sample.isLooped() ? m_sample.m_loopEnd : m_sample.m_frameCount;
+  if (m_samplePos >= end) {
+    if (!m_sample.isLooped()) {
+      /* End of input; soxr flushes its remaining output */
+      m_sampleEnded = true;
+      return 0;
+    }
+    m_samplePos = m_sample.m_loopStart;
+  }
+
+  /* Hand the resampler a pointer straight into the sample storage */
+  size_t ret = std::min(frames, end - m_samplePos);
+  *data = const_cast<int16_t*>(static_cast<const int16_t*>(m_sample.m_data) + m_samplePos * m_channelCount);
+  m_samplePos += ret;
+  return ret;
+}
+
+size_t AudioVoice::SRCCallback(AudioVoice* ctx, int16_t** data, size_t frames) {
+  if (ctx->m_sample.m_data)
+    return ctx->_supplySample(data, frames);
+
+  std::vector<int16_t>& scratchIn = ctx->m_head->m_scratchIn;
+  size_t samples = frames * ctx->m_channelCount;
+  if (scratchIn.size() < samples)
+    scratchIn.resize(samples);
+  *data = scratchIn.data();
+  return ctx->m_cb->supplyAudio(*ctx, frames, scratchIn.data());
+}
+
+void AudioVoice::_skipSource(size_t frames) {
+  int16_t* dummy;
+  while (frames) {
+    size_t got = SRCCallback(this, &dummy, frames);
+    if (!got)
+      break;
+    frames -= std::min(got, frames);
+  }
+}
+
+size_t AudioVoice::_pullResampled(float* out, size_t frames) {
+  if (m_interp)
+    return m_interp->process(out, frames, AudioResampler::InputFn(SRCCallback), this);
+  if (!m_bypassSRC)
+    return m_src ? soxr_output(m_src, out, frames) : 0;
+
+  size_t done = 0;
+  while (done < frames) {
+    int16_t* in;
+    size_t got = SRCCallback(this, &in, frames - done);
+    if (!got)
+      break;
+    size_t samples = got * m_channelCount;
+    float* dst = out + done * m_channelCount;
+    for (size_t i = 0; i < samples; ++i)
+      dst[i] = in[i] * (1.f / 32768.f);
+    done += got;
+  }
+  return done;
+}
+
 void AudioVoice::_setPitchRatio(double ratio, bool slew) {
-  if (m_dynamicRate) {
+  if (m_dynamicRate && m_interp) {
+    /* Interpolators retune per output frame; no filter state to rebuild */
+    m_sampleRatio = ratio * m_sampleRateIn / m_sampleRateOut;
+    m_interp->setRatio(m_sampleRatio, slew ? m_head->m_5msFrames : 0);
+  } else if (m_dynamicRate && m_src) {
     m_sampleRatio = ratio * m_sampleRateIn / m_sampleRateOut;
     soxr_error_t err = soxr_set_io_ratio(m_src, m_sampleRatio, slew ? m_head->m_5msFrames : 0);
     if (err) {
@@ -32,9 +267,28 @@ void AudioVoice::_setPitchRatio(double ratio, bool slew) {
   m_setPitchRatio = false;
 }
 
+bool AudioVoice::_isVirtual() const { return m_priority < m_head->m_virtualPriority; }
+
 void AudioVoice::_midUpdate() {
+  if (m_restartSample) {
+    m_restartSample = false;
+    if (m_sampleEnded) {
+      /* Replay finished one-shot from its start offset; the resampler tail is discarded */
+      m_samplePos = m_sampleStart;
+      if (m_decoder)
+        m_decoder->seek(m_sampleStart);
+      m_sampleEnded = false;
+      if (!m_resetSampleRate)
+        _clearResampler();
+    }
+  }
   if (m_resetSampleRate)
     _resetSampleRate(m_deferredSampleRate);
+  else if (m_src && m_srcStandby && m_head->m_srcSwapBudget &&
+           m_reducedSRC != (m_head->m_watchdog.level() >= AudioQualityLevel::ReducedResampling)) {
+    --m_head->m_srcSwapBudget;
+    _swapSRC();
+  }
   if (m_setPitchRatio)
     _setPitchRatio(m_pitchRatio, m_slew);
 }
@@ -50,52 +304,21 @@ void AudioVoice::resetSampleRate(double sampleRate) {
   m_deferredSampleRate = sampleRate;
 }
 
-void AudioVoice::start() { m_running = true; }
+void AudioVoice::start() {
+  /* The mixing thread may still be draining the resampler; rewind there rather than here */
+  if (m_sample.m_data)
+    m_restartSample = true;
+  m_running = true;
+}
 
 void AudioVoice::stop() { m_running = false; }
 
-AudioVoiceMono::AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate)
-: AudioVoice(root, cb, dynamicRate) {
+AudioVoiceMono::AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate,
+                               AudioResamplerType resampler)
+: AudioVoice(root, cb, 1, dynamicRate, resampler) {
   _resetSampleRate(sampleRate);
 }
 
-void AudioVoiceMono::_resetSampleRate(double sampleRate) {
-  soxr_delete(m_src);
-
-  double rateOut = m_head->mixInfo().m_sampleRate;
-  soxr_datatype_t formatOut = m_head->mixInfo().m_sampleFormat;
-  soxr_io_spec_t ioSpec = soxr_io_spec(SOXR_INT16_I, formatOut);
-  soxr_quality_spec_t qSpec = soxr_quality_spec(SOXR_20_BITQ, m_dynamicRate ? SOXR_VR : 0);
-
-  soxr_error_t err;
-  m_src = soxr_create(sampleRate, rateOut, 1, &err, &ioSpec, &qSpec, nullptr);
-
-  if (err) {
-    Log.report(logvisor::Fatal, FMT_STRING("unable to create soxr resampler: {}"), soxr_strerror(err));
-    m_resetSampleRate = false;
-    return;
-  }
-
-  m_sampleRateIn = sampleRate;
-  m_sampleRateOut = rateOut;
-  m_sampleRatio = m_sampleRateIn / m_sampleRateOut;
-  soxr_set_input_fn(m_src, soxr_input_fn_t(SRCCallback), this, 0);
-  _setPitchRatio(m_pitchRatio, false);
-  m_resetSampleRate = false;
-}
-
-size_t AudioVoiceMono::SRCCallback(AudioVoiceMono* ctx, int16_t** data, size_t frames) {
-  std::vector<int16_t>& scratchIn = ctx->m_head->m_scratchIn;
-  if (scratchIn.size() < frames)
-    scratchIn.resize(frames);
-  *data = scratchIn.data();
-  if (ctx->m_silentOut) {
-    memset(scratchIn.data(), 0, frames * 2);
-    return frames;
-  } else
-    return ctx->m_cb->supplyAudio(*ctx, frames, scratchIn.data());
-}
-
 bool AudioVoiceMono::isSilent() const {
   if (m_sendMatrices.size()) {
     for (auto& mtx : m_sendMatrices)
@@ -107,42 +330,47 @@ bool AudioVoiceMono::isSilent() const {
   }
 }
 
-template <typename T>
-size_t AudioVoiceMono::_pumpAndMix(size_t frames) {
-  auto& scratchPre = m_head->_getScratchPre<T>();
+size_t AudioVoiceMono::pumpAndMix(size_t frames) {
+  auto& scratchPre = m_head->m_scratchPre;
   if (scratchPre.size() < frames)
     scratchPre.resize(frames + 2);
 
-  auto& scratchPost = m_head->_getScratchPost<T>();
+  auto& scratchPost = m_head->m_scratchPost;
   if (scratchPost.size() < frames)
     scratchPost.resize(frames + 2);
 
   double dt = frames / m_sampleRateOut;
-  m_cb->preSupplyAudio(*this, dt);
+  if (m_cb)
+    m_cb->preSupplyAudio(*this, dt);
   _midUpdate();
 
-  if (isSilent()) {
-    int16_t* dummy;
-    SRCCallback(this, &dummy, size_t(std::ceil(frames * m_sampleRatio)));
+  if (isSilent() || _isVirtual()) {
+    _skipSource(size_t(std::ceil(frames * m_sampleRatio)));
+    _checkSampleEnd(0, frames);
     return 0;
   }
 
-  size_t oDone = soxr_output(m_src, scratchPre.data(), frames);
+  size_t oDone = _pullResampled(scratchPre.data(), frames);
 
   if (oDone) {
+    /* Without a callback there is no routing step; mix the resampler output directly */
+    float* routed = m_cb ? scratchPost.data() : scratchPre.data();
     if (m_sendMatrices.size()) {
       for (auto& mtx : m_sendMatrices) {
         AudioSubmix& smx = *reinterpret_cast<AudioSubmix*>(mtx.first);
-        m_cb->routeAudio(oDone, 1, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
-        mtx.second.mixMonoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone), oDone);
+        if (m_cb)
+          m_cb->routeAudio(oDone, 1, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
+        mtx.second.mixMonoSampleData(m_head->clientMixInfo(), routed, smx._getMergeBuf(oDone), oDone);
       }
     } else {
       AudioSubmix& smx = *m_head->m_mainSubmix;
-      m_cb->routeAudio(oDone, 1, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
-      DefaultMonoMtx.mixMonoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone), oDone);
+      if (m_cb)
+        m_cb->routeAudio(oDone, 1, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
+      DefaultMonoMtx.mixMonoSampleData(m_head->clientMixInfo(), routed, smx._getMergeBuf(oDone), oDone);
     }
   }
 
+  _checkSampleEnd(oDone, frames);
   return oDone;
 }
 
@@ -175,49 +403,11 @@ void AudioVoiceMono::setStereoChannelLevels(IAudioSubmix* submix, const float co
 }
 
 AudioVoiceStereo::AudioVoiceStereo(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate,
-                                   bool dynamicRate)
-: AudioVoice(root, cb, dynamicRate) {
+                                   bool dynamicRate, AudioResamplerType resampler)
+: AudioVoice(root, cb, 2, dynamicRate, resampler) {
   _resetSampleRate(sampleRate);
 }
 
-void AudioVoiceStereo::_resetSampleRate(double sampleRate) {
-  soxr_delete(m_src);
-
-  double rateOut = m_head->mixInfo().m_sampleRate;
-  soxr_datatype_t formatOut = m_head->mixInfo().m_sampleFormat;
-  soxr_io_spec_t ioSpec = soxr_io_spec(SOXR_INT16_I, formatOut);
-  soxr_quality_spec_t qSpec = soxr_quality_spec(SOXR_20_BITQ, m_dynamicRate ? SOXR_VR : 0);
-
-  soxr_error_t err;
-  m_src = soxr_create(sampleRate, rateOut, 2, &err, &ioSpec, &qSpec, nullptr);
-
-  if (!m_src) {
-    Log.report(logvisor::Fatal, FMT_STRING("unable to create soxr resampler: {}"), soxr_strerror(err));
-    m_resetSampleRate = false;
-    return;
-  }
-
-  m_sampleRateIn = sampleRate;
-  m_sampleRateOut = rateOut;
-  m_sampleRatio = m_sampleRateIn / m_sampleRateOut;
-  soxr_set_input_fn(m_src, soxr_input_fn_t(SRCCallback), this, 0);
-  _setPitchRatio(m_pitchRatio, false);
-  m_resetSampleRate = false;
-}
-
-size_t AudioVoiceStereo::SRCCallback(AudioVoiceStereo* ctx, int16_t** data, size_t frames) {
-  std::vector<int16_t>& scratchIn = ctx->m_head->m_scratchIn;
-  size_t samples = frames * 2;
-  if (scratchIn.size() < samples)
-    scratchIn.resize(samples);
-  *data = scratchIn.data();
-  if (ctx->m_silentOut) {
-    memset(scratchIn.data(), 0, samples * 2);
-    return frames;
-  } else
-    return ctx->m_cb->supplyAudio(*ctx, frames, scratchIn.data());
-}
-
 bool AudioVoiceStereo::isSilent() const {
   if (m_sendMatrices.size()) {
     for (auto& mtx : m_sendMatrices)
@@ -229,45 +419,49 @@ bool AudioVoiceStereo::isSilent() const {
   }
 }
 
-template <typename T>
-size_t AudioVoiceStereo::_pumpAndMix(size_t frames) {
+size_t AudioVoiceStereo::pumpAndMix(size_t frames) {
   size_t samples = frames * 2;
 
-  auto& scratchPre = m_head->_getScratchPre<T>();
+  auto& scratchPre = m_head->m_scratchPre;
   if (scratchPre.size() < samples)
     scratchPre.resize(samples + 4);
 
-  auto& scratchPost = m_head->_getScratchPost<T>();
+  auto& scratchPost = m_head->m_scratchPost;
   if (scratchPost.size() < samples)
     scratchPost.resize(samples + 4);
 
   double dt = frames / m_sampleRateOut;
-  m_cb->preSupplyAudio(*this, dt);
+  if (m_cb)
+    m_cb->preSupplyAudio(*this, dt);
   _midUpdate();
 
-  if (isSilent()) {
-    int16_t* dummy;
-    SRCCallback(this, &dummy, size_t(std::ceil(frames * m_sampleRatio)));
+  if (isSilent() || _isVirtual()) {
+    _skipSource(size_t(std::ceil(frames * m_sampleRatio)));
+    _checkSampleEnd(0, frames);
     return 0;
   }
 
-  size_t oDone = soxr_output(m_src, scratchPre.data(), frames);
+  size_t oDone = _pullResampled(scratchPre.data(), frames);
 
   if (oDone) {
+    /* Without a callback there is no routing step; mix the resampler output directly */
+    float* routed = m_cb ? scratchPost.data() : scratchPre.data();
     if (m_sendMatrices.size()) {
       for (auto& mtx : m_sendMatrices) {
         AudioSubmix& smx = *reinterpret_cast<AudioSubmix*>(mtx.first);
-        m_cb->routeAudio(oDone, 2, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
-        mtx.second.mixStereoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone), oDone);
+        if (m_cb)
+          m_cb->routeAudio(oDone, 2, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
+        mtx.second.mixStereoSampleData(m_head->clientMixInfo(), routed, smx._getMergeBuf(oDone), oDone);
       }
     } else {
       AudioSubmix& smx = *m_head->m_mainSubmix;
-      m_cb->routeAudio(oDone, 2, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
-      DefaultStereoMtx.mixStereoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone),
-                                           oDone);
+      if (m_cb)
+        m_cb->routeAudio(oDone, 2, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
+      DefaultStereoMtx.mixStereoSampleData(m_head->clientMixInfo(), routed, smx._getMergeBuf(oDone), oDone);
     }
   }
 
+  _checkSampleEnd(oDone, frames);
   return oDone;
 }
 
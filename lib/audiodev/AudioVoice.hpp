@@ -1,10 +1,13 @@
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
 #include "boo/audiodev/IAudioVoice.hpp"
 #include "lib/audiodev/AudioMatrix.hpp"
+#include "lib/audiodev/AudioResampler.hpp"
+#include "lib/audiodev/AudioSampleDecoder.hpp"
 #include "lib/audiodev/AudioVoiceEngine.hpp"
 #include "lib/audiodev/Common.hpp"
 
@@ -31,19 +34,62 @@ protected:
   /* Callback (audio source) */
   IAudioVoiceCallback* m_cb;
 
-  /* Sample-rate converter */
+  /* Interleaved channel count of source audio */
+  unsigned m_channelCount;
+
+  /* Sample-rate converter; either soxr or a built-in interpolator */
+  AudioResamplerType m_resamplerType;
   soxr_t m_src = nullptr;
+  std::unique_ptr<AudioResampler> m_interp;
   double m_sampleRateIn;
   double m_sampleRateOut;
   bool m_dynamicRate;
 
+  /* Fixed-rate voices matching the output rate skip the resampler entirely */
+  bool m_bypassSRC = false;
+
+  /* soxr was built with low-quality filters at the watchdog's request */
+  bool m_reducedSRC = false;
+
+  /* soxr of the other quality, so a watchdog switch into reduced resampling never allocates
+   * while the engine is overloaded. A low-quality standby has never been fed. */
+  soxr_t m_srcStandby = nullptr;
+  soxr_t _createSRC(bool reduced);
+  void _swapSRC();
+
+  /* Recent soxr input, replayed into the incoming filter on a switch so it picks up mid-stream */
+  static constexpr size_t SRCHistoryFrames = 512;
+  std::vector<int16_t> m_srcHistory;
+  size_t m_srcHistoryPos = 0;
+  size_t m_srcHistoryFill = 0;
+  size_t m_srcReplayPos = 0;
+  size_t m_srcReplayRemaining = 0;
+  void _recordSRCHistory(const int16_t* data, size_t frames);
+  /* Discard resampler history for a restarted source, keeping the current instances */
+  void _clearResampler();
+  void _primeSRC(double outgoingDelay);
+  static size_t SRCInputFn(AudioVoice* ctx, int16_t** data, size_t frames);
+
+  /* Voices under the engine's virtualization threshold advance without mixing */
+  int m_priority = 0;
+  bool _isVirtual() const;
+
+  /* Built-in sample source; replaces IAudioVoiceCallback::supplyAudio when m_sample.m_data is set */
+  AudioSampleData m_sample;
+  size_t m_sampleStart = 0;
+  size_t m_samplePos = 0;
+  bool m_sampleEnded = false;
+  bool m_restartSample = false; /* Deferred replay from start(); handled in _midUpdate() */
+  std::unique_ptr<AudioSampleDecoder> m_decoder; /* Compressed formats only */
+  size_t _supplySample(int16_t** data, size_t frames);
+
   /* Running bool */
   bool m_running = false;
 
   /* Deferred sample-rate reset */
   bool m_resetSampleRate = false;
   double m_deferredSampleRate;
-  virtual void _resetSampleRate(double sampleRate) = 0;
+  void _resetSampleRate(double sampleRate);
 
   /* Deferred pitch ratio set */
   bool m_setPitchRatio = false;
@@ -55,57 +101,52 @@ protected:
   /* Mid-pump update */
   void _midUpdate();
 
-  virtual size_t pumpAndMix16(size_t frames) = 0;
-  virtual size_t pumpAndMix32(size_t frames) = 0;
-  virtual size_t pumpAndMixFlt(size_t frames) = 0;
-  template <typename T>
-  size_t pumpAndMix(size_t frames);
+  /* Pull source frames (soxr input function) */
+  static size_t SRCCallback(AudioVoice* ctx, int16_t** data, size_t requestedLen);
+
+  /* Advance source without producing output (silent voices) */
+  void _skipSource(size_t frames);
+
+  /* Produce interleaved float frames at the output rate */
+  size_t _pullResampled(float* out, size_t frames);
+
+  /* Stop once a non-looped sample has been fully played out */
+  void _checkSampleEnd(size_t oDone, size_t frames) {
+    if (m_sampleEnded && !m_restartSample && oDone < frames)
+      m_running = false;
+  }
 
-  AudioVoice(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, bool dynamicRate);
+  /* Resample and mix into the float bus of each routed submix */
+  virtual size_t pumpAndMix(size_t frames) = 0;
+
+  AudioVoice(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, unsigned channelCount, bool dynamicRate,
+             AudioResamplerType resampler);
 
 public:
   static AudioVoice*& _getHeadPtr(BaseAudioVoiceEngine* head);
   static std::unique_lock<std::recursive_mutex> _getHeadLock(BaseAudioVoiceEngine* head);
 
   ~AudioVoice() override;
+  void _setSample(const AudioSampleData& sample, size_t startFrame);
   void resetSampleRate(double sampleRate) override;
   void setPitchRatio(double ratio, bool slew) override;
+  void setPriority(int priority) override { m_priority = priority; }
   void start() override;
   void stop() override;
   double getSampleRateIn() const { return m_sampleRateIn; }
   double getSampleRateOut() const { return m_sampleRateOut; }
 };
 
-template <>
-inline size_t AudioVoice::pumpAndMix<int16_t>(size_t frames) {
-  return pumpAndMix16(frames);
-}
-template <>
-inline size_t AudioVoice::pumpAndMix<int32_t>(size_t frames) {
-  return pumpAndMix32(frames);
-}
-template <>
-inline size_t AudioVoice::pumpAndMix<float>(size_t frames) {
-  return pumpAndMixFlt(frames);
-}
-
 class AudioVoiceMono : public AudioVoice {
   std::unordered_map<IAudioSubmix*, AudioMatrixMono> m_sendMatrices;
-  bool m_silentOut = false;
-  void _resetSampleRate(double sampleRate) override;
-
-  static size_t SRCCallback(AudioVoiceMono* ctx, int16_t** data, size_t requestedLen);
 
   bool isSilent() const;
 
-  template <typename T>
-  size_t _pumpAndMix(size_t frames);
-  size_t pumpAndMix16(size_t frames) override { return _pumpAndMix<int16_t>(frames); }
-  size_t pumpAndMix32(size_t frames) override { return _pumpAndMix<int32_t>(frames); }
-  size_t pumpAndMixFlt(size_t frames) override { return _pumpAndMix<float>(frames); }
+  size_t pumpAndMix(size_t frames) override;
 
 public:
-  AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate);
+  AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate,
+                 AudioResamplerType resampler = AudioResamplerType::SoXR);
   void resetChannelLevels() override;
   void setMonoChannelLevels(IAudioSubmix* submix, const float coefs[8], bool slew) override;
   void setStereoChannelLevels(IAudioSubmix* submix, const float coefs[8][2], bool slew) override;
@@ -113,21 +154,14 @@ public:
 
 class AudioVoiceStereo : public AudioVoice {
   std::unordered_map<IAudioSubmix*, AudioMatrixStereo> m_sendMatrices;
-  bool m_silentOut = false;
-  void _resetSampleRate(double sampleRate) override;
-
-  static size_t SRCCallback(AudioVoiceStereo* ctx, int16_t** data, size_t requestedLen);
 
   bool isSilent() const;
 
-  template <typename T>
-  size_t _pumpAndMix(size_t frames);
-  size_t pumpAndMix16(size_t frames) override { return _pumpAndMix<int16_t>(frames); }
-  size_t pumpAndMix32(size_t frames) override { return _pumpAndMix<int32_t>(frames); }
-  size_t pumpAndMixFlt(size_t frames) override { return _pumpAndMix<float>(frames); }
+  size_t pumpAndMix(size_t frames) override;
 
 public:
-  AudioVoiceStereo(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate);
+  AudioVoiceStereo(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate,
+                   AudioResamplerType resampler = AudioResamplerType::SoXR);
   void resetChannelLevels() override;
   void setMonoChannelLevels(IAudioSubmix* submix, const float coefs[8], bool slew) override;
   void setStereoChannelLevels(IAudioSubmix* submix, const float coefs[8][2], bool slew) override;
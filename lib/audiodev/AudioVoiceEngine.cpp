@@ -1,28 +1,42 @@
 #include "lib/audiodev/AudioVoiceEngine.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstring>
+#include <type_traits>
 
 namespace boo {
 
 BaseAudioVoiceEngine::~BaseAudioVoiceEngine() {
   m_mainSubmix.reset();
+  for (MIDIEventQueue* queue : m_midiQueues)
+    queue->_disown();
+  for (MIDIEventQueue* queue : m_pendingMIDIQueueAdds)
+    queue->_disown();
   assert(m_voiceHead == nullptr && "Dangling voices detected");
   assert(m_submixHead == nullptr && "Dangling submixes detected");
 }
 
 template <typename T>
 void BaseAudioVoiceEngine::_pumpAndMixVoices(size_t frames, T* dataOut) {
-  if (dataOut)
-    memset(dataOut, 0, sizeof(T) * frames * m_mixInfo.m_channelMap.m_channelCount);
+  const unsigned chanCount = m_mixInfo.m_channelMap.m_channelCount;
+
+  if (m_watchdogConfigDirty.load(std::memory_order_acquire)) {
+    std::unique_lock<std::recursive_mutex> lk(m_dataMutex, std::try_to_lock);
+    if (lk) {
+      m_watchdog.setConfig(m_pendingWatchdogConfig);
+      m_watchdogConfigDirty.store(false, std::memory_order_relaxed);
+      _applyQualityLevel();
+    }
+  }
+  m_watchdog.beginPeriod();
 
   if (m_ltRtProcessing) {
     size_t sampleCount = m_5msFrames * 5;
-    if (_getLtRtIn<T>().size() < sampleCount)
-      _getLtRtIn<T>().resize(sampleCount);
-    m_mainSubmix->_getRedirect<T>() = _getLtRtIn<T>().data();
-  } else {
-    m_mainSubmix->_getRedirect<T>() = dataOut;
+    if (m_ltRtIn.size() < sampleCount)
+      m_ltRtIn.resize(sampleCount);
   }
 
   if (m_submixesDirty) {
@@ -30,57 +44,126 @@ void BaseAudioVoiceEngine::_pumpAndMixVoices(size_t frames, T* dataOut) {
     m_submixesDirty = false;
   }
 
+  /* Skipped for this pump if a queue is being created or destroyed; its events play late */
+  bool midi = false;
+  if (m_midiQueuesActive.load(std::memory_order_acquire)) {
+    std::unique_lock<std::mutex> lk(m_midiQueueLock, std::try_to_lock);
+    if (lk) {
+      _applyPendingMIDIQueues();
+      m_midiDelivering = midi = !m_midiQueues.empty();
+      m_midiDeliveryThread = std::this_thread::get_id();
+    }
+  }
+  if (midi)
+    _updateMIDIClock(frames);
+
   size_t remFrames = frames;
   while (remFrames) {
-    size_t thisFrames;
-    if (remFrames < m_5msFrames) {
-      thisFrames = remFrames;
-      if (m_engineCallback)
+    size_t thisFrames = std::min(remFrames, m_5msFrames);
+    if (midi) {
+      /* Events are played one pump period after they arrive */
+      double sampleRate = m_mixInfo.m_sampleRate;
+      double intervalTime = m_midiClockTime + (double(frames - remFrames) - double(m_midiPumpFrames)) / sampleRate;
+      for (MIDIEventQueue* queue : m_midiQueues)
+        queue->_deliver(intervalTime, sampleRate, thisFrames);
+    }
+
+    if (m_engineCallback) {
+      if (thisFrames < m_5msFrames)
         m_engineCallback->on5MsInterval(*this, thisFrames / double(m_5msFrames) * 5.0 / 1000.0);
-    } else {
-      thisFrames = m_5msFrames;
-      if (m_engineCallback)
+      else
         m_engineCallback->on5MsInterval(*this, 5.0 / 1000.0);
     }
 
-    if (m_ltRtProcessing)
-      std::fill(_getLtRtIn<T>().begin(), _getLtRtIn<T>().end(), 0.f);
+    /* Float backends are mixed in place; others go through the float mix buffer */
+    size_t sampleCount = thisFrames * chanCount;
+    float* mixOut = nullptr;
+    if (dataOut) {
+      if constexpr (std::is_same_v<T, float>) {
+        mixOut = dataOut;
+      } else {
+        if (m_mixBuffer.size() < sampleCount)
+          m_mixBuffer.resize(sampleCount);
+        mixOut = m_mixBuffer.data();
+      }
+      std::fill(mixOut, mixOut + sampleCount, 0.f);
+    }
+
+    if (m_ltRtProcessing) {
+      std::fill(m_ltRtIn.begin(), m_ltRtIn.end(), 0.f);
+      m_mainSubmix->m_redirect = m_ltRtIn.data();
+    } else {
+      m_mainSubmix->m_redirect = mixOut;
+    }
 
     for (auto it = m_linearizedSubmixes.rbegin(); it != m_linearizedSubmixes.rend(); ++it)
-      (*it)->_zeroFill<T>();
+      (*it)->_zeroFill();
 
+    m_srcSwapBudget = MaxSRCSwapsPerInterval;
     if (m_voiceHead)
       for (AudioVoice& vox : *m_voiceHead)
         if (vox.m_running)
-          vox.pumpAndMix<T>(thisFrames);
+          vox.pumpAndMix(thisFrames);
 
     for (auto it = m_linearizedSubmixes.rbegin(); it != m_linearizedSubmixes.rend(); ++it)
-      (*it)->_pumpAndMix<T>(thisFrames);
+      (*it)->_pumpAndMix(thisFrames);
 
     remFrames -= thisFrames;
     if (!dataOut)
       continue;
 
-    if (m_ltRtProcessing) {
-      m_ltRtProcessing->Process(_getLtRtIn<T>().data(), dataOut, int(thisFrames));
-      m_mainSubmix->_getRedirect<T>() = _getLtRtIn<T>().data();
-    }
+    if (m_ltRtProcessing)
+      m_ltRtProcessing->Process(m_ltRtIn.data(), mixOut, int(thisFrames));
 
-    size_t sampleCount = thisFrames * m_mixInfo.m_channelMap.m_channelCount;
-    for (size_t i = 0; i < sampleCount; ++i)
-      dataOut[i] *= m_totalVol;
+    m_outputStage.process(mixOut, dataOut, thisFrames, chanCount, m_totalVol);
 
     dataOut += sampleCount;
   }
 
+  m_mainSubmix->m_redirect = nullptr;
+
+  if (m_watchdog.endPeriod(frames, m_mixInfo.m_sampleRate)) {
+    _applyQualityLevel();
+    if (m_engineCallback)
+      m_engineCallback->onQualityLevelChanged(*this, m_watchdog.level(), m_watchdog.load());
+  }
+
   if (m_engineCallback)
     m_engineCallback->onPumpCycleComplete(*this);
+
+  if (midi) {
+    m_midiClockTime += frames / m_mixInfo.m_sampleRate;
+    std::lock_guard<std::mutex> lk(m_midiQueueLock);
+    m_midiDelivering = false;
+    _applyPendingMIDIQueues();
+    m_midiQueueCv.notify_all();
+  }
 }
 
 template void BaseAudioVoiceEngine::_pumpAndMixVoices<int16_t>(size_t frames, int16_t* dataOut);
 template void BaseAudioVoiceEngine::_pumpAndMixVoices<int32_t>(size_t frames, int32_t* dataOut);
 template void BaseAudioVoiceEngine::_pumpAndMixVoices<float>(size_t frames, float* dataOut);
 
+void BaseAudioVoiceEngine::_applyQualityLevel() {
+  /* Resampler quality is picked up by each voice on its next mid-pump update */
+  AudioQualityLevel level = m_watchdog.level();
+  m_virtualPriority = level >= AudioQualityLevel::VirtualVoices ? m_watchdog.config().m_virtualPriority : INT_MIN;
+  m_bypassOptionalEffects = level >= AudioQualityLevel::BypassEffects;
+}
+
+void BaseAudioVoiceEngine::_updateMIDIClock(size_t frames) {
+  /* Pumps are expected back-to-back in output time; the measured start only nudges the
+   * prediction so that scheduling jitter does not move events. A large error (first pump,
+   * xrun, device change) re-anchors the clock. */
+  double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  double error = now - m_midiClockTime;
+  if (m_midiClockTime < 0.0 || std::fabs(error) > 0.1)
+    m_midiClockTime = now;
+  else
+    m_midiClockTime += error * 0.05;
+  m_midiPumpFrames = std::max(m_midiPumpFrames, frames);
+}
+
 void BaseAudioVoiceEngine::_resetSampleRate() {
   if (m_voiceHead)
     for (boo::AudioVoice& vox : *m_voiceHead)
@@ -91,31 +174,105 @@ void BaseAudioVoiceEngine::_resetSampleRate() {
 }
 
 ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                                 bool dynamicPitch) {
-  return {new AudioVoiceMono(*this, cb, sampleRate, dynamicPitch)};
+                                                                 bool dynamicPitch, AudioResamplerType resampler) {
+  return {new AudioVoiceMono(*this, cb, sampleRate, dynamicPitch, resampler)};
 }
 
 ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                                   bool dynamicPitch) {
-  return {new AudioVoiceStereo(*this, cb, sampleRate, dynamicPitch)};
+                                                                   bool dynamicPitch, AudioResamplerType resampler) {
+  return {new AudioVoiceStereo(*this, cb, sampleRate, dynamicPitch, resampler)};
+}
+
+ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateNewSampleVoice(const AudioSampleData& sample, size_t startFrame,
+                                                                   IAudioVoiceCallback* cb, bool dynamicPitch,
+                                                                   AudioResamplerType resampler) {
+  if (!AudioSampleDecoder::MaxFrames(sample))
+    return {};
+
+  AudioVoice* ret;
+  if (sample.m_channelCount == 2)
+    ret = new AudioVoiceStereo(*this, cb, sample.m_sampleRate, dynamicPitch, resampler);
+  else
+    ret = new AudioVoiceMono(*this, cb, sample.m_sampleRate, dynamicPitch, resampler);
+  ret->_setSample(sample, startFrame);
+  return {ret};
 }
 
 ObjToken<IAudioSubmix> BaseAudioVoiceEngine::allocateNewSubmix(bool mainOut, IAudioSubmixCallback* cb, int busId) {
   return {new AudioSubmix(*this, cb, busId, mainOut)};
 }
 
+ObjToken<IAudioSubmixTap> BaseAudioVoiceEngine::allocateMainMixTap(size_t blockCount) {
+  return m_mainSubmix->allocateTap(blockCount);
+}
+
 void BaseAudioVoiceEngine::setCallbackInterface(IAudioVoiceEngineCallback* cb) { m_engineCallback = cb; }
 
+void BaseAudioVoiceEngine::setQualityWatchdog(const AudioWatchdogConfig& config) {
+  std::unique_lock<std::recursive_mutex> lk(m_dataMutex);
+  m_pendingWatchdogConfig = config;
+  m_watchdogConfigDirty.store(true, std::memory_order_release);
+}
+
 void BaseAudioVoiceEngine::setVolume(float vol) { m_totalVol = vol; }
 
 bool BaseAudioVoiceEngine::enableLtRt(bool enable) {
-  if (enable && m_mixInfo.m_channelMap.m_channelCount == 2 && m_mixInfo.m_channels == AudioChannelSet::Stereo)
-    m_ltRtProcessing = std::make_unique<LtRtProcessing>(m_5msFrames, m_mixInfo);
-  else
+  if (enable && m_mixInfo.m_channelMap.m_channelCount == 2 && m_mixInfo.m_channels == AudioChannelSet::Stereo) {
+    /* Encoder sits on the float mix bus ahead of the output stage */
+    AudioVoiceEngineMixInfo busInfo = m_mixInfo;
+    busInfo.m_sampleFormat = SOXR_FLOAT32_I;
+    busInfo.m_bitsPerSample = 32;
+    m_ltRtProcessing = std::make_unique<LtRtProcessing>(m_5msFrames, busInfo);
+  } else
     m_ltRtProcessing.reset();
   return m_ltRtProcessing.operator bool();
 }
 
+void BaseAudioVoiceEngine::_applyPendingMIDIQueues() {
+  for (MIDIEventQueue* queue : m_pendingMIDIQueueAdds)
+    m_midiQueues.push_back(queue);
+  for (MIDIEventQueue* queue : m_pendingMIDIQueueRemoves)
+    m_midiQueues.erase(std::find(m_midiQueues.begin(), m_midiQueues.end(), queue));
+  m_pendingMIDIQueueAdds.clear();
+  m_pendingMIDIQueueRemoves.clear();
+  m_midiQueuesActive.store(!m_midiQueues.empty(), std::memory_order_release);
+}
+
+std::unique_ptr<MIDIEventQueue> BaseAudioVoiceEngine::newMIDIEventQueue(IMIDIReader& reader, size_t capacity) {
+  auto queue = std::make_unique<MIDIEventQueue>(*this, reader, capacity);
+  std::lock_guard<std::mutex> lk(m_midiQueueLock);
+  if (m_midiDelivering)
+    m_pendingMIDIQueueAdds.push_back(queue.get());
+  else
+    m_midiQueues.push_back(queue.get());
+  m_midiQueuesActive.store(true, std::memory_order_release);
+  return queue;
+}
+
+void BaseAudioVoiceEngine::_removeMIDIEventQueue(MIDIEventQueue* queue) {
+  std::unique_lock<std::mutex> lk(m_midiQueueLock);
+  auto pendingAdd = std::find(m_pendingMIDIQueueAdds.begin(), m_pendingMIDIQueueAdds.end(), queue);
+  if (pendingAdd != m_pendingMIDIQueueAdds.end()) {
+    /* Never reached the mixing thread */
+    m_pendingMIDIQueueAdds.erase(pendingAdd);
+    return;
+  }
+
+  if (m_midiDelivering && m_midiDeliveryThread != std::this_thread::get_id()) {
+    /* The pump releases the queue when it finishes delivering */
+    m_pendingMIDIQueueRemoves.push_back(queue);
+    m_midiQueueCv.wait(lk, [&]() {
+      return std::find(m_pendingMIDIQueueRemoves.begin(), m_pendingMIDIQueueRemoves.end(), queue) ==
+             m_pendingMIDIQueueRemoves.end();
+    });
+    return;
+  }
+
+  /* No pump is delivering, or this is the mixing thread between deliveries */
+  m_midiQueues.erase(std::find(m_midiQueues.begin(), m_midiQueues.end(), queue));
+  m_midiQueuesActive.store(!m_midiQueues.empty() || !m_pendingMIDIQueueAdds.empty(), std::memory_order_release);
+}
+
 const AudioVoiceEngineMixInfo& BaseAudioVoiceEngine::mixInfo() const { return m_mixInfo; }
 
 const AudioVoiceEngineMixInfo& BaseAudioVoiceEngine::clientMixInfo() const {
@@ -1,14 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <climits>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "boo/BooObject.hpp"
 #include "boo/audiodev/IAudioVoiceEngine.hpp"
+#include "boo/audiodev/MIDIEventQueue.hpp"
+#include "lib/audiodev/AudioOutputStage.hpp"
+#include "lib/audiodev/AudioQualityWatchdog.hpp"
 #include "lib/audiodev/AudioSubmix.hpp"
 #include "lib/audiodev/AudioVoice.hpp"
 #include "lib/audiodev/Common.hpp"
@@ -33,29 +40,55 @@ protected:
 
   /* Shared scratch buffers for accumulating audio data for resampling */
   std::vector<int16_t> m_scratchIn;
-  std::vector<int16_t> m_scratch16Pre;
-  std::vector<int32_t> m_scratch32Pre;
-  std::vector<float> m_scratchFltPre;
-  template <typename T>
-  std::vector<T>& _getScratchPre();
-  std::vector<int16_t> m_scratch16Post;
-  std::vector<int32_t> m_scratch32Post;
-  std::vector<float> m_scratchFltPost;
-  template <typename T>
-  std::vector<T>& _getScratchPost();
+  std::vector<float> m_scratchPre;
+  std::vector<float> m_scratchPost;
+
+  /* Voices and submixes always mix on a float bus; this holds one interval
+   * when the backend format differs so the output stage can convert it */
+  std::vector<float> m_mixBuffer;
+  AudioOutputStage m_outputStage;
 
   /* LtRt processing if enabled */
   std::unique_ptr<LtRtProcessing> m_ltRtProcessing;
-  std::vector<int16_t> m_ltRtIn16;
-  std::vector<int32_t> m_ltRtIn32;
-  std::vector<float> m_ltRtInFlt;
-  template <typename T>
-  std::vector<T>& _getLtRtIn();
+  std::vector<float> m_ltRtIn;
 
   std::unique_ptr<AudioSubmix> m_mainSubmix;
   std::list<AudioSubmix*> m_linearizedSubmixes;
   bool m_submixesDirty = true;
 
+  /* Deadline watchdog; configuration is handed over to the mixing thread */
+  AudioQualityWatchdog m_watchdog;
+  AudioWatchdogConfig m_pendingWatchdogConfig;
+  std::atomic_bool m_watchdogConfigDirty = false;
+
+  /* Degradations currently in effect (mixing thread only) */
+  int m_virtualPriority = INT_MIN;
+  bool m_bypassOptionalEffects = false;
+
+  /* Voices allowed to switch resampler quality in the current interval; spreads the priming
+   * work of a quality change over several intervals */
+  static constexpr unsigned MaxSRCSwapsPerInterval = 4;
+  unsigned m_srcSwapBudget = 0;
+  void _applyQualityLevel();
+
+  /* MIDI event queues replayed at the start of each interval, and the smoothed monotonic
+   * time at which the next pump's first frame is mixed (negative until the first pump).
+   * While a pump is delivering, only the mixing thread touches m_midiQueues; queues created
+   * or destroyed meanwhile go through the pending lists, and a destroyed queue waits for the
+   * pump to let go of it. */
+  std::vector<MIDIEventQueue*> m_midiQueues;
+  std::mutex m_midiQueueLock;
+  std::condition_variable m_midiQueueCv;
+  std::vector<MIDIEventQueue*> m_pendingMIDIQueueAdds;
+  std::vector<MIDIEventQueue*> m_pendingMIDIQueueRemoves;
+  std::atomic_bool m_midiQueuesActive = false;
+  bool m_midiDelivering = false;
+  std::thread::id m_midiDeliveryThread;
+  void _applyPendingMIDIQueues();
+  double m_midiClockTime = -1.0;
+  size_t m_midiPumpFrames = 0;
+  void _updateMIDIClock(size_t frames);
+
   template <typename T>
   void _pumpAndMixVoices(size_t frames, T* dataOut);
 
@@ -64,16 +97,25 @@ protected:
 public:
   BaseAudioVoiceEngine() : m_mainSubmix(std::make_unique<AudioSubmix>(*this, nullptr, -1, false)) {}
   ~BaseAudioVoiceEngine() override;
-  ObjToken<IAudioVoice> allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                             bool dynamicPitch = false) override;
+  ObjToken<IAudioVoice> allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb, bool dynamicPitch = false,
+                                             AudioResamplerType resampler = AudioResamplerType::SoXR) override;
 
-  ObjToken<IAudioVoice> allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                               bool dynamicPitch = false) override;
+  ObjToken<IAudioVoice> allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb, bool dynamicPitch = false,
+                                               AudioResamplerType resampler = AudioResamplerType::SoXR) override;
+
+  ObjToken<IAudioVoice> allocateNewSampleVoice(const AudioSampleData& sample, size_t startFrame = 0,
+                                               IAudioVoiceCallback* cb = nullptr, bool dynamicPitch = false,
+                                               AudioResamplerType resampler = AudioResamplerType::SoXR) override;
 
   ObjToken<IAudioSubmix> allocateNewSubmix(bool mainOut, IAudioSubmixCallback* cb, int busId) override;
 
+  ObjToken<IAudioSubmixTap> allocateMainMixTap(size_t blockCount) override;
+
   void setCallbackInterface(IAudioVoiceEngineCallback* cb) override;
 
+  void setQualityWatchdog(const AudioWatchdogConfig& config) override;
+  AudioQualityLevel getQualityLevel() const override { return m_watchdog.level(); }
+
   void setVolume(float vol) override;
   bool enableLtRt(bool enable) override;
   const AudioVoiceEngineMixInfo& mixInfo() const;
@@ -81,45 +123,9 @@ public:
   AudioChannelSet getAvailableSet() override { return clientMixInfo().m_channels; }
   void pumpAndMixVoices() override {}
   size_t get5MsFrames() const override { return m_5msFrames; }
-};
 
-template <>
-inline std::vector<int16_t>& BaseAudioVoiceEngine::_getScratchPre<int16_t>() {
-  return m_scratch16Pre;
-}
-template <>
-inline std::vector<int32_t>& BaseAudioVoiceEngine::_getScratchPre<int32_t>() {
-  return m_scratch32Pre;
-}
-template <>
-inline std::vector<float>& BaseAudioVoiceEngine::_getScratchPre<float>() {
-  return m_scratchFltPre;
-}
-
-template <>
-inline std::vector<int16_t>& BaseAudioVoiceEngine::_getScratchPost<int16_t>() {
-  return m_scratch16Post;
-}
-template <>
-inline std::vector<int32_t>& BaseAudioVoiceEngine::_getScratchPost<int32_t>() {
-  return m_scratch32Post;
-}
-template <>
-inline std::vector<float>& BaseAudioVoiceEngine::_getScratchPost<float>() {
-  return m_scratchFltPost;
-}
-
-template <>
-inline std::vector<int16_t>& BaseAudioVoiceEngine::_getLtRtIn<int16_t>() {
-  return m_ltRtIn16;
-}
-template <>
-inline std::vector<int32_t>& BaseAudioVoiceEngine::_getLtRtIn<int32_t>() {
-  return m_ltRtIn32;
-}
-template <>
-inline std::vector<float>& BaseAudioVoiceEngine::_getLtRtIn<float>() {
-  return m_ltRtInFlt;
-}
+  std::unique_ptr<MIDIEventQueue> newMIDIEventQueue(IMIDIReader& reader, size_t capacity = 1024) override;
+  void _removeMIDIEventQueue(MIDIEventQueue* queue);
+};
 
 } // namespace boo
@@ -111,7 +111,7 @@ struct LinuxMidi : BaseAudioVoiceEngine {
 
       int oldtype;
       pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldtype);
-      receiver(std::vector<uint8_t>(std::cbegin(buf), std::cbegin(buf) + rdBytes), TimespecToDouble(ts));
+      receiver(buf, size_t(rdBytes), TimespecToDouble(ts));
       pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &oldtype);
       pthread_testcancel();
     }
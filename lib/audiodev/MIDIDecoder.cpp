@@ -11,8 +11,8 @@ namespace boo {
 namespace {
 constexpr uint8_t clamp7(uint8_t val) { return std::clamp(val, uint8_t{0}, uint8_t{127}); }
 
-std::optional<uint32_t> readContinuedValue(std::vector<uint8_t>::const_iterator& it,
-                                           std::vector<uint8_t>::const_iterator end) {
+template <typename It>
+std::optional<uint32_t> readContinuedValue(It& it, It end) {
   uint8_t a = *it++;
   uint32_t valOut = a & 0x7f;
 
@@ -38,8 +38,8 @@ std::optional<uint32_t> readContinuedValue(std::vector<uint8_t>::const_iterator&
 }
 } // Anonymous namespace
 
-std::vector<uint8_t>::const_iterator MIDIDecoder::receiveBytes(std::vector<uint8_t>::const_iterator begin,
-                                                               std::vector<uint8_t>::const_iterator end) {
+template <typename It>
+It MIDIDecoder::_receive(It begin, It end) {
   auto it = begin;
   while (it != end) {
     uint8_t a = *it++;
@@ -132,6 +132,7 @@ std::vector<uint8_t>::const_iterator MIDIDecoder::receiveBytes(std::vector<uint8
             return begin;
           }
           m_out.sysex(&*it, *len);
+          it += *len;
           break;
         }
         case Status::TimecodeQuarterFrame: {
@@ -189,4 +190,11 @@ std::vector<uint8_t>::const_iterator MIDIDecoder::receiveBytes(std::vector<uint8
   return it;
 }
 
+const uint8_t* MIDIDecoder::receiveBytes(const uint8_t* begin, const uint8_t* end) { return _receive(begin, end); }
+
+std::vector<uint8_t>::const_iterator MIDIDecoder::receiveBytes(std::vector<uint8_t>::const_iterator begin,
+                                                               std::vector<uint8_t>::const_iterator end) {
+  return _receive(begin, end);
+}
+
 } // namespace boo
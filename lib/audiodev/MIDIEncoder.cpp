@@ -1,6 +1,8 @@
 #include "boo/audiodev/MIDIEncoder.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 #include "boo/audiodev/IMIDIPort.hpp"
 #include "lib/audiodev/MIDICommon.hpp"
@@ -14,13 +16,66 @@ constexpr auto MakeCommand(Args&&... args) -> std::array<uint8_t, sizeof...(Args
 } // Anonymous namespace
 
 template <class Sender>
-void MIDIEncoder<Sender>::_sendMessage(const uint8_t* data, size_t len) {
-  if (data[0] == m_status)
-    m_sender.send(data + 1, len - 1);
-  else {
-    if (data[0] & 0x80)
-      m_status = data[0];
+void MIDIEncoder<Sender>::setBuffered(size_t flushBytes, double maxLatency) {
+  m_buffered = true;
+  m_flushBytes = std::clamp(flushBytes, size_t{1}, BufferBytes);
+  m_maxLatency = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(maxLatency));
+}
+
+template <class Sender>
+void MIDIEncoder<Sender>::setUnbuffered() {
+  flush();
+  m_buffered = false;
+}
+
+template <class Sender>
+void MIDIEncoder<Sender>::flush() {
+  if (!m_pending)
+    return;
+  m_sender.send(m_buffer, m_pending);
+  m_pending = 0;
+}
+
+template <class Sender>
+void MIDIEncoder<Sender>::_send(const void* data, size_t len) {
+  if (!m_buffered) {
     m_sender.send(data, len);
+    return;
+  }
+
+  if (m_pending + len > BufferBytes)
+    flush();
+  if (len > BufferBytes) {
+    /* Large sysex payloads go straight out */
+    m_sender.send(data, len);
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (!m_pending)
+    m_firstPending = now;
+  std::memcpy(m_buffer + m_pending, data, len);
+  m_pending += len;
+  if (m_pending >= m_flushBytes || now - m_firstPending >= m_maxLatency)
+    flush();
+}
+
+template <class Sender>
+void MIDIEncoder<Sender>::_sendMessage(const uint8_t* data, size_t len) {
+  uint8_t status = data[0];
+  if (status >= 0xf8) {
+    /* Real-time messages may interleave anywhere and leave running status alone */
+    _send(data, len);
+  } else if (status >= 0xf0) {
+    /* System common messages cancel running status */
+    m_status = 0;
+    _send(data, len);
+  } else if (status == m_status) {
+    _send(data + 1, len - 1);
+  } else {
+    m_status = status;
+    _send(data, len);
   }
 }
 
@@ -48,7 +103,7 @@ void MIDIEncoder<Sender>::_sendContinuedValue(uint32_t val) {
   send[2] = val & 0x7f;
 
   const size_t sendLength = send.size() - (ptr - send.data());
-  m_sender.send(ptr, sendLength);
+  _send(ptr, sendLength);
 }
 
 template <class Sender>
@@ -140,7 +195,7 @@ void MIDIEncoder<Sender>::sysex(const void* data, size_t len) {
   _sendMessage(sysexCmd);
 
   _sendContinuedValue(len);
-  m_sender.send(data, len);
+  _send(data, len);
 
   constexpr auto sysexTermCmd = MakeCommand(uint8_t(Status::SysExTerm));
   _sendMessage(sysexTermCmd);
@@ -149,7 +204,7 @@ void MIDIEncoder<Sender>::sysex(const void* data, size_t len) {
 template <class Sender>
 void MIDIEncoder<Sender>::timeCodeQuarterFrame(uint8_t message, uint8_t value) {
   const auto cmd =
-      MakeCommand(uint8_t(int(Status::TimecodeQuarterFrame)), uint8_t((message & 0x7 << 4) | (value & 0xf)));
+      MakeCommand(uint8_t(int(Status::TimecodeQuarterFrame)), uint8_t(((message & 0x7) << 4) | (value & 0xf)));
   _sendMessage(cmd);
 }
 
@@ -162,7 +217,7 @@ void MIDIEncoder<Sender>::songPositionPointer(uint16_t pointer) {
 
 template <class Sender>
 void MIDIEncoder<Sender>::songSelect(uint8_t song) {
-  const auto cmd = MakeCommand(uint8_t(int(Status::TimecodeQuarterFrame)), uint8_t(song & 0x7f));
+  const auto cmd = MakeCommand(uint8_t(int(Status::SongSelect)), uint8_t(song & 0x7f));
   _sendMessage(cmd);
 }
 
@@ -0,0 +1,247 @@
+#include "boo/audiodev/MIDIEventQueue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "boo/audiodev/IMIDIReader.hpp"
+#include "boo/audiodev/MIDIDecoder.hpp"
+#include "lib/audiodev/AudioVoiceEngine.hpp"
+
+namespace boo {
+namespace {
+enum class EventKind : uint8_t {
+  NoteOff,
+  NoteOn,
+  NotePressure,
+  ControlChange,
+  ProgramChange,
+  ChannelPressure,
+  PitchBend,
+  AllSoundOff,
+  ResetAllControllers,
+  LocalControl,
+  AllNotesOff,
+  OmniMode,
+  PolyMode,
+  SysEx,
+  TimeCodeQuarterFrame,
+  SongPositionPointer,
+  SongSelect,
+  TuneRequest,
+  StartSeq,
+  ContinueSeq,
+  StopSeq,
+  Reset,
+};
+
+constexpr size_t SysexRingBytes = 4 * MIDIEventQueue::MaxSysexBytes;
+
+double MonotonicSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // Anonymous namespace
+
+/* Decodes on the receive thread and records each message into the ring */
+class MIDIEventQueue::Producer : public IMIDIReader {
+  MIDIEventQueue& m_queue;
+  MIDIDecoder m_decoder;
+  double m_time = 0.0;
+
+  void _push(EventKind kind, uint8_t chan = 0, uint8_t a = 0, uint8_t b = 0, uint16_t value = 0) {
+    m_queue._push({m_time, 0, 0, value, uint8_t(kind), chan, a, b}, nullptr);
+  }
+
+public:
+  explicit Producer(MIDIEventQueue& queue) : m_queue(queue), m_decoder(*this) {}
+
+  void receive(const uint8_t* data, size_t len) {
+    /* Arrival order is delivery order; keep times monotonic */
+    m_time = std::max(m_time, MonotonicSeconds());
+    m_decoder.receiveBytes(data, data + len);
+  }
+
+  void noteOff(uint8_t chan, uint8_t key, uint8_t velocity) override { _push(EventKind::NoteOff, chan, key, velocity); }
+  void noteOn(uint8_t chan, uint8_t key, uint8_t velocity) override { _push(EventKind::NoteOn, chan, key, velocity); }
+  void notePressure(uint8_t chan, uint8_t key, uint8_t pressure) override {
+    _push(EventKind::NotePressure, chan, key, pressure);
+  }
+  void controlChange(uint8_t chan, uint8_t control, uint8_t value) override {
+    _push(EventKind::ControlChange, chan, control, value);
+  }
+  void programChange(uint8_t chan, uint8_t program) override { _push(EventKind::ProgramChange, chan, program); }
+  void channelPressure(uint8_t chan, uint8_t pressure) override { _push(EventKind::ChannelPressure, chan, pressure); }
+  void pitchBend(uint8_t chan, int16_t pitch) override { _push(EventKind::PitchBend, chan, 0, 0, uint16_t(pitch)); }
+
+  void allSoundOff(uint8_t chan) override { _push(EventKind::AllSoundOff, chan); }
+  void resetAllControllers(uint8_t chan) override { _push(EventKind::ResetAllControllers, chan); }
+  void localControl(uint8_t chan, bool on) override { _push(EventKind::LocalControl, chan, on); }
+  void allNotesOff(uint8_t chan) override { _push(EventKind::AllNotesOff, chan); }
+  void omniMode(uint8_t chan, bool on) override { _push(EventKind::OmniMode, chan, on); }
+  void polyMode(uint8_t chan, bool on) override { _push(EventKind::PolyMode, chan, on); }
+
+  void sysex(const void* data, size_t len) override {
+    if (len > MaxSysexBytes) {
+      m_queue.m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    m_queue._push({m_time, 0, uint32_t(len), 0, uint8_t(EventKind::SysEx), 0, 0, 0}, data);
+  }
+  void timeCodeQuarterFrame(uint8_t message, uint8_t value) override {
+    _push(EventKind::TimeCodeQuarterFrame, 0, message, value);
+  }
+  void songPositionPointer(uint16_t pointer) override { _push(EventKind::SongPositionPointer, 0, 0, 0, pointer); }
+  void songSelect(uint8_t song) override { _push(EventKind::SongSelect, 0, song); }
+  void tuneRequest() override { _push(EventKind::TuneRequest); }
+
+  void startSeq() override { _push(EventKind::StartSeq); }
+  void continueSeq() override { _push(EventKind::ContinueSeq); }
+  void stopSeq() override { _push(EventKind::StopSeq); }
+
+  void reset() override { _push(EventKind::Reset); }
+};
+
+MIDIEventQueue::MIDIEventQueue(BaseAudioVoiceEngine& parent, IMIDIReader& reader, size_t capacity)
+: m_parent(&parent), m_reader(reader), m_producer(std::make_unique<Producer>(*this)) {
+  size_t count = 2;
+  while (count < capacity)
+    count <<= 1;
+  m_mask = count - 1;
+  m_events = std::make_unique<Event[]>(count);
+  m_sysexMask = SysexRingBytes - 1;
+  m_sysexData = std::make_unique<uint8_t[]>(SysexRingBytes);
+}
+
+MIDIEventQueue::~MIDIEventQueue() {
+  if (m_parent)
+    m_parent->_removeMIDIEventQueue(this);
+}
+
+ReceiveFunctor MIDIEventQueue::receiver() {
+  return [this](const uint8_t* data, size_t len, double) { m_producer->receive(data, len); };
+}
+
+bool MIDIEventQueue::_push(const Event& ev, const void* sysex) {
+  size_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+  if (writeIdx - m_readIdx.load(std::memory_order_acquire) > m_mask ||
+      (ev.m_sysexLen &&
+       m_sysexWritePos + ev.m_sysexLen - m_sysexReadPos.load(std::memory_order_acquire) > SysexRingBytes)) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  Event& slot = m_events[writeIdx & m_mask];
+  slot = ev;
+  if (ev.m_sysexLen) {
+    slot.m_sysexPos = m_sysexWritePos;
+    size_t start = m_sysexWritePos & m_sysexMask;
+    size_t first = std::min(size_t(ev.m_sysexLen), SysexRingBytes - start);
+    std::memcpy(&m_sysexData[start], sysex, first);
+    std::memcpy(&m_sysexData[0], static_cast<const uint8_t*>(sysex) + first, ev.m_sysexLen - first);
+    m_sysexWritePos += ev.m_sysexLen;
+  }
+
+  m_writeIdx.store(writeIdx + 1, std::memory_order_release);
+  return true;
+}
+
+void MIDIEventQueue::_deliver(double intervalTime, double sampleRate, size_t frames) {
+  intervalTime -= m_latency.load(std::memory_order_relaxed);
+  size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+  size_t writeIdx = m_writeIdx.load(std::memory_order_acquire);
+  for (; readIdx != writeIdx; ++readIdx) {
+    const Event& ev = m_events[readIdx & m_mask];
+    double offset = (ev.m_time - intervalTime) * sampleRate;
+    if (offset >= double(frames))
+      break;
+    /* Late events (e.g. after a stalled pump) are played at the start of the interval */
+    m_frameOffset = offset > 0.0 ? size_t(offset) : 0;
+    _dispatch(ev);
+    m_readIdx.store(readIdx + 1, std::memory_order_release);
+  }
+  m_frameOffset = 0;
+}
+
+void MIDIEventQueue::_dispatch(const Event& ev) {
+  switch (EventKind(ev.m_kind)) {
+  case EventKind::NoteOff:
+    m_reader.noteOff(ev.m_chan, ev.m_a, ev.m_b);
+    break;
+  case EventKind::NoteOn:
+    m_reader.noteOn(ev.m_chan, ev.m_a, ev.m_b);
+    break;
+  case EventKind::NotePressure:
+    m_reader.notePressure(ev.m_chan, ev.m_a, ev.m_b);
+    break;
+  case EventKind::ControlChange:
+    m_reader.controlChange(ev.m_chan, ev.m_a, ev.m_b);
+    break;
+  case EventKind::ProgramChange:
+    m_reader.programChange(ev.m_chan, ev.m_a);
+    break;
+  case EventKind::ChannelPressure:
+    m_reader.channelPressure(ev.m_chan, ev.m_a);
+    break;
+  case EventKind::PitchBend:
+    m_reader.pitchBend(ev.m_chan, int16_t(ev.m_value));
+    break;
+  case EventKind::AllSoundOff:
+    m_reader.allSoundOff(ev.m_chan);
+    break;
+  case EventKind::ResetAllControllers:
+    m_reader.resetAllControllers(ev.m_chan);
+    break;
+  case EventKind::LocalControl:
+    m_reader.localControl(ev.m_chan, ev.m_a != 0);
+    break;
+  case EventKind::AllNotesOff:
+    m_reader.allNotesOff(ev.m_chan);
+    break;
+  case EventKind::OmniMode:
+    m_reader.omniMode(ev.m_chan, ev.m_a != 0);
+    break;
+  case EventKind::PolyMode:
+    m_reader.polyMode(ev.m_chan, ev.m_a != 0);
+    break;
+  case EventKind::SysEx: {
+    size_t start = ev.m_sysexPos & m_sysexMask;
+    const uint8_t* data = &m_sysexData[start];
+    if (start + ev.m_sysexLen > SysexRingBytes) {
+      /* Wrapped payload; reassemble so the reader sees contiguous bytes */
+      size_t first = SysexRingBytes - start;
+      std::memcpy(m_sysexScratch, data, first);
+      std::memcpy(m_sysexScratch + first, &m_sysexData[0], ev.m_sysexLen - first);
+      data = m_sysexScratch;
+    }
+    m_reader.sysex(data, ev.m_sysexLen);
+    m_sysexReadPos.store(ev.m_sysexPos + ev.m_sysexLen, std::memory_order_release);
+    break;
+  }
+  case EventKind::TimeCodeQuarterFrame:
+    m_reader.timeCodeQuarterFrame(ev.m_a, ev.m_b);
+    break;
+  case EventKind::SongPositionPointer:
+    m_reader.songPositionPointer(ev.m_value);
+    break;
+  case EventKind::SongSelect:
+    m_reader.songSelect(ev.m_a);
+    break;
+  case EventKind::TuneRequest:
+    m_reader.tuneRequest();
+    break;
+  case EventKind::StartSeq:
+    m_reader.startSeq();
+    break;
+  case EventKind::ContinueSeq:
+    m_reader.continueSeq();
+    break;
+  case EventKind::StopSeq:
+    m_reader.stopSeq();
+    break;
+  case EventKind::Reset:
+    m_reader.reset();
+    break;
+  }
+}
+
+} // namespace boo
@@ -0,0 +1,338 @@
+#include "boo/audiodev/MIDIFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <logvisor/logvisor.hpp>
+
+#include "boo/audiodev/IMIDIReader.hpp"
+#include "lib/audiodev/MIDICommon.hpp"
+
+namespace boo {
+static logvisor::Module Log("boo::MIDIFile");
+
+static uint32_t ReadBE32(const uint8_t* ptr) {
+  return (uint32_t(ptr[0]) << 24) | (uint32_t(ptr[1]) << 16) | (uint32_t(ptr[2]) << 8) | uint32_t(ptr[3]);
+}
+
+static uint16_t ReadBE16(const uint8_t* ptr) { return uint16_t((ptr[0] << 8) | ptr[1]); }
+
+/* SMF variable-length quantity, at most four bytes */
+static bool ReadVarLen(const uint8_t*& ptr, const uint8_t* end, uint32_t& valOut) {
+  valOut = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (ptr == end)
+      return false;
+    uint8_t a = *ptr++;
+    valOut = (valOut << 7) | (a & 0x7f);
+    if (!(a & 0x80))
+      return true;
+  }
+  return false;
+}
+
+/* MIDIDecoder reads sysex lengths of up to three bytes */
+static constexpr uint32_t MaxSysexLength = 0x1fffff;
+
+static void WriteVarLen(std::vector<uint8_t>& out, uint32_t val) {
+  if (val >= 0x4000)
+    out.push_back(uint8_t(0x80 | ((val >> 14) & 0x7f)));
+  if (val >= 0x80)
+    out.push_back(uint8_t(0x80 | ((val >> 7) & 0x7f)));
+  out.push_back(uint8_t(val & 0x7f));
+}
+
+void MIDIFile::clear() {
+  m_data.clear();
+  m_sequences.clear();
+  m_format = 0;
+  m_division = 0;
+}
+
+bool MIDIFile::open(const SystemChar* path) {
+  clear();
+#if _WIN32
+  FILE* fp = _wfopen(path, L"rb");
+  if (!fp) {
+    Log.report(logvisor::Error, FMT_STRING(L"unable to open '{}'"), path);
+    return false;
+  }
+#else
+  FILE* fp = std::fopen(path, "rb");
+  if (!fp) {
+    Log.report(logvisor::Error, FMT_STRING("unable to open '{}': {}"), path, strerror(errno));
+    return false;
+  }
+#endif
+
+  std::vector<uint8_t> file;
+  uint8_t buf[65536];
+  size_t rdBytes;
+  while ((rdBytes = std::fread(buf, 1, sizeof(buf), fp)))
+    file.insert(file.end(), buf, buf + rdBytes);
+  std::fclose(fp);
+
+  return load(file.data(), file.size());
+}
+
+bool MIDIFile::load(const void* data, size_t len) {
+  clear();
+  if (!_parse(static_cast<const uint8_t*>(data), len)) {
+    clear();
+    return false;
+  }
+  return true;
+}
+
+bool MIDIFile::_parse(const uint8_t* data, size_t len) {
+  if (len < 14 || std::memcmp(data, "MThd", 4) || ReadBE32(data + 4) < 6) {
+    Log.report(logvisor::Error, FMT_STRING("not a Standard MIDI File"));
+    return false;
+  }
+  size_t headerLen = ReadBE32(data + 4);
+  m_format = ReadBE16(data + 8);
+  unsigned trackCount = ReadBE16(data + 10);
+  m_division = ReadBE16(data + 12);
+  if (m_format > 2 || !m_division || (!(m_division & 0x8000) && !(m_division & 0x7fff)) ||
+      ((m_division & 0x8000) && !(m_division & 0xff))) {
+    Log.report(logvisor::Error, FMT_STRING("unsupported SMF format {} or division {:04X}"), m_format, m_division);
+    return false;
+  }
+
+  std::vector<Event> events;
+  std::vector<TempoPoint> tempos;
+  uint64_t endTick = 0;
+  size_t offset = 8 + std::min(headerLen, len - 8);
+  unsigned tracksRead = 0;
+  while (tracksRead < trackCount && len - offset >= 8) {
+    size_t chunkLen = std::min(size_t(ReadBE32(data + offset + 4)), len - offset - 8);
+    const uint8_t* chunk = data + offset + 8;
+    bool isTrack = !std::memcmp(data + offset, "MTrk", 4);
+    offset += 8 + chunkLen;
+    if (!isTrack)
+      continue;
+
+    std::vector<Event> trackEvents;
+    uint64_t trackEnd = 0;
+    if (!_parseTrack(chunk, chunkLen, trackEvents, tempos, trackEnd))
+      return false;
+    ++tracksRead;
+
+    if (m_format == 2) {
+      /* Independent sequences; each carries its own tempo map */
+      Sequence& seq = m_sequences.emplace_back();
+      seq.m_events = std::move(trackEvents);
+      seq.m_endTick = trackEnd;
+      _buildTempoMap(seq, tempos);
+      tempos.clear();
+    } else {
+      events.insert(events.end(), trackEvents.begin(), trackEvents.end());
+      endTick = std::max(endTick, trackEnd);
+    }
+  }
+
+  if (!tracksRead) {
+    Log.report(logvisor::Error, FMT_STRING("SMF contains no tracks"));
+    return false;
+  }
+
+  if (m_format != 2) {
+    /* Stable, so simultaneous events keep track order and then file order */
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& a, const Event& b) { return a.m_tick < b.m_tick; });
+    Sequence& seq = m_sequences.emplace_back();
+    seq.m_events = std::move(events);
+    seq.m_endTick = endTick;
+    _buildTempoMap(seq, tempos);
+  }
+  return true;
+}
+
+bool MIDIFile::_parseTrack(const uint8_t* data, size_t len, std::vector<Event>& events,
+                           std::vector<TempoPoint>& tempos, uint64_t& endTick) {
+  const uint8_t* ptr = data;
+  const uint8_t* end = data + len;
+  uint64_t tick = 0;
+  uint8_t status = 0;
+
+  auto truncated = [&]() {
+    Log.report(logvisor::Error, FMT_STRING("truncated SMF track"));
+    return false;
+  };
+
+  while (ptr != end) {
+    uint32_t delta;
+    if (!ReadVarLen(ptr, end, delta) || ptr == end)
+      return truncated();
+    tick += delta;
+
+    uint8_t a = *ptr;
+    if (a & 0x80) {
+      ++ptr;
+      if (a < 0xf0)
+        status = a;
+    } else if (!status) {
+      Log.report(logvisor::Error, FMT_STRING("SMF data byte without running status"));
+      return false;
+    } else {
+      a = status;
+    }
+
+    if (a == 0xff) {
+      /* Meta event; only tempo and end-of-track matter to playback */
+      if (ptr == end)
+        return truncated();
+      uint8_t type = *ptr++;
+      uint32_t metaLen;
+      if (!ReadVarLen(ptr, end, metaLen) || size_t(end - ptr) < metaLen)
+        return truncated();
+      if (type == 0x51 && metaLen == 3) {
+        /* A zero tempo would make ticks take no time at all; skip it like other malformed events */
+        uint32_t usPerQuarter = (ptr[0] << 16) | (ptr[1] << 8) | ptr[2];
+        if (usPerQuarter)
+          tempos.push_back({tick, 0.0, double(usPerQuarter)});
+      }
+      ptr += metaLen;
+      if (type == 0x2f)
+        break;
+    } else if (a == uint8_t(Status::SysEx) || a == uint8_t(Status::SysExTerm)) {
+      /* Sysex cancels running status */
+      status = 0;
+      uint32_t sysexLen;
+      if (!ReadVarLen(ptr, end, sysexLen) || size_t(end - ptr) < sysexLen)
+        return truncated();
+      Event ev{tick, 0.0, uint32_t(m_data.size()), 0};
+      if (a == uint8_t(Status::SysEx)) {
+        /* Stored as MIDIEncoder sends it: F0, length, payload without the F7 */
+        uint32_t payloadLen = sysexLen && ptr[sysexLen - 1] == uint8_t(Status::SysExTerm) ? sysexLen - 1 : sysexLen;
+        if (payloadLen <= MaxSysexLength) {
+          m_data.push_back(uint8_t(Status::SysEx));
+          WriteVarLen(m_data, payloadLen);
+          m_data.insert(m_data.end(), ptr, ptr + payloadLen);
+        }
+      } else {
+        /* Escape: bytes are sent as-is */
+        m_data.insert(m_data.end(), ptr, ptr + sysexLen);
+      }
+      ptr += sysexLen;
+      ev.m_length = uint32_t(m_data.size() - ev.m_offset);
+      if (ev.m_length)
+        events.push_back(ev);
+    } else if (a >= 0xf0) {
+      Log.report(logvisor::Error, FMT_STRING("unexpected status {:02X} in SMF track"), a);
+      return false;
+    } else {
+      size_t dataLen = (a & 0xf0) == uint8_t(Status::ProgramChange) || (a & 0xf0) == uint8_t(Status::ChannelPressure)
+                           ? 1 : 2;
+      if (size_t(end - ptr) < dataLen)
+        return truncated();
+      events.push_back({tick, 0.0, uint32_t(m_data.size()), uint32_t(dataLen + 1)});
+      m_data.push_back(a);
+      m_data.insert(m_data.end(), ptr, ptr + dataLen);
+      ptr += dataLen;
+    }
+  }
+
+  endTick = tick;
+  return true;
+}
+
+void MIDIFile::_buildTempoMap(Sequence& seq, std::vector<TempoPoint>& tempos) const {
+  if (m_division & 0x8000) {
+    /* SMPTE: fixed ticks per second, tempo events have no effect */
+    int fps = -int(int8_t(m_division >> 8));
+    double rate = fps == 29 ? 30000.0 / 1001.0 : double(fps);
+    seq.m_tempoMap.push_back({0, 0.0, 1.0 / (rate * (m_division & 0xff))});
+  } else {
+    /* m_secondsPerTick holds microseconds per quarter note until resolved; default 120 BPM */
+    double ticksPerQuarter = m_division;
+    std::stable_sort(tempos.begin(), tempos.end(),
+                     [](const TempoPoint& a, const TempoPoint& b) { return a.m_tick < b.m_tick; });
+    seq.m_tempoMap.push_back({0, 0.0, 0.5 / ticksPerQuarter});
+    for (const TempoPoint& tempo : tempos) {
+      TempoPoint& last = seq.m_tempoMap.back();
+      double secondsPerTick = tempo.m_secondsPerTick / 1.0e6 / ticksPerQuarter;
+      if (tempo.m_tick == last.m_tick) {
+        last.m_secondsPerTick = secondsPerTick;
+        continue;
+      }
+      double time = last.m_time + (tempo.m_tick - last.m_tick) * last.m_secondsPerTick;
+      seq.m_tempoMap.push_back({tempo.m_tick, time, secondsPerTick});
+    }
+  }
+
+  /* Events are tick-ordered; walk the map alongside them */
+  auto tempo = seq.m_tempoMap.begin();
+  for (Event& ev : seq.m_events) {
+    while (tempo + 1 != seq.m_tempoMap.end() && (tempo + 1)->m_tick <= ev.m_tick)
+      ++tempo;
+    ev.m_time = tempo->m_time + (ev.m_tick - tempo->m_tick) * tempo->m_secondsPerTick;
+  }
+  seq.m_duration = _tickToSeconds(seq, seq.m_endTick);
+}
+
+double MIDIFile::_tickToSeconds(const Sequence& seq, uint64_t tick) {
+  auto tempo = std::upper_bound(seq.m_tempoMap.begin(), seq.m_tempoMap.end(), tick,
+                                [](uint64_t t, const TempoPoint& p) { return t < p.m_tick; }) -
+               1;
+  return tempo->m_time + (tick - tempo->m_tick) * tempo->m_secondsPerTick;
+}
+
+double MIDIFile::tickToSeconds(uint64_t tick, size_t seq) const { return _tickToSeconds(m_sequences[seq], tick); }
+
+uint64_t MIDIFile::secondsToTick(double seconds, size_t seq) const {
+  const std::vector<TempoPoint>& map = m_sequences[seq].m_tempoMap;
+  if (seconds <= 0.0)
+    return 0;
+  auto tempo = std::upper_bound(map.begin(), map.end(), seconds,
+                                [](double t, const TempoPoint& p) { return t < p.m_time; }) -
+               1;
+  return tempo->m_tick + uint64_t((seconds - tempo->m_time) / tempo->m_secondsPerTick);
+}
+
+size_t MIDIFile::findEvent(double seconds, size_t seq) const {
+  const std::vector<Event>& events = m_sequences[seq].m_events;
+  return std::lower_bound(events.begin(), events.end(), seconds,
+                          [](const Event& ev, double t) { return ev.m_time < t; }) -
+         events.begin();
+}
+
+MIDISequencer::MIDISequencer(const MIDIFile& file, IMIDIReader& reader, size_t sequence)
+: m_file(file), m_reader(reader), m_decoder(reader), m_sequence(sequence) {}
+
+void MIDISequencer::_dispatchUntil(double endTime, double sampleRate) {
+  const std::vector<MIDIFile::Event>& events = m_file.getEvents(m_sequence);
+  for (; m_next < events.size() && events[m_next].m_time < endTime; ++m_next) {
+    const MIDIFile::Event& ev = events[m_next];
+    double offset = (ev.m_time - m_time) * sampleRate;
+    m_frameOffset = offset > 0.0 ? size_t(offset) : 0;
+    const uint8_t* data = m_file.getEventData(ev);
+    m_decoder.receiveBytes(data, data + ev.m_length);
+  }
+  m_frameOffset = 0;
+}
+
+bool MIDISequencer::advanceFrames(size_t frames, double sampleRate) {
+  double endTime = m_time + frames / sampleRate;
+  _dispatchUntil(endTime, sampleRate);
+  m_time = endTime;
+  return !isFinished() || m_time < m_file.getDuration(m_sequence);
+}
+
+bool MIDISequencer::advance(double seconds) {
+  double endTime = m_time + seconds;
+  _dispatchUntil(endTime, 0.0);
+  m_time = endTime;
+  return !isFinished() || m_time < m_file.getDuration(m_sequence);
+}
+
+void MIDISequencer::seek(double seconds) {
+  for (uint8_t chan = 0; chan < 16; ++chan)
+    m_reader.allNotesOff(chan);
+  m_time = std::max(seconds, 0.0);
+  m_next = m_file.findEvent(m_time, m_sequence);
+}
+
+} // namespace boo
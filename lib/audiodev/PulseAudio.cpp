@@ -113,7 +113,7 @@ struct PulseAudioVoiceEngine : LinuxMidi {
     return false;
   }
 
-  PulseAudioVoiceEngine() {
+  explicit PulseAudioVoiceEngine(const char* sinkName = nullptr) {
     if (!(m_mainloop = pa_mainloop_new())) {
       Log.report(logvisor::Error, FMT_STRING("Unable to pa_mainloop_new()"));
       return;
@@ -139,9 +139,13 @@ struct PulseAudioVoiceEngine : LinuxMidi {
 
     _paWaitReady();
 
-    op = pa_context_get_server_info(m_ctx, pa_server_info_cb_t(_getServerInfoReply), this);
-    _paIterate(op);
-    pa_operation_unref(op);
+    if (sinkName) {
+      m_sinkName = sinkName;
+    } else {
+      op = pa_context_get_server_info(m_ctx, pa_server_info_cb_t(_getServerInfoReply), this);
+      _paIterate(op);
+      pa_operation_unref(op);
+    }
 
     if (!_setupSink())
       goto err;
@@ -355,6 +359,28 @@ struct PulseAudioVoiceEngine : LinuxMidi {
   }
 };
 
-std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine() { return std::make_unique<PulseAudioVoiceEngine>(); }
+std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine() {
+  auto ret = std::make_unique<PulseAudioVoiceEngine>();
+  if (ret->m_stream)
+    return ret;
+
+  /* No usable PulseAudio server; fall back to driving ALSA directly */
+  if (auto alsa = NewALSAAudioVoiceEngine())
+    return alsa;
+
+  return ret;
+}
+
+std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine(const char* outputName) {
+  auto ret = std::make_unique<PulseAudioVoiceEngine>(outputName);
+  if (ret->m_stream)
+    return ret;
+
+  /* Without a server, the name is taken to be an ALSA device */
+  if (!ret->m_ctx)
+    return NewALSAAudioVoiceEngine(outputName);
+
+  return {};
+}
 
 } // namespace boo
@@ -101,7 +101,8 @@ struct WASAPIAudioVoiceEngine : BaseAudioVoiceEngine {
     // Callback methods for device-event notifications.
 
     HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDeviceId) override {
-      m_parent.m_rebuild = true;
+      if (!m_parent.m_pinnedOutput)
+        m_parent.m_rebuild = true;
       return S_OK;
     }
 
@@ -377,6 +378,9 @@ struct WASAPIAudioVoiceEngine : BaseAudioVoiceEngine {
   bool m_started = false;
   bool m_rebuild = false;
 
+  /* Engines opened on a named output don't follow default device changes */
+  bool m_pinnedOutput = false;
+
   void _rebuildAudioRenderClient() {
     soxr_datatype_t oldFmt = m_mixInfo.m_sampleFormat;
 
@@ -564,16 +568,12 @@ struct WASAPIAudioVoiceEngine : BaseAudioVoiceEngine {
 #ifdef TE_VIRTUAL_MIDI
   static void CALLBACK VirtualMIDIReceiveProc(LPVM_MIDI_PORT midiPort, LPBYTE midiDataBytes, DWORD length,
                                               IMIDIReceiver* dwInstance) {
-    std::vector<uint8_t> bytes;
-    bytes.resize(length);
-    memcpy(&bytes[0], midiDataBytes, length);
-
     double timestamp;
     LARGE_INTEGER perf;
     QueryPerformanceCounter(&perf);
     timestamp = perf.QuadPart / PerfFrequency;
 
-    dwInstance->m_receiver(std::move(bytes), timestamp);
+    dwInstance->m_receiver(midiDataBytes, length, timestamp);
   }
 #endif
 
@@ -581,8 +581,7 @@ struct WASAPIAudioVoiceEngine : BaseAudioVoiceEngine {
                                        DWORD_PTR dwParam2) {
     if (wMsg == MIM_DATA) {
       uint8_t(&ptr)[3] = reinterpret_cast<uint8_t(&)[3]>(dwParam1);
-      std::vector<uint8_t> bytes(std::cbegin(ptr), std::cend(ptr));
-      dwInstance->m_receiver(std::move(bytes), dwParam2 / 1000.0);
+      dwInstance->m_receiver(ptr, std::size(ptr), dwParam2 / 1000.0);
     }
   }
 
@@ -892,4 +891,12 @@ struct WASAPIAudioVoiceEngine : BaseAudioVoiceEngine {
 
 std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine() { return std::make_unique<WASAPIAudioVoiceEngine>(); }
 
+std::unique_ptr<IAudioVoiceEngine> NewAudioVoiceEngine(const char* outputName) {
+  auto ret = std::make_unique<WASAPIAudioVoiceEngine>();
+  if (!ret->setCurrentAudioOutput(outputName))
+    return {};
+  ret->m_pinnedOutput = true;
+  return ret;
+}
+
 } // namespace boo
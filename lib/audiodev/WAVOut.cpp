@@ -1,6 +1,5 @@
 #include "lib/audiodev/AudioVoiceEngine.hpp"
-
-#include <cstdio>
+#include "lib/audiodev/AudioFileWriter.hpp"
 
 #include "boo/audiodev/IAudioVoiceEngine.hpp"
 #include <logvisor/logvisor.hpp>
@@ -53,10 +52,10 @@ struct WAVOutVoiceEngine : BaseAudioVoiceEngine {
 
   bool useMIDILock() const override { return false; }
 
-  FILE* m_fp = nullptr;
-  size_t m_bytesWritten = 0;
+  AudioFileWriter m_writer;
 
-  void prepareWAV(double sampleRate, int numChans) {
+  /* Returns the WAVE_FORMAT_EXTENSIBLE speaker mask, or 0 for plain stereo float */
+  uint32_t prepareWAV(double sampleRate, int numChans) {
     uint32_t speakerMask = 0;
 
     switch (numChans) {
@@ -108,112 +107,40 @@ struct WAVOutVoiceEngine : BaseAudioVoiceEngine {
       break;
     }
 
-    if (numChans == 2) {
-      fwrite("RIFF", 1, 4, m_fp);
-      uint32_t dataSize = 0;
-      uint32_t chunkSize = 36 + dataSize;
-      fwrite(&chunkSize, 1, 4, m_fp);
-
-      fwrite("WAVE", 1, 4, m_fp);
-
-      fwrite("fmt ", 1, 4, m_fp);
-      uint32_t sixteen = 16;
-      fwrite(&sixteen, 1, 4, m_fp);
-      uint16_t audioFmt = 3;
-      fwrite(&audioFmt, 1, 2, m_fp);
-      uint16_t chCount = numChans;
-      fwrite(&chCount, 1, 2, m_fp);
-      uint32_t sampRate = sampleRate;
-      fwrite(&sampRate, 1, 4, m_fp);
-      uint16_t blockAlign = 4 * numChans;
-      uint32_t byteRate = sampRate * blockAlign;
-      fwrite(&byteRate, 1, 4, m_fp);
-      fwrite(&blockAlign, 1, 2, m_fp);
-      uint16_t bps = 32;
-      fwrite(&bps, 1, 2, m_fp);
-
-      fwrite("data", 1, 4, m_fp);
-      fwrite(&dataSize, 1, 4, m_fp);
-    } else {
-      fwrite("RIFF", 1, 4, m_fp);
-      uint32_t dataSize = 0;
-      uint32_t chunkSize = 60 + dataSize;
-      fwrite(&chunkSize, 1, 4, m_fp);
-
-      fwrite("WAVE", 1, 4, m_fp);
-
-      fwrite("fmt ", 1, 4, m_fp);
-      uint32_t forty = 40;
-      fwrite(&forty, 1, 4, m_fp);
-      uint16_t audioFmt = 0xFFFE;
-      fwrite(&audioFmt, 1, 2, m_fp);
-      uint16_t chCount = numChans;
-      fwrite(&chCount, 1, 2, m_fp);
-      uint32_t sampRate = sampleRate;
-      fwrite(&sampRate, 1, 4, m_fp);
-      uint16_t blockAlign = 4 * numChans;
-      uint32_t byteRate = sampRate * blockAlign;
-      fwrite(&byteRate, 1, 4, m_fp);
-      fwrite(&blockAlign, 1, 2, m_fp);
-      uint16_t bps = 32;
-      fwrite(&bps, 1, 2, m_fp);
-      uint16_t extSize = 22;
-      fwrite(&extSize, 1, 2, m_fp);
-      fwrite(&bps, 1, 2, m_fp);
-      fwrite(&speakerMask, 1, 4, m_fp);
-      fwrite("\x03\x00\x00\x00\x00\x00\x10\x00\x80\x00\x00\xaa\x00\x38\x9b\x71", 1, 16, m_fp);
-
-      fwrite("data", 1, 4, m_fp);
-      fwrite(&dataSize, 1, 4, m_fp);
-    }
-
     m_mixInfo.m_periodFrames = 512;
     m_mixInfo.m_sampleRate = sampleRate;
     m_mixInfo.m_sampleFormat = SOXR_FLOAT32_I;
     m_mixInfo.m_bitsPerSample = 32;
     _buildAudioRenderClient();
+
+    /* An offline render has no deadline, so quality is never traded for speed unless asked for */
+    AudioWatchdogConfig watchdog;
+    watchdog.m_enabled = false;
+    m_pendingWatchdogConfig = watchdog;
+    m_watchdog.setConfig(watchdog);
+    return numChans == 2 ? 0 : speakerMask;
   }
 
-  WAVOutVoiceEngine(const char* path, double sampleRate, int numChans) {
-    m_fp = fopen(path, "wb");
-    if (!m_fp)
-      return;
-    prepareWAV(sampleRate, numChans);
+  WAVOutVoiceEngine(const char* path, double sampleRate, int numChans, const WAVOutOptions& options)
+  : m_writer(options) {
+    uint32_t speakerMask = prepareWAV(sampleRate, numChans);
+    m_writer.open(path, m_mixInfo.m_channelMap.m_channelCount, uint32_t(sampleRate), speakerMask);
   }
 
 #if _WIN32
-  WAVOutVoiceEngine(const wchar_t* path, double sampleRate, int numChans) {
-    m_fp = _wfopen(path, L"wb");
-    if (!m_fp)
-      return;
-    prepareWAV(sampleRate, numChans);
+  WAVOutVoiceEngine(const wchar_t* path, double sampleRate, int numChans, const WAVOutOptions& options)
+  : m_writer(options) {
+    uint32_t speakerMask = prepareWAV(sampleRate, numChans);
+    m_writer.open(path, m_mixInfo.m_channelMap.m_channelCount, uint32_t(sampleRate), speakerMask);
   }
 #endif
 
-  void finishWav() {
-    uint32_t dataSize = m_bytesWritten;
-
-    if (m_mixInfo.m_channelMap.m_channelCount == 2) {
-      fseek(m_fp, 4, SEEK_SET);
-      uint32_t chunkSize = 36 + dataSize;
-      fwrite(&chunkSize, 1, 4, m_fp);
-
-      fseek(m_fp, 40, SEEK_SET);
-      fwrite(&dataSize, 1, 4, m_fp);
-    } else {
-      fseek(m_fp, 4, SEEK_SET);
-      uint32_t chunkSize = 60 + dataSize;
-      fwrite(&chunkSize, 1, 4, m_fp);
-
-      fseek(m_fp, 64, SEEK_SET);
-      fwrite(&dataSize, 1, 4, m_fp);
-    }
-
-    fclose(m_fp);
+  ~WAVOutVoiceEngine() override {
+    m_writer.close();
+    if (uint64_t stalls = m_writer.getStallCount())
+      Log.report(logvisor::Warning, FMT_STRING("mixer waited on the file writer {} times"), stalls);
   }
 
-  ~WAVOutVoiceEngine() override { finishWav(); }
-
   void _buildAudioRenderClient() {
     m_5msFrames = m_mixInfo.m_sampleRate * 5 / 1000;
     m_interleavedBuf.resize(m_mixInfo.m_channelMap.m_channelCount * m_5msFrames);
@@ -227,24 +154,24 @@ struct WAVOutVoiceEngine : BaseAudioVoiceEngine {
   }
 
   void pumpAndMixVoices() override {
-    size_t frameSz = 4 * m_mixInfo.m_channelMap.m_channelCount;
     _pumpAndMixVoices(m_5msFrames, m_interleavedBuf.data());
-    fwrite(m_interleavedBuf.data(), 1, m_5msFrames * frameSz, m_fp);
-    m_bytesWritten += m_5msFrames * frameSz;
+    m_writer.write(m_interleavedBuf.data(), m_interleavedBuf.size());
   }
 };
 
-std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const char* path, double sampleRate, int numChans) {
-  std::unique_ptr<IAudioVoiceEngine> ret = std::make_unique<WAVOutVoiceEngine>(path, sampleRate, numChans);
-  if (!static_cast<WAVOutVoiceEngine&>(*ret).m_fp)
+std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const char* path, double sampleRate, int numChans,
+                                                          const WAVOutOptions& options) {
+  std::unique_ptr<IAudioVoiceEngine> ret = std::make_unique<WAVOutVoiceEngine>(path, sampleRate, numChans, options);
+  if (!static_cast<WAVOutVoiceEngine&>(*ret).m_writer.isOpen())
     return {};
   return ret;
 }
 
 #if _WIN32
-std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const wchar_t* path, double sampleRate, int numChans) {
-  std::unique_ptr<IAudioVoiceEngine> ret = std::make_unique<WAVOutVoiceEngine>(path, sampleRate, numChans);
-  if (!static_cast<WAVOutVoiceEngine&>(*ret).m_fp)
+std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const wchar_t* path, double sampleRate, int numChans,
+                                                          const WAVOutOptions& options) {
+  std::unique_ptr<IAudioVoiceEngine> ret = std::make_unique<WAVOutVoiceEngine>(path, sampleRate, numChans, options);
+  if (!static_cast<WAVOutVoiceEngine&>(*ret).m_writer.isOpen())
     return {};
   return ret;
 }
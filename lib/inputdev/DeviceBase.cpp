@@ -1,11 +1,14 @@
 #include "boo/inputdev/DeviceBase.hpp"
 #include "boo/inputdev/DeviceToken.hpp"
+#include "lib/inputdev/HIDRecording.hpp"
 #include "lib/inputdev/IHIDDevice.hpp"
 
 namespace boo {
 
 DeviceBase::DeviceBase(uint64_t typeHash, DeviceToken* token) : m_typeHash(typeHash), m_token(token) {}
 
+DeviceBase::~DeviceBase() = default;
+
 void DeviceBase::_deviceDisconnected() {
   deviceDisconnected();
   m_token = nullptr;
@@ -31,9 +34,19 @@ bool DeviceBase::sendUSBInterruptTransfer(const uint8_t* data, size_t length) {
 }
 
 size_t DeviceBase::receiveUSBInterruptTransfer(uint8_t* data, size_t length) {
-  if (m_hidDev)
-    return m_hidDev->_receiveUSBInterruptTransfer(data, length);
-  return false;
+  if (!m_hidDev)
+    return 0;
+  size_t ret = m_hidDev->_receiveUSBInterruptTransfer(data, length);
+  /* Synchronous backends return -1 as size_t on a timed-out transfer */
+  if (ret && ret <= length) {
+    m_latency.arrived(m_hidDev->_receiveTime());
+    if (m_recording.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lk(m_recordLock);
+      if (m_recorder)
+        m_recorder->record(HIDRecordKind::USBTransfer, 0, data, ret);
+    }
+  }
+  return ret;
 }
 
 unsigned DeviceBase::getVendorId() const {
@@ -88,4 +101,41 @@ size_t DeviceBase::receiveHIDReport(uint8_t* data, size_t length, HIDReportType
   return 0;
 }
 
+void DeviceBase::_receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message,
+                                    std::chrono::steady_clock::time_point arrival) {
+  if (tp == HIDReportType::Input) {
+    m_latency.arrived(arrival);
+    if (m_recording.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lk(m_recordLock);
+      if (m_recorder)
+        m_recorder->record(HIDRecordKind::InputReport, message, data, length);
+    }
+  }
+  receivedHIDReport(data, length, tp, message);
+}
+
+bool DeviceBase::startRecording(const SystemChar* path) {
+  std::vector<uint8_t> descriptor;
+#if !_WIN32
+  /* Windows only exposes preparsed data, which cannot be replayed */
+  descriptor = getReportDescriptor();
+#endif
+  DeviceType type = m_token ? m_token->getDeviceType() : DeviceType::None;
+  std::unique_ptr<HIDRecorder> recorder =
+      HIDRecorder::Create(path, type, getVendorId(), getProductId(), getProductName(), descriptor);
+  if (!recorder)
+    return false;
+
+  std::lock_guard<std::mutex> lk(m_recordLock);
+  m_recorder = std::move(recorder);
+  m_recording.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void DeviceBase::stopRecording() {
+  std::lock_guard<std::mutex> lk(m_recordLock);
+  m_recording.store(false, std::memory_order_relaxed);
+  m_recorder.reset();
+}
+
 } // namespace boo
@@ -26,6 +26,7 @@ DeviceFinder::DeviceFinder(std::unordered_set<uint64_t> types) {
         m_types.push_back(sigIter);
       ++sigIter;
     }
+    DeviceSignature::FindRegistered(typeHash, m_types);
   }
 }
 
@@ -62,27 +63,41 @@ void DeviceFinder::_removeToken(const std::string& path) {
   m_tokensLock.unlock();
 }
 
+IHIDListener* DeviceFinder::_listener() {
+  if (!m_listener) {
+    if (m_enumeration == HIDDeviceEnumeration::Virtual)
+      m_listener = VirtualHIDListenerNew(*this);
+    else
+      m_listener = IHIDListenerNew(*this);
+  }
+  return m_listener.get();
+}
+
+void DeviceFinder::setDeviceEnumeration(HIDDeviceEnumeration enumeration) {
+  if (enumeration == m_enumeration)
+    return;
+  if (m_listener) {
+    m_listener->stopScanning();
+    m_listener.reset();
+  }
+  m_enumeration = enumeration;
+}
+
 bool DeviceFinder::startScanning() {
-  if (!m_listener)
-    m_listener = IHIDListenerNew(*this);
-  if (m_listener)
-    return m_listener->startScanning();
+  if (IHIDListener* listener = _listener())
+    return listener->startScanning();
   return false;
 }
 
 bool DeviceFinder::stopScanning() {
-  if (!m_listener)
-    m_listener = IHIDListenerNew(*this);
-  if (m_listener)
-    return m_listener->stopScanning();
+  if (IHIDListener* listener = _listener())
+    return listener->stopScanning();
   return false;
 }
 
 bool DeviceFinder::scanNow() {
-  if (!m_listener)
-    m_listener = IHIDListenerNew(*this);
-  if (m_listener)
-    return m_listener->scanNow();
+  if (IHIDListener* listener = _listener())
+    return listener->scanNow();
   return false;
 }
 
@@ -1,47 +1,95 @@
 #include "boo/inputdev/DeviceSignature.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "boo/inputdev/DeviceToken.hpp"
 #include "boo/inputdev/GenericPad.hpp"
 #include "lib/inputdev/IHIDDevice.hpp"
 
 namespace boo {
 
-extern const DeviceSignature BOO_DEVICE_SIGS[];
+namespace {
+/* Signatures added at runtime. A deque keeps them at stable addresses for DeviceFinder */
+class SignatureRegistry {
+  std::shared_mutex m_lock;
+  std::deque<DeviceSignature> m_sigs;
+  std::unordered_map<uint32_t, const DeviceSignature*> m_byKey;
+  std::atomic_bool m_empty = true;
+
+public:
+  static SignatureRegistry& Instance() {
+    static SignatureRegistry registry;
+    return registry;
+  }
+
+  void add(const DeviceSignature& sig) {
+    std::unique_lock<std::shared_mutex> lk(m_lock);
+    const DeviceSignature& stored = m_sigs.emplace_back(sig);
+    if (sig.m_vid || sig.m_pid)
+      m_byKey[DeviceSignatureIndex::Key(sig.m_vid, sig.m_pid)] = &stored;
+    m_empty.store(false, std::memory_order_release);
+  }
+
+  const DeviceSignature* find(unsigned vid, unsigned pid) {
+    /* Most processes never register anything; skip the lock entirely */
+    if (m_empty.load(std::memory_order_acquire))
+      return nullptr;
+    std::shared_lock<std::shared_mutex> lk(m_lock);
+    auto search = m_byKey.find(DeviceSignatureIndex::Key(vid, pid));
+    return search != m_byKey.end() ? search->second : nullptr;
+  }
+
+  void findType(uint64_t typeHash, DeviceSignature::TDeviceSignatureSet& out) {
+    std::shared_lock<std::shared_mutex> lk(m_lock);
+    for (const DeviceSignature& sig : m_sigs)
+      if (sig.m_typeHash == typeHash)
+        out.push_back(&sig);
+  }
+};
+} // Anonymous namespace
+
+const DeviceSignature* DeviceSignature::Find(unsigned vid, unsigned pid) {
+  if (const DeviceSignature* sig = SignatureRegistry::Instance().find(vid, pid))
+    return sig;
+  return BOO_DEVICE_SIG_INDEX.find(vid, pid);
+}
+
+void DeviceSignature::Register(const DeviceSignature& sig) { SignatureRegistry::Instance().add(sig); }
+
+void DeviceSignature::FindRegistered(uint64_t typeHash, TDeviceSignatureSet& out) {
+  SignatureRegistry::Instance().findType(typeHash, out);
+}
 
 bool DeviceSignature::DeviceMatchToken(const DeviceToken& token, const TDeviceSignatureSet& sigSet) {
+  const DeviceSignature* sig = Find(token.getVendorId(), token.getProductId());
   if (token.getDeviceType() == DeviceType::HID) {
-    uint64_t genPadHash = dev_typeid(GenericPad);
-    bool hasGenericPad = false;
-    for (const DeviceSignature* sig : sigSet) {
-      if (sig->m_vid == token.getVendorId() && sig->m_pid == token.getProductId() && sig->m_type != DeviceType::HID)
-        return false;
-      if (sig->m_typeHash == genPadHash)
-        hasGenericPad = true;
-    }
-    return hasGenericPad;
+    if (sig && sig->m_type != DeviceType::HID)
+      return false;
+    constexpr uint64_t genPadHash = dev_typeid(GenericPad);
+    return std::any_of(sigSet.begin(), sigSet.end(),
+                       [&](const DeviceSignature* s) { return s == sig || s->m_typeHash == genPadHash; });
   }
-  for (const DeviceSignature* sig : sigSet) {
-    if (sig->m_vid == token.getVendorId() && sig->m_pid == token.getProductId())
-      return true;
-  }
-  return false;
+  /* The interest set holds only a handful of device types */
+  return sig && std::find(sigSet.begin(), sigSet.end(), sig) != sigSet.end();
 }
 
 std::shared_ptr<IHIDDevice> IHIDDeviceNew(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp);
+std::shared_ptr<IHIDDevice> DeviceSignature::HIDDeviceNew(DeviceToken& token,
+                                                          const std::shared_ptr<DeviceBase>& devImp) {
+  if (token.m_hidSource)
+    return token.m_hidSource->newHIDDevice(token, devImp);
+  return IHIDDeviceNew(token, devImp);
+}
+
 std::shared_ptr<DeviceBase> DeviceSignature::DeviceNew(DeviceToken& token) {
   std::shared_ptr<DeviceBase> retval;
 
   /* Perform signature-matching to find the appropriate device-factory */
-  const DeviceSignature* foundSig = nullptr;
-  const DeviceSignature* sigIter = BOO_DEVICE_SIGS;
-  unsigned targetVid = token.getVendorId();
-  unsigned targetPid = token.getProductId();
-  while (sigIter->m_name) {
-    if (sigIter->m_vid == targetVid && sigIter->m_pid == targetPid) {
-      foundSig = sigIter;
-      break;
-    }
-    ++sigIter;
-  }
+  const DeviceSignature* foundSig = Find(token.getVendorId(), token.getProductId());
   if (!foundSig) {
     /* Try Generic HID devices */
     if (token.getDeviceType() == DeviceType::HID) {
@@ -49,7 +97,7 @@ std::shared_ptr<DeviceBase> DeviceSignature::DeviceNew(DeviceToken& token) {
       if (!retval)
         return nullptr;
 
-      retval->m_hidDev = IHIDDeviceNew(token, retval);
+      retval->m_hidDev = HIDDeviceNew(token, retval);
       if (!retval->m_hidDev)
         return nullptr;
       retval->m_hidDev->_startThread();
@@ -66,7 +114,7 @@ std::shared_ptr<DeviceBase> DeviceSignature::DeviceNew(DeviceToken& token) {
   if (!retval)
     return nullptr;
 
-  retval->m_hidDev = IHIDDeviceNew(token, retval);
+  retval->m_hidDev = HIDDeviceNew(token, retval);
   if (!retval->m_hidDev)
     return nullptr;
   retval->m_hidDev->_startThread();
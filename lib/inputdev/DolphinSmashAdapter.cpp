@@ -57,27 +57,29 @@ void DolphinSmashAdapter::transferCycle() {
   // fmt::print("RECEIVED DATA {} {:02X}\n", recvSz, payload[0]);
 
   std::lock_guard<std::mutex> lk(m_callbackLock);
-  if (!m_callback) {
-    return;
-  }
 
   /* Parse controller states */
   const uint8_t* controller = &payload[1];
   uint8_t rumbleMask = 0;
+  uint8_t connectedMask = 0;
+  uint8_t disconnectedMask = 0;
+  std::array<EDolphinControllerType, 4> types{};
+  DolphinSmashAdapterState snapshot;
   for (uint32_t i = 0; i < 4; i++, controller += 9) {
     DolphinControllerState state;
     bool rumble = false;
     const EDolphinControllerType type = parseState(&state, controller, rumble);
+    types[i] = type;
 
     if (True(type) && (m_knownControllers & (1U << i)) == 0) {
       m_leftStickCal = state.m_leftStick;
       m_rightStickCal = state.m_rightStick;
       m_triggersCal = state.m_analogTriggers;
       m_knownControllers |= 1U << i;
-      m_callback->controllerConnected(i, type);
+      connectedMask |= 1U << i;
     } else if (False(type) && (m_knownControllers & (1U << i)) != 0) {
       m_knownControllers &= ~(1U << i);
-      m_callback->controllerDisconnected(i);
+      disconnectedMask |= 1U << i;
     }
 
     if ((m_knownControllers & (1U << i)) != 0) {
@@ -87,11 +89,29 @@ void DolphinSmashAdapter::transferCycle() {
       state.m_rightStick[1] = state.m_rightStick[1] - m_rightStickCal[1];
       state.m_analogTriggers[0] = state.m_analogTriggers[0] - m_triggersCal[0];
       state.m_analogTriggers[1] = state.m_analogTriggers[1] - m_triggersCal[1];
-      m_callback->controllerUpdate(i, type, state);
+      snapshot.m_types[i] = type;
+      snapshot.m_controllers[i] = state;
     }
 
     rumbleMask |= rumble ? 1U << i : 0;
   }
+  _reportDecoded();
+  m_snapshot.publish(snapshot, getReportArrival());
+
+  /* Deliver to the callback once all ports are parsed, so decode time excludes it */
+  if (m_callback) {
+    for (uint32_t i = 0; i < 4; i++) {
+      if ((connectedMask & (1U << i)) != 0) {
+        m_callback->controllerConnected(i, types[i]);
+      } else if ((disconnectedMask & (1U << i)) != 0) {
+        m_callback->controllerDisconnected(i);
+      }
+      if ((m_knownControllers & (1U << i)) != 0) {
+        m_callback->controllerUpdate(i, types[i], snapshot.m_controllers[i]);
+      }
+    }
+  }
+  _reportDelivered();
 
   /* Send rumble message (if needed) */
   const uint8_t rumbleReq = m_rumbleRequest & rumbleMask;
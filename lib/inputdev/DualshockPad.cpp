@@ -86,12 +86,15 @@ void DualshockPad::receivedHIDReport(const uint8_t* data, size_t length, HIDRepo
   state.accPitch = (atan2(accYval, accZval) + M_PIF) * RAD_TO_DEG;
   state.accYaw = (atan2(accXval, accZval) + M_PIF) * RAD_TO_DEG;
   state.gyroZ = (state.m_gyrometerZ / 1023.f);
+  _reportDecoded();
+  m_snapshot.publish(state, getReportArrival());
 
   {
     std::lock_guard<std::mutex> lk(m_callbackLock);
     if (m_callback)
       m_callback->controllerUpdate(*this, state);
   }
+  _reportDelivered();
 
   if (m_rumbleRequest != m_rumbleState) {
     if (True(m_rumbleRequest & EDualshockMotor::Left)) {
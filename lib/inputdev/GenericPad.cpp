@@ -1,4 +1,9 @@
 #include "boo/inputdev/GenericPad.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include "boo/inputdev/DeviceToken.hpp"
 
 namespace boo {
@@ -24,19 +29,151 @@ void GenericPad::initialCycle() {
   m_parser.Parse(reportDesc.data(), reportDesc.size());
 #endif
   std::lock_guard<std::mutex> lk(m_callbackLock);
+  size_t count = m_parser.GetValueCount();
+  m_values.reset(new int32_t[count]());
+  _resetDeltaState();
+  if (!m_snapshotValues) {
+    m_snapshotValues.reset(new int32_t[2 * count]);
+    m_snapshotCount.store(count, std::memory_order_release);
+  }
   if (m_callback)
     m_callback->controllerConnected();
 }
 
 void GenericPad::receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) {
   std::lock_guard<std::mutex> lk(m_callbackLock);
-  if (length == 0 || tp != HIDReportType::Input || !m_callback)
+  if (length == 0 || tp != HIDReportType::Input || !m_values)
     return;
-  std::function<bool(const HIDMainItem&, int32_t)> func = [this](const HIDMainItem& item, int32_t value) {
-    m_callback->valueUpdate(item, value);
+  if (_processReport(data, length))
+    _reportDelivered();
+}
+
+/* Decode, publish and deliver one input report; false if it matched no known report */
+bool GenericPad::_processReport(const uint8_t* data, size_t length) {
+  if (m_deltaReporting && _reportUnchanged(data, length)) {
+    /* Still a report as far as pollers are concerned */
+    _reportDecoded();
+    _publishSnapshot();
+    return true;
+  }
+  const auto range = m_parser.ExtractValues(data, length, m_values.get());
+  if (range.first == range.second)
+    return false;
+  _reportDecoded();
+  _publishSnapshot();
+  if (!m_callback)
     return true;
-  };
-  m_parser.ScanValues(func, data, length);
+
+  if (!m_deltaReporting) {
+    for (uint32_t i = range.first; i < range.second; ++i)
+      m_callback->valueUpdate(m_parser.GetValueItem(i), m_values[i]);
+    return true;
+  }
+
+  for (uint32_t i = range.first; i < range.second; ++i) {
+    ValueState& state = m_valueStates[i];
+    const HIDMainItem& item = m_parser.GetValueItem(i);
+    int32_t value = m_values[i];
+    if (state.m_deadzone && std::abs(int64_t(value) - state.m_center) <= state.m_deadzone)
+      value = state.m_center;
+    if (state.m_reported) {
+      if (value == state.m_last)
+        continue;
+      if (std::abs(int64_t(value) - state.m_last) <= state.m_epsilon && value != state.m_center &&
+          value != item.m_logicalRange.first && value != item.m_logicalRange.second)
+        continue;
+    }
+    state.m_last = value;
+    state.m_reported = true;
+    m_callback->valueUpdate(item, value);
+  }
+  return true;
+}
+
+void GenericPad::_publishSnapshot() {
+  size_t count = m_snapshotCount.load(std::memory_order_relaxed);
+  uint64_t n = m_snapshotSeq.beginWrite();
+  std::copy(m_values.get(), m_values.get() + count, &m_snapshotValues[(n & 1) * count]);
+  m_snapshotTimes[n & 1] = std::chrono::steady_clock::now();
+  m_snapshotArrivals[n & 1] = getReportArrival();
+  m_snapshotSeq.endWrite(n);
+}
+
+bool GenericPad::getSnapshot(InputSnapshot<std::vector<int32_t>>& out) const {
+  size_t count = m_snapshotCount.load(std::memory_order_acquire);
+  if (!count)
+    return false;
+  out.m_state.resize(count);
+  while (true) {
+    uint64_t n = m_snapshotSeq.beginRead();
+    if (n == 0)
+      return false;
+    std::copy(&m_snapshotValues[(n & 1) * count], &m_snapshotValues[(n & 1) * count] + count, out.m_state.begin());
+    out.m_timestamp = m_snapshotTimes[n & 1];
+    out.m_arrival = m_snapshotArrivals[n & 1];
+    out.m_reportCount = n;
+    if (m_snapshotSeq.endRead(n))
+      return true;
+  }
+}
+
+void GenericPad::setDeltaReporting(bool enabled) {
+  std::lock_guard<std::mutex> lk(m_callbackLock);
+  m_deltaReporting = enabled;
+  _resetDeltaState();
+}
+
+void GenericPad::setAxisFilter(HIDUsagePage usagePage, HIDUsage usage, int32_t deadzone, int32_t epsilon) {
+  std::lock_guard<std::mutex> lk(m_callbackLock);
+  auto search = std::find_if(m_axisFilters.begin(), m_axisFilters.end(), [&](const AxisFilter& filter) {
+    return filter.m_usagePage == usagePage && filter.m_usage == usage;
+  });
+  if (search != m_axisFilters.end()) {
+    search->m_deadzone = deadzone;
+    search->m_epsilon = epsilon;
+  } else {
+    m_axisFilters.push_back({usagePage, usage, deadzone, epsilon});
+  }
+  _resetDeltaState();
+}
+
+void GenericPad::_resetDeltaState() {
+  /* Parser and value array are set up by initialCycle() */
+  m_lastReports.clear();
+  if (!m_values) {
+    m_valueStates.reset();
+    return;
+  }
+
+  size_t count = m_parser.GetValueCount();
+  m_valueStates.reset(new ValueState[count]);
+  for (size_t i = 0; i < count; ++i) {
+    const HIDMainItem& item = m_parser.GetValueItem(i);
+    ValueState& state = m_valueStates[i];
+    state.m_center = int32_t((int64_t(item.m_logicalRange.first) + item.m_logicalRange.second) / 2);
+    for (const AxisFilter& filter : m_axisFilters) {
+      if (filter.m_usagePage == item.m_usagePage && filter.m_usage == item.m_usage) {
+        state.m_deadzone = filter.m_deadzone;
+        state.m_epsilon = filter.m_epsilon;
+        break;
+      }
+    }
+  }
+}
+
+bool GenericPad::_reportUnchanged(const uint8_t* data, size_t length) {
+  /* Devices rarely have more than a few report IDs; a linear search beats hashing */
+  uint8_t reportId = m_parser.HasReportIDs() ? data[0] : 0;
+  for (auto& last : m_lastReports) {
+    if (last.first != reportId)
+      continue;
+    if (last.second.size() == length && std::memcmp(last.second.data(), data, length) == 0)
+      return true;
+    last.second.assign(data, data + length);
+    return false;
+  }
+  m_lastReports.emplace_back(reportId, std::vector<uint8_t>(data, data + length));
+  return false;
 }
 
 void GenericPad::enumerateValues(const std::function<bool(const HIDMainItem& item)>& valueCB) const {
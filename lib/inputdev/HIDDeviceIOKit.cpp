@@ -195,7 +195,8 @@ class HIDDeviceIOKit : public IHIDDevice {
 
   static void _hidReportCb(void* _Nullable context, IOReturn, void* _Nullable, IOHIDReportType type, uint32_t reportID,
                            uint8_t* report, CFIndex reportLength) {
-    reinterpret_cast<DeviceBase*>(context)->receivedHIDReport(report, reportLength, HIDReportType(type), reportID);
+    reinterpret_cast<DeviceBase*>(context)->_receivedHIDReport(report, reportLength, HIDReportType(type), reportID,
+                                                               std::chrono::steady_clock::now());
   }
 
   static void _threadProcHID(std::shared_ptr<HIDDeviceIOKit> device) {
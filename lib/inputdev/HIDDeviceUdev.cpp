@@ -1,5 +1,8 @@
 #include "lib/inputdev/IHIDDevice.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdio>
 #include <cstring>
@@ -8,7 +11,9 @@
 
 #include "boo/inputdev/DeviceToken.hpp"
 #include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/DeviceFinder.hpp"
 #include "boo/inputdev/HIDParser.hpp"
+#include "lib/inputdev/HIDReactorUdev.hpp"
 
 #include <fcntl.h>
 #include <libudev.h>
@@ -16,7 +21,10 @@
 #include <linux/usbdevice_fs.h>
 #include <linux/input.h>
 #include <linux/hidraw.h>
+#include <poll.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 namespace boo {
@@ -27,13 +35,111 @@ udev* GetUdev();
  * Reference: http://tali.admingilde.org/linux-docbook/usb/ch07s06.html
  */
 
-class HIDDeviceUdev final : public IHIDDevice {
+/* Interrupt IN URBs kept queued on one endpoint, so the host controller always has a
+ * transfer posted and the polling rate is bounded by the device rather than by ioctl
+ * round-trips. Buffers are mapped from usbfs where supported (Linux 4.6+), letting the
+ * controller DMA straight into them instead of the kernel copying each transfer out. */
+class USBInterruptQueue {
+public:
+  static constexpr unsigned Depth = 4;
+
+private:
+  int m_fd = -1;
+  unsigned m_endpoint = 0;
+  size_t m_length = 0;
+  uint8_t* m_buffers = nullptr;
+  size_t m_mapSize = 0;
+  std::unique_ptr<uint8_t[]> m_heapBuffers;
+  std::unique_ptr<usbdevfs_urb> m_urbs[Depth];
+  unsigned m_submitted = 0;
+
+public:
+  ~USBInterruptQueue() { stop(); }
+
+  bool start(int fd, unsigned endpoint, size_t length) {
+    m_fd = fd;
+    m_endpoint = endpoint | USB_DIR_IN;
+    m_length = length;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    m_mapSize = (Depth * length + pageSize - 1) / pageSize * pageSize;
+    void* map = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED) {
+      m_buffers = static_cast<uint8_t*>(map);
+    } else {
+      m_mapSize = 0;
+      m_heapBuffers.reset(new uint8_t[Depth * length]);
+      m_buffers = m_heapBuffers.get();
+    }
+
+    for (unsigned i = 0; i < Depth; ++i) {
+      m_urbs[i] = std::make_unique<usbdevfs_urb>();
+      if (!submit(m_urbs[i].get(), i))
+        return false;
+    }
+    return true;
+  }
+
+  bool submit(usbdevfs_urb* urb, unsigned index) {
+    std::memset(urb, 0, sizeof(usbdevfs_urb));
+    urb->type = USBDEVFS_URB_TYPE_INTERRUPT;
+    urb->endpoint = m_endpoint;
+    urb->buffer = m_buffers + index * m_length;
+    urb->buffer_length = int(m_length);
+    urb->usercontext = reinterpret_cast<void*>(uintptr_t(index));
+    if (ioctl(m_fd, USBDEVFS_SUBMITURB, urb) != 0)
+      return false;
+    ++m_submitted;
+    return true;
+  }
+
+  /* Reap one completed URB without blocking; nullptr if none are done */
+  usbdevfs_urb* reap() {
+    usbdevfs_urb* urb;
+    if (ioctl(m_fd, USBDEVFS_REAPURBNDELAY, &urb) != 0)
+      return nullptr;
+    --m_submitted;
+    return urb;
+  }
+
+  bool resubmit(usbdevfs_urb* urb) { return submit(urb, unsigned(reinterpret_cast<uintptr_t>(urb->usercontext))); }
+
+  /* Clear a stalled endpoint so requeued URBs are not completed with -EPIPE again */
+  bool clearHalt() {
+    unsigned endpoint = m_endpoint;
+    return ioctl(m_fd, USBDEVFS_CLEAR_HALT, &endpoint) == 0;
+  }
+
+  /* Cancel everything in flight and wait until the kernel is done with the buffers */
+  void stop() {
+    if (m_fd < 0)
+      return;
+    for (unsigned i = 0; i < Depth; ++i)
+      if (m_urbs[i])
+        ioctl(m_fd, USBDEVFS_DISCARDURB, m_urbs[i].get());
+    while (m_submitted) {
+      usbdevfs_urb* urb;
+      if (ioctl(m_fd, USBDEVFS_REAPURB, &urb) != 0)
+        break;
+      --m_submitted;
+    }
+    if (m_mapSize)
+      munmap(m_buffers, m_mapSize);
+    m_buffers = nullptr;
+    m_mapSize = 0;
+    m_heapBuffers.reset();
+    m_fd = -1;
+  }
+};
+
+class HIDDeviceUdev final : public IHIDDevice, public HIDReactor::ISource {
   DeviceToken& m_token;
   std::shared_ptr<DeviceBase> m_devImp;
 
   int m_devFd = 0;
   unsigned m_usbIntfInPipe = 0;
   unsigned m_usbIntfOutPipe = 0;
+  unsigned m_usbIntfInPacketSize = 0;
   bool m_runningTransferLoop = false;
 
   std::string_view m_devPath;
@@ -41,6 +147,28 @@ class HIDDeviceUdev final : public IHIDDevice {
   std::condition_variable m_initCond;
   std::thread m_thread;
 
+  /* hidraw input reports, sized from the report descriptor */
+  std::unique_ptr<uint8_t[]> m_readBuf;
+  size_t m_readSz = 0;
+
+  /* Asynchronous USB input: each reaped URB is handed to the next transferCycle() */
+  std::unique_ptr<USBInterruptQueue> m_inQueue;
+  static constexpr unsigned MaxInQueueFailures = 8;
+  unsigned m_inQueueFailures = 0;
+  const uint8_t* m_reapedIn = nullptr;
+  size_t m_reapedInLen = 0;
+  std::chrono::steady_clock::time_point m_reapedInTime;
+
+  /* Reactor mode: the device is registered with HIDReactor instead of owning a thread */
+  bool m_reactor = false;
+  bool m_usb = false;
+  std::atomic<uint64_t> m_reactorId = 0;
+  std::mutex m_stopMutex;
+  std::condition_variable m_stopCond;
+  bool m_reactorStopping = false;
+  bool m_reactorStopped = false;
+  std::thread::id m_stopThread;
+
   bool _sendUSBInterruptTransfer(const uint8_t* data, size_t length) override {
     if (m_devFd) {
       usbdevfs_bulktransfer xfer = {m_usbIntfOutPipe | USB_DIR_OUT, (unsigned)length, 30, (void*)data};
@@ -53,6 +181,15 @@ class HIDDeviceUdev final : public IHIDDevice {
   }
 
   size_t _receiveUSBInterruptTransfer(uint8_t* data, size_t length) override {
+    if (m_inQueue) {
+      /* Never blocks; only data reaped for the current transferCycle() is available */
+      if (!m_reapedIn)
+        return 0;
+      size_t len = std::min(length, m_reapedInLen);
+      memmove(data, m_reapedIn, len);
+      m_reapedIn = nullptr;
+      return len;
+    }
     if (m_devFd) {
       usbdevfs_bulktransfer xfer = {m_usbIntfInPipe | USB_DIR_IN, (unsigned)length, 30, data};
       return ioctl(m_devFd, USBDEVFS_BULK, &xfer);
@@ -60,23 +197,20 @@ class HIDDeviceUdev final : public IHIDDevice {
     return 0;
   }
 
-  static void _threadProcUSBLL(std::shared_ptr<HIDDeviceUdev> device) {
-    int i;
-    std::unique_lock<std::mutex> lk(device->m_initMutex);
-    udev_device* udevDev = udev_device_new_from_syspath(GetUdev(), device->m_devPath.data());
+  std::chrono::steady_clock::time_point _receiveTime() override {
+    return m_inQueue ? m_reapedInTime : std::chrono::steady_clock::now();
+  }
 
-    /* Get device file */
+  /* Open the usbfs node, locate the interrupt endpoints and detach the kernel driver */
+  bool _openUSB(udev_device* udevDev) {
+    int i;
     const char* dp = udev_device_get_devnode(udevDev);
     int fd = open(dp, O_RDWR);
     if (fd < 0) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"),
-        device->m_token.getProductName(), dp, strerror(errno));
-      lk.unlock();
-      device->m_initCond.notify_one();
-      udev_device_unref(udevDev);
-      return;
+      m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"), m_token.getProductName(), dp, strerror(errno));
+      return false;
     }
-    device->m_devFd = fd;
+    m_devFd = fd;
     usb_device_descriptor devDesc = {};
     read(fd, &devDesc, 1);
     read(fd, &devDesc.bDescriptorType, devDesc.bLength - 1);
@@ -93,10 +227,11 @@ class HIDDeviceUdev final : public IHIDDevice {
           read(fd, &endpDesc, 1);
           read(fd, &endpDesc.bDescriptorType, endpDesc.bLength - 1);
           if ((endpDesc.bmAttributes & USB_ENDPOINT_XFERTYPE_MASK) == USB_ENDPOINT_XFER_INT) {
-            if ((endpDesc.bEndpointAddress & USB_ENDPOINT_DIR_MASK) == USB_DIR_IN)
-              device->m_usbIntfInPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
-            else if ((endpDesc.bEndpointAddress & USB_ENDPOINT_DIR_MASK) == USB_DIR_OUT)
-              device->m_usbIntfOutPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
+            if ((endpDesc.bEndpointAddress & USB_ENDPOINT_DIR_MASK) == USB_DIR_IN) {
+              m_usbIntfInPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
+              m_usbIntfInPacketSize = endpDesc.wMaxPacketSize & 0x7ff;
+            } else if ((endpDesc.bEndpointAddress & USB_ENDPOINT_DIR_MASK) == USB_DIR_OUT)
+              m_usbIntfOutPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
           }
         }
       }
@@ -105,6 +240,54 @@ class HIDDeviceUdev final : public IHIDDevice {
     /* Request that kernel disconnects existing driver */
     usbdevfs_ioctl disconnectReq = {0, USBDEVFS_DISCONNECT, nullptr};
     ioctl(fd, USBDEVFS_IOCTL, &disconnectReq);
+    return true;
+  }
+
+  /* Open the hidraw node non-blocking */
+  bool _openHID(udev_device* udevDev) {
+    const char* dp = udev_device_get_devnode(udevDev);
+    int fd = open(dp, O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+      m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"), m_token.getProductName(), dp, strerror(errno));
+      return false;
+    }
+    m_devFd = fd;
+    return true;
+  }
+
+  /* Size the input report buffer from the report descriptor */
+  bool _allocReportBuffer() {
+    /* Report descriptor size */
+    int reportDescSize;
+    if (ioctl(m_devFd, HIDIOCGRDESCSIZE, &reportDescSize) == -1) {
+      m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESCSIZE) {}@{}: {}\n"), m_token.getProductName(),
+                            m_devPath, strerror(errno));
+      return false;
+    }
+
+    /* Get report descriptor */
+    hidraw_report_descriptor reportDesc;
+    reportDesc.size = reportDescSize;
+    if (ioctl(m_devFd, HIDIOCGRDESC, &reportDesc) == -1) {
+      m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESC) {}@{}: {}\n"), m_token.getProductName(),
+                            m_devPath, strerror(errno));
+      return false;
+    }
+    m_readSz = HIDParser::CalculateMaxInputReportSize(reportDesc.value, reportDesc.size);
+    m_readBuf.reset(new uint8_t[m_readSz]);
+    return true;
+  }
+
+  static void _threadProcUSBLL(std::shared_ptr<HIDDeviceUdev> device) {
+    std::unique_lock<std::mutex> lk(device->m_initMutex);
+    udev_device* udevDev = udev_device_new_from_syspath(GetUdev(), device->m_devPath.data());
+
+    if (!device->_openUSB(udevDev)) {
+      lk.unlock();
+      device->m_initCond.notify_one();
+      udev_device_unref(udevDev);
+      return;
+    }
 
     /* Return control to main thread */
     device->m_runningTransferLoop = true;
@@ -113,12 +296,22 @@ class HIDDeviceUdev final : public IHIDDevice {
 
     /* Start transfer loop */
     device->m_devImp->initialCycle();
-    while (device->m_runningTransferLoop)
-      device->m_devImp->transferCycle();
+    if (device->_startInQueue()) {
+      pollfd pfd = {device->m_devFd, POLLOUT, 0};
+      while (device->m_runningTransferLoop) {
+        if (poll(&pfd, 1, 30) > 0 && !device->_reapInQueue())
+          break;
+      }
+    } else {
+      /* Synchronous fallback */
+      while (device->m_runningTransferLoop)
+        device->m_devImp->transferCycle();
+    }
     device->m_devImp->finalCycle();
 
     /* Cleanup */
-    close(fd);
+    device->m_inQueue.reset();
+    close(device->m_devFd);
     device->m_devFd = 0;
     udev_device_unref(udevDev);
   }
@@ -145,44 +338,23 @@ class HIDDeviceUdev final : public IHIDDevice {
     std::unique_lock<std::mutex> lk(device->m_initMutex);
     udev_device* udevDev = udev_device_new_from_syspath(GetUdev(), device->m_devPath.data());
 
-    /* Get device file */
-    const char* dp = udev_device_get_devnode(udevDev);
-    int fd = open(dp, O_RDWR | O_NONBLOCK);
-    if (fd < 0) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"),
-                                    device->m_token.getProductName(), dp, strerror(errno));
+    if (!device->_openHID(udevDev)) {
       lk.unlock();
       device->m_initCond.notify_one();
       udev_device_unref(udevDev);
       return;
     }
-    device->m_devFd = fd;
+    int fd = device->m_devFd;
 
     /* Return control to main thread */
     device->m_runningTransferLoop = true;
     lk.unlock();
     device->m_initCond.notify_one();
 
-    /* Report descriptor size */
-    int reportDescSize;
-    if (ioctl(fd, HIDIOCGRDESCSIZE, &reportDescSize) == -1) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESCSIZE) {}@{}: {}\n"),
-                                    device->m_token.getProductName(), dp, strerror(errno));
-      close(fd);
-      return;
-    }
-
-    /* Get report descriptor */
-    hidraw_report_descriptor reportDesc;
-    reportDesc.size = reportDescSize;
-    if (ioctl(fd, HIDIOCGRDESC, &reportDesc) == -1) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESC) {}@{}: {}\n"),
-                                    device->m_token.getProductName(), dp, strerror(errno));
+    if (!device->_allocReportBuffer()) {
       close(fd);
       return;
     }
-    size_t readSz = HIDParser::CalculateMaxInputReportSize(reportDesc.value, reportDesc.size);
-    std::unique_ptr<uint8_t[]> readBuf(new uint8_t[readSz]);
 
     /* Start transfer loop */
     device->m_devImp->initialCycle();
@@ -193,10 +365,11 @@ class HIDDeviceUdev final : public IHIDDevice {
       struct timeval timeout = {0, 10000};
       if (select(fd + 1, &readset, nullptr, nullptr, &timeout) > 0) {
         while (true) {
-          ssize_t sz = read(fd, readBuf.get(), readSz);
+          ssize_t sz = read(fd, device->m_readBuf.get(), device->m_readSz);
           if (sz < 0)
             break;
-          device->m_devImp->receivedHIDReport(readBuf.get(), sz, HIDReportType::Input, readBuf[0]);
+          device->m_devImp->_receivedHIDReport(device->m_readBuf.get(), sz, HIDReportType::Input,
+                                              device->m_readBuf[0], std::chrono::steady_clock::now());
         }
       }
       if (device->m_runningTransferLoop)
@@ -210,7 +383,140 @@ class HIDDeviceUdev final : public IHIDDevice {
     udev_device_unref(udevDev);
   }
 
-  void _deviceDisconnected() override { m_runningTransferLoop = false; }
+  bool _startInQueue() {
+    m_inQueue = std::make_unique<USBInterruptQueue>();
+    if (!m_inQueue->start(m_devFd, m_usbIntfInPipe, m_usbIntfInPacketSize ? m_usbIntfInPacketSize : 64)) {
+      m_inQueue.reset();
+      return false;
+    }
+    return true;
+  }
+
+  /* Hand every completed IN URB to transferCycle() and requeue it; false once the device is gone
+   * or keeps failing, since a failed URB completes again immediately on every resubmit */
+  bool _reapInQueue() {
+    while (m_runningTransferLoop) {
+      usbdevfs_urb* urb = m_inQueue->reap();
+      if (!urb)
+        return errno == EAGAIN;
+      if (urb->status == -ENODEV || urb->status == -ESHUTDOWN)
+        return false;
+      if (urb->status != 0) {
+        m_devImp->deviceError(FMT_STRING("USB interrupt transfer failed {}: {}\n"), m_token.getProductName(),
+                              strerror(-urb->status));
+        if (++m_inQueueFailures >= MaxInQueueFailures) {
+          m_devImp->deviceError(FMT_STRING("Stopping {} after {} consecutive transfer failures\n"),
+                                m_token.getProductName(), m_inQueueFailures);
+          return false;
+        }
+        if (urb->status == -EPIPE)
+          m_inQueue->clearHalt();
+      } else {
+        m_inQueueFailures = 0;
+        m_reapedIn = static_cast<const uint8_t*>(urb->buffer);
+        m_reapedInLen = size_t(urb->actual_length);
+        m_reapedInTime = std::chrono::steady_clock::now();
+        m_devImp->transferCycle();
+        m_reapedIn = nullptr;
+      }
+      if (m_runningTransferLoop && !m_inQueue->resubmit(urb))
+        return false;
+    }
+    return true;
+  }
+
+  /* Open synchronously on the caller's thread, then hand the fd to the reactor */
+  bool _startReactor() {
+    udev_device* udevDev = udev_device_new_from_syspath(GetUdev(), m_devPath.data());
+    bool opened = m_usb ? _openUSB(udevDev) : (_openHID(udevDev) && _allocReportBuffer());
+    udev_device_unref(udevDev);
+    if (!opened) {
+      if (m_devFd) {
+        close(m_devFd);
+        m_devFd = 0;
+      }
+      return false;
+    }
+
+    m_reactor = true;
+    m_runningTransferLoop = true;
+    m_devImp->initialCycle();
+
+    if (m_usb && !_startInQueue()) {
+      m_devImp->deviceError(FMT_STRING("Unable to submit URB {}: {}\n"), m_token.getProductName(), strerror(errno));
+      _stopReactor();
+      return false;
+    }
+
+    /* usbfs signals EPOLLOUT once a URB can be reaped */
+    m_reactorId = HIDReactor::Instance().add(m_devFd, m_usb ? EPOLLOUT : EPOLLIN,
+                                             std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()));
+    if (!m_reactorId) {
+      _stopReactor();
+      return false;
+    }
+    return true;
+  }
+
+  /* A hangup on the reactor thread may race a client close; only one tears down, and a client
+   * that loses waits until finalCycle() and the close are done, as joining the thread did */
+  void _stopReactor(bool fromReactor = false) {
+    {
+      std::unique_lock<std::mutex> lk(m_stopMutex);
+      if (m_reactorStopping) {
+        /* The reactor thread must not wait: a tearing-down client is waiting for its callback to return */
+        if (!fromReactor && m_stopThread != std::this_thread::get_id())
+          m_stopCond.wait(lk, [this]() { return m_reactorStopped; });
+        return;
+      }
+      m_reactorStopping = true;
+      m_stopThread = std::this_thread::get_id();
+    }
+
+    m_runningTransferLoop = false;
+    if (uint64_t id = m_reactorId.exchange(0))
+      HIDReactor::Instance().remove(id, m_devFd);
+    m_devImp->finalCycle();
+
+    m_inQueue.reset();
+    close(m_devFd);
+    m_devFd = 0;
+
+    {
+      std::lock_guard<std::mutex> lk(m_stopMutex);
+      m_reactorStopped = true;
+    }
+    m_stopCond.notify_all();
+  }
+
+  void _reactorReady(uint32_t events) override {
+    if (m_usb) {
+      if (!_reapInQueue()) {
+        _stopReactor(true);
+        return;
+      }
+    } else {
+      while (m_runningTransferLoop) {
+        ssize_t sz = read(m_devFd, m_readBuf.get(), m_readSz);
+        if (sz < 0)
+          break;
+        m_devImp->_receivedHIDReport(m_readBuf.get(), sz, HIDReportType::Input, m_readBuf[0],
+                                     std::chrono::steady_clock::now());
+      }
+      if (m_runningTransferLoop)
+        m_devImp->transferCycle();
+    }
+
+    if (events & (EPOLLHUP | EPOLLERR))
+      _stopReactor(true);
+  }
+
+  void _deviceDisconnected() override {
+    if (m_reactor)
+      _stopReactor();
+    else
+      m_runningTransferLoop = false;
+  }
 
   std::vector<uint8_t> _getReportDescriptor() override {
     /* Report descriptor size */
@@ -263,8 +569,16 @@ public:
   : m_token(token), m_devImp(devImp), m_devPath(token.getDevicePath()) {}
 
   void _startThread() override {
-    std::unique_lock<std::mutex> lk(m_initMutex);
     DeviceType dType = m_token.getDeviceType();
+    DeviceFinder* finder = DeviceFinder::instance();
+    if ((dType == DeviceType::USB || dType == DeviceType::HID) && finder &&
+        finder->getIOBackend() == HIDIOBackend::Reactor) {
+      m_usb = dType == DeviceType::USB;
+      _startReactor();
+      return;
+    }
+
+    std::unique_lock<std::mutex> lk(m_initMutex);
     if (dType == DeviceType::USB)
       m_thread = std::thread(_threadProcUSBLL, std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()));
     else if (dType == DeviceType::Bluetooth)
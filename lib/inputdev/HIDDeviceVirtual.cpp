@@ -0,0 +1,321 @@
+#include "boo/inputdev/VirtualHIDDevice.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "boo/inputdev/DeviceFinder.hpp"
+#include "boo/inputdev/IHIDListener.hpp"
+#include "lib/inputdev/IHIDDevice.hpp"
+
+#include <fmt/format.h>
+
+namespace boo {
+class HIDDeviceVirtual;
+
+struct VirtualHIDDevice::State : IHIDDeviceSource, std::enable_shared_from_this<VirtualHIDDevice::State> {
+  DeviceType m_type;
+  unsigned m_vid;
+  unsigned m_pid;
+  std::string m_productName;
+  std::string m_path;
+  std::vector<uint8_t> m_descriptor;
+
+  /* Stands in for the I/O thread: pad cycles and callbacks run under this, one at a time.
+   * Recursive so a pad callback may close its own device. */
+  std::recursive_mutex m_ioLock;
+
+  std::mutex m_lock;
+  std::weak_ptr<HIDDeviceVirtual> m_device;
+  OutputCallback m_outputCallback;
+  std::vector<VirtualHIDOutput> m_outputs;
+  std::map<std::pair<HIDReportType, uint32_t>, std::vector<uint8_t>> m_responses;
+
+  std::shared_ptr<HIDDeviceVirtual> device() {
+    std::lock_guard<std::mutex> lk(m_lock);
+    return m_device.lock();
+  }
+
+  void output(VirtualHIDOutput&& out) {
+    std::unique_lock<std::mutex> lk(m_lock);
+    if (!m_outputCallback) {
+      m_outputs.push_back(std::move(out));
+      return;
+    }
+    OutputCallback callback = m_outputCallback;
+    lk.unlock();
+    callback(out);
+  }
+
+  size_t response(uint8_t* data, size_t length, HIDReportType tp, uint32_t message) {
+    std::lock_guard<std::mutex> lk(m_lock);
+    auto search = m_responses.find({tp, message});
+    if (search == m_responses.end())
+      return 0;
+    size_t len = std::min(length, search->second.size());
+    std::memcpy(data, search->second.data(), len);
+    return len;
+  }
+
+  std::shared_ptr<IHIDDevice> newHIDDevice(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp) override;
+};
+
+class HIDDeviceVirtual final : public IHIDDevice {
+  std::shared_ptr<DeviceBase> m_devImp;
+  std::shared_ptr<VirtualHIDDevice::State> m_state;
+  bool m_running = false;
+  const uint8_t* m_pendingTransfer = nullptr;
+  size_t m_pendingLength = 0;
+
+  void _deviceDisconnected() override { stop(); }
+
+  bool _sendUSBInterruptTransfer(const uint8_t* data, size_t length) override {
+    m_state->output({true, HIDReportType::Output, 0, std::vector<uint8_t>(data, data + length)});
+    return true;
+  }
+
+  size_t _receiveUSBInterruptTransfer(uint8_t* data, size_t length) override {
+    if (!m_pendingTransfer)
+      return 0;
+    size_t len = std::min(length, m_pendingLength);
+    std::memcpy(data, m_pendingTransfer, len);
+    m_pendingTransfer = nullptr;
+    return len;
+  }
+
+#if _WIN32
+#if !WINDOWS_STORE
+  const PHIDP_PREPARSED_DATA _getReportDescriptor() override { return {}; }
+#endif
+#else
+  std::vector<uint8_t> _getReportDescriptor() override { return m_state->m_descriptor; }
+#endif
+
+  bool _sendHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override {
+    m_state->output({false, tp, message, std::vector<uint8_t>(data, data + length)});
+    return true;
+  }
+
+  size_t _receiveHIDReport(uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override {
+    return m_state->response(data, length, tp, message);
+  }
+
+public:
+  HIDDeviceVirtual(const std::shared_ptr<DeviceBase>& devImp, std::shared_ptr<VirtualHIDDevice::State> state)
+  : m_devImp(devImp), m_state(std::move(state)) {}
+
+  void _startThread() override {
+    std::lock_guard<std::recursive_mutex> lk(m_state->m_ioLock);
+    m_running = true;
+    m_devImp->initialCycle();
+  }
+
+  void stop() {
+    std::lock_guard<std::recursive_mutex> lk(m_state->m_ioLock);
+    if (!m_running)
+      return;
+    m_running = false;
+    m_devImp->finalCycle();
+  }
+
+  bool isOpen() {
+    std::lock_guard<std::recursive_mutex> lk(m_state->m_ioLock);
+    return m_running;
+  }
+
+  bool injectHIDReport(const uint8_t* data, size_t length, uint32_t message) {
+    std::lock_guard<std::recursive_mutex> lk(m_state->m_ioLock);
+    if (!m_running)
+      return false;
+    m_devImp->_receivedHIDReport(data, length, HIDReportType::Input, message, std::chrono::steady_clock::now());
+    return true;
+  }
+
+  bool transferCycle(const uint8_t* data, size_t length) {
+    std::lock_guard<std::recursive_mutex> lk(m_state->m_ioLock);
+    if (!m_running)
+      return false;
+    m_pendingTransfer = data;
+    m_pendingLength = length;
+    m_devImp->transferCycle();
+    m_pendingTransfer = nullptr;
+    return true;
+  }
+};
+
+std::shared_ptr<IHIDDevice> VirtualHIDDevice::State::newHIDDevice(DeviceToken& token,
+                                                                  const std::shared_ptr<DeviceBase>& devImp) {
+  auto device = std::make_shared<HIDDeviceVirtual>(devImp, shared_from_this());
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_device = device;
+  return device;
+}
+
+/* Enumerates the plugged-in VirtualHIDDevices for a DeviceFinder */
+class HIDListenerVirtual final : public IHIDListener {
+  DeviceFinder& m_finder;
+  std::atomic_bool m_scanningEnabled = false;
+
+public:
+  explicit HIDListenerVirtual(DeviceFinder& finder);
+  ~HIDListenerVirtual() override;
+
+  void deviceConnected(const std::shared_ptr<VirtualHIDDevice::State>& state) {
+    /* Prevent redundant registration */
+    if (m_finder._hasToken(state->m_path))
+      return;
+    auto token = std::make_unique<DeviceToken>(state->m_type, state->m_vid, state->m_pid, "",
+                                               state->m_productName.c_str(), state->m_path.c_str());
+    token->m_hidSource = state;
+    m_finder._insertToken(std::move(token));
+  }
+
+  void hotplugConnected(const std::shared_ptr<VirtualHIDDevice::State>& state) {
+    if (m_scanningEnabled)
+      deviceConnected(state);
+  }
+
+  void deviceDisconnected(const std::string& path) { m_finder._removeToken(path); }
+
+  bool startScanning() override;
+  bool stopScanning() override;
+  bool scanNow() override;
+
+#if _WIN32 && !WINDOWS_STORE
+  bool _extDevConnect(const char* path) override { return false; }
+  bool _extDevDisconnect(const char* path) override { return false; }
+#endif
+};
+
+namespace {
+/* Plugged-in devices and the listener (at most one, as for DeviceFinder) notified of changes */
+class VirtualHIDRegistry {
+  std::recursive_mutex m_lock;
+  std::vector<std::shared_ptr<VirtualHIDDevice::State>> m_devices;
+  HIDListenerVirtual* m_listener = nullptr;
+  std::atomic<uint64_t> m_nextId{0};
+
+public:
+  static VirtualHIDRegistry& Instance() {
+    static VirtualHIDRegistry registry;
+    return registry;
+  }
+
+  uint64_t nextId() { return m_nextId.fetch_add(1, std::memory_order_relaxed); }
+
+  void plug(std::shared_ptr<VirtualHIDDevice::State> state) {
+    std::lock_guard<std::recursive_mutex> lk(m_lock);
+    m_devices.push_back(state);
+    if (m_listener)
+      m_listener->hotplugConnected(state);
+  }
+
+  void unplug(const std::shared_ptr<VirtualHIDDevice::State>& state) {
+    std::lock_guard<std::recursive_mutex> lk(m_lock);
+    m_devices.erase(std::remove(m_devices.begin(), m_devices.end(), state), m_devices.end());
+    if (m_listener)
+      m_listener->deviceDisconnected(state->m_path);
+  }
+
+  void scan(HIDListenerVirtual& listener) {
+    std::lock_guard<std::recursive_mutex> lk(m_lock);
+    /* Copied, as deviceConnected() callbacks may plug in more devices */
+    auto devices = m_devices;
+    for (const auto& state : devices)
+      listener.deviceConnected(state);
+  }
+
+  void setListener(HIDListenerVirtual* listener) {
+    std::lock_guard<std::recursive_mutex> lk(m_lock);
+    m_listener = listener;
+  }
+};
+} // Anonymous namespace
+
+HIDListenerVirtual::HIDListenerVirtual(DeviceFinder& finder) : m_finder(finder) {
+  VirtualHIDRegistry::Instance().setListener(this);
+}
+
+HIDListenerVirtual::~HIDListenerVirtual() { VirtualHIDRegistry::Instance().setListener(nullptr); }
+
+bool HIDListenerVirtual::startScanning() {
+  m_scanningEnabled = true;
+  VirtualHIDRegistry::Instance().scan(*this);
+  return true;
+}
+
+bool HIDListenerVirtual::stopScanning() {
+  m_scanningEnabled = false;
+  return true;
+}
+
+bool HIDListenerVirtual::scanNow() {
+  VirtualHIDRegistry::Instance().scan(*this);
+  return true;
+}
+
+std::unique_ptr<IHIDListener> VirtualHIDListenerNew(DeviceFinder& finder) {
+  return std::make_unique<HIDListenerVirtual>(finder);
+}
+
+VirtualHIDDevice::VirtualHIDDevice(DeviceType type, unsigned vid, unsigned pid, std::string_view productName,
+                                   std::vector<uint8_t> descriptor)
+: m_state(std::make_shared<State>()) {
+  m_state->m_type = type;
+  m_state->m_vid = vid;
+  m_state->m_pid = pid;
+  m_state->m_productName = productName;
+  m_state->m_path = fmt::format(FMT_STRING("virtual:{}"), VirtualHIDRegistry::Instance().nextId());
+  m_state->m_descriptor = std::move(descriptor);
+  VirtualHIDRegistry::Instance().plug(m_state);
+}
+
+VirtualHIDDevice::~VirtualHIDDevice() {
+  VirtualHIDRegistry::Instance().unplug(m_state);
+  /* A pad opened outside a DeviceFinder keeps its backend; stop it here instead */
+  if (auto device = m_state->device())
+    device->stop();
+}
+
+std::string_view VirtualHIDDevice::getDevicePath() const { return m_state->m_path; }
+
+bool VirtualHIDDevice::isOpen() const {
+  auto device = m_state->device();
+  return device && device->isOpen();
+}
+
+bool VirtualHIDDevice::injectHIDReport(const uint8_t* data, size_t length, uint32_t message) {
+  auto device = m_state->device();
+  return device && device->injectHIDReport(data, length, message);
+}
+
+bool VirtualHIDDevice::injectUSBTransfer(const uint8_t* data, size_t length) {
+  auto device = m_state->device();
+  return device && device->transferCycle(data, length);
+}
+
+bool VirtualHIDDevice::runTransferCycle() {
+  auto device = m_state->device();
+  return device && device->transferCycle(nullptr, 0);
+}
+
+void VirtualHIDDevice::setReportResponse(HIDReportType tp, uint32_t message, std::vector<uint8_t> data) {
+  std::lock_guard<std::mutex> lk(m_state->m_lock);
+  m_state->m_responses[{tp, message}] = std::move(data);
+}
+
+void VirtualHIDDevice::setOutputCallback(OutputCallback callback) {
+  std::lock_guard<std::mutex> lk(m_state->m_lock);
+  m_state->m_outputCallback = std::move(callback);
+}
+
+std::vector<VirtualHIDOutput> VirtualHIDDevice::takeOutputs() {
+  std::lock_guard<std::mutex> lk(m_state->m_lock);
+  return std::exchange(m_state->m_outputs, {});
+}
+
+} // namespace boo
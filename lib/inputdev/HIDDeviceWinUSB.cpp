@@ -316,7 +316,8 @@ public:
       }
     }
 
-    m_devImp->receivedHIDReport(inBuffer, BytesRead, HIDReportType::Input, inBuffer[0]);
+    m_devImp->_receivedHIDReport(inBuffer, BytesRead, HIDReportType::Input, inBuffer[0],
+                                 std::chrono::steady_clock::now());
   }
 };
 
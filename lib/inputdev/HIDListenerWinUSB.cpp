@@ -189,9 +189,11 @@ class HIDListenerWinUSB final : public IHIDListener {
             m_xinputPackets[i] = state.dwPacketNumber;
             if (tok.m_connectedDev) {
               XInputPad& pad = static_cast<XInputPad&>(*tok.m_connectedDev);
+              const XInputPadState padState = ConvertXInputState(state.Gamepad);
+              pad.m_snapshot.publish(padState);
               std::lock_guard<std::mutex> lk(pad.m_callbackLock);
               if (pad.m_callback)
-                pad.m_callback->controllerUpdate(pad, ConvertXInputState(state.Gamepad));
+                pad.m_callback->controllerUpdate(pad, padState);
             }
           }
           if (tok.m_connectedDev) {
@@ -2,7 +2,13 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdio>
+#include <cstring>
 #include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include <xxhash/xxhash.h>
 
 #undef min
 #undef max
@@ -499,8 +505,11 @@ HIDParser::ParserStatus HIDParser::Parse(const PHIDP_PREPARSED_DATA descriptorDa
   }
 
   m_itemPool.reserve(inputItems.size());
-  for (const auto& item : inputItems)
+  for (const auto& item : inputItems) {
+    if (!item.second.IsConstant())
+      m_valueItems.push_back(uint32_t(m_itemPool.size()));
     m_itemPool.push_back(item.second);
+  }
 
   m_status = ParserStatus::Done;
   return ParserStatus::Done;
@@ -551,6 +560,18 @@ static uint32_t GetShortValue(const uint8_t*& it, const uint8_t* end, int adv, H
   return 0;
 }
 
+/* [6.2.2.7] Logical Minimum is signed in the item's own width */
+static int32_t SignExtendShortValue(uint32_t data, int adv) {
+  switch (adv) {
+  case 1:
+    return int8_t(data);
+  case 2:
+    return int16_t(data);
+  default:
+    return int32_t(data);
+  }
+}
+
 HIDParser::ParserStatus HIDParser::ParseItem(HIDReports& reportsOut, std::stack<HIDItemState>& stateStack,
                                              std::stack<HIDCollectionItem>& collectionStack, const uint8_t*& it,
                                              const uint8_t* end, bool& multipleReports) {
@@ -604,7 +625,7 @@ HIDParser::ParserStatus HIDParser::ParseItem(HIDReports& reportsOut, std::stack<
         stateStack.top().m_usagePage = HIDUsagePage(data);
         break;
       case HIDItemTag::LogicalMinimum:
-        stateStack.top().m_logicalRange.first = data;
+        stateStack.top().m_logicalRange.first = SignExtendShortValue(data, head & 0x3);
         break;
       case HIDItemTag::LogicalMaximum:
         stateStack.top().m_logicalRange.second = data;
@@ -674,7 +695,150 @@ HIDParser::ParserStatus HIDParser::ParseItem(HIDReports& reportsOut, std::stack<
   return it == end ? ParserStatus::Done : ParserStatus::OK;
 }
 
+namespace {
+/* Compiled parsers by descriptor hash. The descriptor bytes are kept to rule out collisions
+ * and to be written out by SaveDescriptorCache(). */
+class DescriptorCache {
+  struct Entry {
+    std::vector<uint8_t> m_descriptor;
+    std::shared_ptr<const HIDParser> m_parser;
+  };
+  std::mutex m_lock;
+  std::unordered_map<uint64_t, Entry> m_entries;
+
+public:
+  static DescriptorCache& Instance() {
+    static DescriptorCache cache;
+    return cache;
+  }
+
+  std::shared_ptr<const HIDParser> find(uint64_t hash, const uint8_t* data, size_t len) {
+    std::lock_guard<std::mutex> lk(m_lock);
+    auto search = m_entries.find(hash);
+    if (search == m_entries.end() || search->second.m_descriptor.size() != len ||
+        std::memcmp(search->second.m_descriptor.data(), data, len) != 0)
+      return {};
+    return search->second.m_parser;
+  }
+
+  void insert(uint64_t hash, const uint8_t* data, size_t len, std::shared_ptr<const HIDParser> parser) {
+    std::lock_guard<std::mutex> lk(m_lock);
+    m_entries[hash] = {std::vector<uint8_t>(data, data + len), std::move(parser)};
+  }
+
+  std::vector<std::vector<uint8_t>> descriptors() {
+    std::lock_guard<std::mutex> lk(m_lock);
+    std::vector<std::vector<uint8_t>> ret;
+    ret.reserve(m_entries.size());
+    for (const auto& entry : m_entries)
+      ret.push_back(entry.second.m_descriptor);
+    return ret;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lk(m_lock);
+    m_entries.clear();
+  }
+};
+
+/* Cache file: magic, version, descriptor count, then each descriptor as a length and its bytes */
+constexpr uint32_t CacheMagic = 0x43444842; /* BHDC */
+constexpr uint32_t CacheVersion = 1;
+constexpr uint32_t MaxCachedDescriptorSize = 4096;
+} // Anonymous namespace
+
 HIDParser::ParserStatus HIDParser::Parse(const uint8_t* descriptorData, size_t len) {
+  uint64_t hash = XXH64(descriptorData, len, 0);
+  if (auto cached = DescriptorCache::Instance().find(hash, descriptorData, len)) {
+    _assign(*cached);
+    return m_status;
+  }
+
+  if (_parseDescriptor(descriptorData, len) == ParserStatus::Done) {
+    auto parser = std::make_shared<HIDParser>();
+    parser->_assign(*this);
+    DescriptorCache::Instance().insert(hash, descriptorData, len, std::move(parser));
+  }
+  return m_status;
+}
+
+void HIDParser::_assign(const HIDParser& other) {
+  m_status = other.m_status;
+  m_multipleReports = other.m_multipleReports;
+  m_inputReports = other.m_inputReports;
+  m_outputReports = other.m_outputReports;
+  m_featureReports = other.m_featureReports;
+
+  uint32_t reportCount = other.m_featureReports.second;
+  uint32_t itemCount = reportCount ? other.m_reportPool[reportCount - 1].second.second : 0;
+  m_itemPool.reset(new HIDMainItem[itemCount]);
+  std::copy(&other.m_itemPool[0], &other.m_itemPool[0] + itemCount, &m_itemPool[0]);
+  m_reportPool.reset(new Report[reportCount]);
+  std::copy(&other.m_reportPool[0], &other.m_reportPool[0] + reportCount, &m_reportPool[0]);
+
+  uint32_t planCount = other.m_inputReports.second - other.m_inputReports.first;
+  m_reportPlans.reset(new ReportPlan[planCount]);
+  std::copy(&other.m_reportPlans[0], &other.m_reportPlans[0] + planCount, &m_reportPlans[0]);
+  m_valueCount = other.m_valueCount;
+  m_extractOps.reset(new ExtractOp[m_valueCount]);
+  std::copy(&other.m_extractOps[0], &other.m_extractOps[0] + m_valueCount, &m_extractOps[0]);
+  m_valueItems.reset(new uint32_t[m_valueCount]);
+  std::copy(&other.m_valueItems[0], &other.m_valueItems[0] + m_valueCount, &m_valueItems[0]);
+  m_planIndex = other.m_planIndex;
+}
+
+bool HIDParser::SaveDescriptorCache(const SystemChar* path) {
+  FILE* fp = std::fopen(path, "wb");
+  if (!fp)
+    return false;
+
+  std::vector<std::vector<uint8_t>> descriptors = DescriptorCache::Instance().descriptors();
+  const uint32_t header[] = {CacheMagic, CacheVersion, uint32_t(descriptors.size())};
+  bool good = std::fwrite(header, sizeof(header), 1, fp) == 1;
+  for (const auto& desc : descriptors) {
+    if (!good)
+      break;
+    uint32_t len = uint32_t(desc.size());
+    good = std::fwrite(&len, sizeof(len), 1, fp) == 1 && std::fwrite(desc.data(), 1, len, fp) == len;
+  }
+  return std::fclose(fp) == 0 && good;
+}
+
+bool HIDParser::LoadDescriptorCache(const SystemChar* path) {
+  FILE* fp = std::fopen(path, "rb");
+  if (!fp)
+    return false;
+
+  uint32_t header[3];
+  if (std::fread(header, sizeof(header), 1, fp) != 1 || header[0] != CacheMagic || header[1] != CacheVersion) {
+    std::fclose(fp);
+    return false;
+  }
+
+  bool good = true;
+  std::vector<uint8_t> desc;
+  for (uint32_t i = 0; i < header[2]; ++i) {
+    uint32_t len;
+    if (std::fread(&len, sizeof(len), 1, fp) != 1 || len > MaxCachedDescriptorSize) {
+      good = false;
+      break;
+    }
+    desc.resize(len);
+    if (std::fread(desc.data(), 1, len, fp) != len) {
+      good = false;
+      break;
+    }
+    HIDParser parser;
+    parser.Parse(desc.data(), desc.size());
+  }
+  std::fclose(fp);
+  return good;
+}
+
+void HIDParser::ClearDescriptorCache() { DescriptorCache::Instance().clear(); }
+
+HIDParser::ParserStatus HIDParser::_parseDescriptor(const uint8_t* descriptorData, size_t len) {
+  m_multipleReports = false;
   std::stack<HIDItemState> stateStack;
   stateStack.emplace();
   std::stack<HIDCollectionItem> collectionStack;
@@ -717,35 +881,67 @@ HIDParser::ParserStatus HIDParser::Parse(const uint8_t* descriptorData, size_t l
   func(m_outputReports, reports.m_outputReports);
   func(m_featureReports, reports.m_featureReports);
 
+  _compilePlans();
   return m_status;
 }
 
-size_t HIDParser::CalculateMaxInputReportSize(const uint8_t* descriptorData, size_t len) {
-  std::stack<HIDItemState> stateStack;
-  stateStack.emplace();
-  std::stack<HIDCollectionItem> collectionStack;
-  HIDReports reports;
-  ParserStatus status = ParserStatus::Done;
+void HIDParser::_compilePlans() {
+  m_planIndex.fill(NoPlan);
+  uint32_t reportCount = m_inputReports.second - m_inputReports.first;
+  m_reportPlans.reset(new ReportPlan[reportCount]);
 
-  bool multipleReports = false;
-  const uint8_t* end = descriptorData + len;
-  for (const uint8_t* it = descriptorData; it != end;)
-    if ((status = ParseItem(reports, stateStack, collectionStack, it, end, multipleReports)) != ParserStatus::OK)
-      break;
+  uint32_t valueCount = 0;
+  for (uint32_t i = m_inputReports.first; i < m_inputReports.second; ++i)
+    for (uint32_t j = m_reportPool[i].second.first; j < m_reportPool[i].second.second; ++j)
+      valueCount += !m_itemPool[j].IsConstant();
+  m_extractOps.reset(new ExtractOp[valueCount]);
+  m_valueItems.reset(new uint32_t[valueCount]);
+  m_valueCount = valueCount;
 
-  if (status != ParserStatus::Done)
-    return 0;
+  uint32_t valueIdx = 0;
+  for (uint32_t i = m_inputReports.first; i < m_inputReports.second; ++i) {
+    const Report& rep = m_reportPool[i];
+    ReportPlan& plan = m_reportPlans[i - m_inputReports.first];
+    plan.m_opsBegin = valueIdx;
+    plan.m_valueBase = valueIdx;
+    if (rep.first < m_planIndex.size())
+      m_planIndex[rep.first] = uint16_t(i - m_inputReports.first);
 
-  size_t maxSize = 0;
-  for (const auto& rep : reports.m_inputReports) {
-    size_t repSize = 0;
-    for (const auto& item : rep.second)
-      repSize += item.m_reportSize;
-    if (repSize > maxSize)
-      maxSize = repSize;
+    uint32_t bitPos = m_multipleReports ? 8 : 0;
+    for (uint32_t j = rep.second.first; j < rep.second.second; ++j) {
+      const HIDMainItem& item = m_itemPool[j];
+      uint32_t size = uint32_t(item.m_reportSize);
+      if (!item.IsConstant()) {
+        /* Wider fields are truncated to 32 bits, as ScanValues() does */
+        uint32_t width = std::min(size, 32u);
+        ExtractOp& op = m_extractOps[valueIdx];
+        op.m_byteOffset = bitPos / 8;
+        op.m_shift = uint8_t(bitPos % 8);
+        op.m_mask = width == 32 ? 0xffffffff : (1u << width) - 1;
+        op.m_signShift = (item.m_logicalRange.first < 0 && width && width < 32) ? uint8_t(32 - width) : 0;
+        m_valueItems[valueIdx++] = j;
+      }
+      bitPos += size;
+    }
+
+    plan.m_length = (bitPos + 7) / 8;
+    plan.m_opsEnd = valueIdx;
+    plan.m_wideEnd = plan.m_opsBegin;
+    while (plan.m_wideEnd < plan.m_opsEnd && m_extractOps[plan.m_wideEnd].m_byteOffset + 8 <= plan.m_length)
+      ++plan.m_wideEnd;
   }
+}
 
-  return (maxSize + 7) / 8 + multipleReports;
+size_t HIDParser::CalculateMaxInputReportSize(const uint8_t* descriptorData, size_t len) {
+  /* Goes through the cache, so the pad's own Parse() on open is a hit */
+  HIDParser parser;
+  if (parser.Parse(descriptorData, len) != ParserStatus::Done)
+    return 0;
+
+  size_t maxSize = parser.m_multipleReports;
+  for (uint32_t i = 0; i < parser.m_inputReports.second - parser.m_inputReports.first; ++i)
+    maxSize = std::max(maxSize, size_t(parser.m_reportPlans[i].m_length));
+  return maxSize;
 }
 
 std::pair<HIDUsagePage, HIDUsage> HIDParser::GetApplicationUsage(const uint8_t* descriptorData, size_t len) {
@@ -899,4 +1095,89 @@ void HIDParser::ScanValues(const std::function<bool(const HIDMainItem& item, int
 }
 #endif
 
+#if _WIN32
+/* HidP always passes the report ID byte, 0 when the device declares none */
+bool HIDParser::HasReportIDs() const { return true; }
+
+size_t HIDParser::GetValueCount() const {
+#if !WINDOWS_STORE
+  return m_valueItems.size();
+#else
+  return 0;
+#endif
+}
+
+const HIDMainItem& HIDParser::GetValueItem(size_t idx) const {
+#if !WINDOWS_STORE
+  return m_itemPool[m_valueItems[idx]];
+#else
+  static const HIDMainItem Empty = {};
+  return Empty;
+#endif
+}
+
+HIDParser::ValueRange HIDParser::ExtractValues(const uint8_t* data, size_t len, int32_t* values) const {
+#if !WINDOWS_STORE
+  if (m_status != ParserStatus::Done)
+    return {};
+
+  ULONG dataLen = m_dataList.size();
+  if (HidP_GetData(HidP_Input, m_dataList.data(), &dataLen, m_descriptorData, PCHAR(data), len) != HIDP_STATUS_SUCCESS)
+    return {};
+
+  /* HidP_GetData only reports what the report carries; everything else reads as zero */
+  std::fill(values, values + m_valueItems.size(), 0);
+  for (ULONG i = 0; i < dataLen; ++i)
+    if (m_dataList[i].DataIndex < m_valueItems.size())
+      values[m_dataList[i].DataIndex] = int32_t(m_dataList[i].RawValue);
+  return {0, uint32_t(m_valueItems.size())};
+#else
+  return {};
+#endif
+}
+#else
+bool HIDParser::HasReportIDs() const { return m_multipleReports; }
+
+size_t HIDParser::GetValueCount() const { return m_valueCount; }
+
+const HIDMainItem& HIDParser::GetValueItem(size_t idx) const { return m_itemPool[m_valueItems[idx]]; }
+
+static uint64_t LoadReportWord(const uint8_t* ptr, size_t avail) {
+  uint64_t word = 0;
+  std::memcpy(&word, ptr, std::min(avail, sizeof(word)));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+HIDParser::ValueRange HIDParser::ExtractValues(const uint8_t* data, size_t len, int32_t* values) const {
+  if (m_status != ParserStatus::Done || len == 0)
+    return {};
+
+  uint16_t planIdx = m_planIndex[m_multipleReports ? data[0] : 0];
+  if (planIdx == NoPlan)
+    return {};
+  const ReportPlan& plan = m_reportPlans[planIdx];
+  if (len < plan.m_length)
+    return {};
+
+  int32_t* out = values + plan.m_valueBase;
+  const ExtractOp* op = &m_extractOps[0] + plan.m_opsBegin;
+  const ExtractOp* wideEnd = &m_extractOps[0] + plan.m_wideEnd;
+  const ExtractOp* end = &m_extractOps[0] + plan.m_opsEnd;
+  for (; op != wideEnd; ++op) {
+    uint32_t raw = uint32_t(LoadReportWord(data + op->m_byteOffset, 8) >> op->m_shift) & op->m_mask;
+    *out++ = int32_t(raw << op->m_signShift) >> op->m_signShift;
+  }
+  /* Fields in the last 8 bytes of the report; the load is clamped to the buffer */
+  for (; op != end; ++op) {
+    uint32_t raw =
+        uint32_t(LoadReportWord(data + op->m_byteOffset, len - op->m_byteOffset) >> op->m_shift) & op->m_mask;
+    *out++ = int32_t(raw << op->m_signShift) >> op->m_signShift;
+  }
+  return {plan.m_opsBegin, plan.m_opsEnd};
+}
+#endif
+
 } // namespace boo
@@ -0,0 +1,118 @@
+#include "lib/inputdev/HIDReactorUdev.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <logvisor/logvisor.hpp>
+
+namespace boo {
+static logvisor::Module Log("boo::HIDReactor");
+
+HIDReactor::HIDReactor() {
+  m_epoll = epoll_create1(EPOLL_CLOEXEC);
+  m_wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (m_epoll < 0 || m_wake < 0) {
+    Log.report(logvisor::Error, FMT_STRING("unable to create HID reactor: {}"), strerror(errno));
+    return;
+  }
+
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = 0;
+  epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev);
+  m_thread = std::thread([this]() { _run(); });
+}
+
+HIDReactor::~HIDReactor() {
+  if (m_thread.joinable()) {
+    uint64_t one = 1;
+    write(m_wake, &one, sizeof(one));
+    m_thread.join();
+  }
+  if (m_wake >= 0)
+    close(m_wake);
+  if (m_epoll >= 0)
+    close(m_epoll);
+}
+
+HIDReactor& HIDReactor::Instance() {
+  static HIDReactor reactor;
+  return reactor;
+}
+
+uint64_t HIDReactor::add(int fd, uint32_t events, std::shared_ptr<ISource> source) {
+  if (m_epoll < 0)
+    return 0;
+
+  std::lock_guard<std::mutex> lk(m_lock);
+  uint64_t id = m_nextId++;
+  epoll_event ev = {};
+  ev.events = events;
+  ev.data.u64 = id;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    Log.report(logvisor::Error, FMT_STRING("unable to watch fd {}: {}"), fd, strerror(errno));
+    return 0;
+  }
+  m_sources.emplace(id, std::move(source));
+  return id;
+}
+
+void HIDReactor::remove(uint64_t id, int fd) {
+  std::shared_ptr<ISource> source;
+  {
+    std::lock_guard<std::mutex> lk(m_lock);
+    auto search = m_sources.find(id);
+    if (search == m_sources.end())
+      return;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    source = std::move(search->second);
+    m_sources.erase(search);
+  }
+
+  /* Wait out this source's in-flight callback (if any) and keep it from being dispatched again */
+  {
+    std::lock_guard<std::recursive_mutex> lk(source->m_dispatchLock);
+    source->m_removed = true;
+  }
+  /* Last reference may be dropped here, outside the locks */
+}
+
+void HIDReactor::_run() {
+  logvisor::RegisterThreadName("Boo HID Reactor");
+  epoll_event events[32];
+  while (true) {
+    int count = epoll_wait(m_epoll, events, 32, -1);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      Log.report(logvisor::Error, FMT_STRING("epoll_wait failed: {}"), strerror(errno));
+      return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      if (events[i].data.u64 == 0)
+        return;
+
+      /* A source removed earlier in this batch is simply skipped */
+      std::shared_ptr<ISource> source;
+      {
+        std::lock_guard<std::mutex> lk(m_lock);
+        auto search = m_sources.find(events[i].data.u64);
+        if (search == m_sources.end())
+          continue;
+        source = search->second;
+      }
+
+      /* Dispatched without the registration lock, so one device's callbacks never block another's remove() */
+      std::lock_guard<std::recursive_mutex> lk(source->m_dispatchLock);
+      if (!source->m_removed)
+        source->_reactorReady(events[i].events);
+    }
+  }
+}
+
+} // namespace boo
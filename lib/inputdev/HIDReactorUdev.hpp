@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace boo {
+
+/** Single epoll thread servicing every device opened with HIDIOBackend::Reactor.
+ *  The thread blocks in epoll_wait() without a timeout; an eventfd wakes it only for
+ *  shutdown, so idle devices cause no wakeups at all. hidraw nodes signal EPOLLIN for
+ *  pending reports and usbfs nodes signal EPOLLOUT once a submitted URB can be reaped. */
+class HIDReactor {
+public:
+  class ISource {
+    friend class HIDReactor;
+    /* Held while this source is dispatched, so remove() waits out only its own callback;
+     * recursive since a source may be removed from its own callback */
+    std::recursive_mutex m_dispatchLock;
+    bool m_removed = false;
+
+  public:
+    virtual ~ISource() = default;
+    /** Reactor thread: fd is ready with the given epoll events */
+    virtual void _reactorReady(uint32_t events) = 0;
+  };
+
+private:
+  int m_epoll = -1;
+  int m_wake = -1;
+  std::thread m_thread;
+
+  /* Guards the registrations only; never held while a source is dispatched */
+  std::mutex m_lock;
+  std::unordered_map<uint64_t, std::shared_ptr<ISource>> m_sources;
+  uint64_t m_nextId = 1;
+
+  HIDReactor();
+  void _run();
+
+public:
+  ~HIDReactor();
+  HIDReactor(const HIDReactor&) = delete;
+  HIDReactor& operator=(const HIDReactor&) = delete;
+
+  /** Process-wide instance, started on first use */
+  static HIDReactor& Instance();
+
+  /** Watch fd for events (level-triggered); returns a registration id, or 0 on failure */
+  uint64_t add(int fd, uint32_t events, std::shared_ptr<ISource> source);
+
+  /** Stop watching; once this returns the source's callback is not running and will not run again */
+  void remove(uint64_t id, int fd);
+};
+
+} // namespace boo
@@ -0,0 +1,384 @@
+#include "lib/inputdev/HIDRecording.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "boo/inputdev/DeviceToken.hpp"
+#include "boo/inputdev/HIDReplay.hpp"
+#include "lib/inputdev/IHIDDevice.hpp"
+
+#include <logvisor/logvisor.hpp>
+
+namespace boo {
+static logvisor::Module Log("boo::HIDReplay");
+
+namespace {
+void PutLE(std::vector<uint8_t>& buf, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i)
+    buf.push_back(uint8_t(value >> (8 * i)));
+}
+
+void PutVarint(std::vector<uint8_t>& buf, uint64_t value) {
+  while (value >= 0x80) {
+    buf.push_back(uint8_t(value) | 0x80);
+    value >>= 7;
+  }
+  buf.push_back(uint8_t(value));
+}
+
+class Reader {
+  const uint8_t* m_it;
+  const uint8_t* m_end;
+  bool m_good = true;
+
+public:
+  Reader(const uint8_t* data, size_t len) : m_it(data), m_end(data + len) {}
+  bool good() const { return m_good; }
+  bool atEnd() const { return m_it == m_end; }
+  const uint8_t* position() const { return m_it; }
+
+  uint64_t getLE(size_t bytes) {
+    if (size_t(m_end - m_it) < bytes) {
+      m_good = false;
+      return 0;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+      value |= uint64_t(*m_it++) << (8 * i);
+    return value;
+  }
+
+  uint64_t getVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (m_it == m_end) {
+        m_good = false;
+        return 0;
+      }
+      uint8_t byte = *m_it++;
+      value |= uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    m_good = false;
+    return 0;
+  }
+
+  const uint8_t* skip(size_t bytes) {
+    if (size_t(m_end - m_it) < bytes) {
+      m_good = false;
+      return nullptr;
+    }
+    const uint8_t* ret = m_it;
+    m_it += bytes;
+    return ret;
+  }
+};
+} // Anonymous namespace
+
+HIDRecorder::HIDRecorder(FILE* fp) : m_fp(fp), m_lastTime(std::chrono::steady_clock::now()), m_lastFlush(m_lastTime) {}
+
+HIDRecorder::~HIDRecorder() { std::fclose(m_fp); }
+
+std::unique_ptr<HIDRecorder> HIDRecorder::Create(const SystemChar* path, DeviceType type, unsigned vid, unsigned pid,
+                                                 std::string_view productName,
+                                                 const std::vector<uint8_t>& descriptor) {
+#if _WIN32
+  FILE* fp = _wfopen(path, L"wb");
+#else
+  FILE* fp = std::fopen(path, "wb");
+#endif
+  if (!fp) {
+    Log.report(logvisor::Error, FMT_STRING("unable to open recording for writing: {}"), strerror(errno));
+    return {};
+  }
+
+  std::vector<uint8_t> header;
+  productName = productName.substr(0, UINT16_MAX);
+  PutLE(header, HIDRecordingMagic, 4);
+  PutLE(header, HIDRecordingVersion, 2);
+  PutLE(header, uint8_t(type), 1);
+  PutLE(header, 0, 1);
+  PutLE(header, vid, 2);
+  PutLE(header, pid, 2);
+  PutLE(header, productName.size(), 2);
+  header.insert(header.end(), productName.begin(), productName.end());
+  PutLE(header, descriptor.size(), 4);
+  header.insert(header.end(), descriptor.begin(), descriptor.end());
+  if (std::fwrite(header.data(), 1, header.size(), fp) != header.size()) {
+    std::fclose(fp);
+    return {};
+  }
+  return std::unique_ptr<HIDRecorder>(new HIDRecorder(fp));
+}
+
+void HIDRecorder::record(HIDRecordKind kind, uint32_t message, const uint8_t* data, size_t length) {
+  auto now = std::chrono::steady_clock::now();
+  auto delta = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastTime);
+  /* Carry the sub-microsecond remainder so long recordings do not drift */
+  m_lastTime += delta;
+
+  m_buf.clear();
+  m_buf.push_back(uint8_t(kind));
+  PutVarint(m_buf, uint64_t(delta.count()));
+  PutVarint(m_buf, message);
+  PutVarint(m_buf, length);
+  m_buf.insert(m_buf.end(), data, data + length);
+  std::fwrite(m_buf.data(), 1, m_buf.size(), m_fp);
+
+  if (++m_unflushed >= FlushRecords || now - m_lastFlush >= FlushInterval) {
+    std::fflush(m_fp);
+    m_unflushed = 0;
+    m_lastFlush = now;
+  }
+}
+
+struct HIDReplay::Recording : IHIDDeviceSource, std::enable_shared_from_this<HIDReplay::Recording> {
+  struct Record {
+    std::chrono::microseconds m_time; /* From the start of the recording */
+    HIDRecordKind m_kind;
+    uint32_t m_message;
+    size_t m_offset;
+    size_t m_length;
+  };
+
+  HIDReplayMode m_mode = HIDReplayMode::RealTime;
+  DeviceType m_type = DeviceType::None;
+  unsigned m_vid = 0;
+  unsigned m_pid = 0;
+  std::string m_productName;
+  std::vector<uint8_t> m_descriptor;
+  std::vector<uint8_t> m_data;
+  std::vector<Record> m_records;
+
+  /* Playback state shared with the replay device */
+  mutable std::mutex m_lock;
+  mutable std::condition_variable m_cv;
+  bool m_started = false;
+  bool m_finished = false;
+
+  bool load(const uint8_t* data, size_t len);
+  std::shared_ptr<IHIDDevice> newHIDDevice(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp) override;
+};
+
+bool HIDReplay::Recording::load(const uint8_t* data, size_t len) {
+  Reader r(data, len);
+  if (r.getLE(4) != HIDRecordingMagic || r.getLE(2) != HIDRecordingVersion)
+    return false;
+  m_type = DeviceType(r.getLE(1));
+  r.getLE(1);
+  m_vid = unsigned(r.getLE(2));
+  m_pid = unsigned(r.getLE(2));
+  size_t nameLen = r.getLE(2);
+  if (const uint8_t* name = r.skip(nameLen))
+    m_productName.assign(reinterpret_cast<const char*>(name), nameLen);
+  size_t descLen = r.getLE(4);
+  if (const uint8_t* desc = r.skip(descLen))
+    m_descriptor.assign(desc, desc + descLen);
+  if (!r.good())
+    return false;
+
+  /* Payloads are kept in one contiguous store so playback does no allocation */
+  std::chrono::microseconds time{};
+  while (!r.atEnd()) {
+    auto kind = HIDRecordKind(r.getLE(1));
+    time += std::chrono::microseconds(r.getVarint());
+    uint32_t message = uint32_t(r.getVarint());
+    size_t length = r.getVarint();
+    const uint8_t* payload = r.skip(length);
+    if (!r.good()) {
+      /* A recording cut short by a crash ends mid-record; keep everything before it */
+      Log.report(logvisor::Warning, FMT_STRING("HID recording truncated after {} records"), m_records.size());
+      break;
+    }
+    if (kind > HIDRecordKind::USBTransfer)
+      return false;
+    m_records.push_back({time, kind, message, m_data.size(), length});
+    m_data.insert(m_data.end(), payload, payload + length);
+  }
+  return true;
+}
+
+/* Feeds a recording to the pad it was opened for */
+class HIDDeviceReplay final : public IHIDDevice {
+  std::shared_ptr<DeviceBase> m_devImp;
+  std::shared_ptr<HIDReplay::Recording> m_recording;
+  std::thread m_thread;
+  std::atomic_bool m_runningTransferLoop = false;
+  const uint8_t* m_pendingTransfer = nullptr;
+  size_t m_pendingLength = 0;
+
+  static void _threadProc(std::shared_ptr<HIDDeviceReplay> device) {
+    logvisor::RegisterThreadName("Boo HID Replay");
+    HIDReplay::Recording& rec = *device->m_recording;
+    {
+      std::unique_lock<std::mutex> lk(rec.m_lock);
+      rec.m_cv.wait(lk, [&]() { return rec.m_started || !device->m_runningTransferLoop; });
+      if (!device->m_runningTransferLoop) {
+        /* Closed before start() */
+        rec.m_finished = true;
+        rec.m_cv.notify_all();
+        return;
+      }
+    }
+
+    DeviceBase& devImp = *device->m_devImp;
+    devImp.initialCycle();
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& record : rec.m_records) {
+      if (rec.m_mode == HIDReplayMode::RealTime) {
+        /* Waiting on the condition lets close() interrupt long gaps */
+        std::unique_lock<std::mutex> lk(rec.m_lock);
+        rec.m_cv.wait_until(lk, start + record.m_time, [&]() { return !device->m_runningTransferLoop; });
+      }
+      if (!device->m_runningTransferLoop)
+        break;
+      const uint8_t* payload = rec.m_data.data() + record.m_offset;
+      if (record.m_kind == HIDRecordKind::InputReport) {
+        devImp._receivedHIDReport(payload, record.m_length, HIDReportType::Input, record.m_message,
+                                  std::chrono::steady_clock::now());
+      } else {
+        /* Pull-model pads read the transfer back inside transferCycle() */
+        device->m_pendingTransfer = payload;
+        device->m_pendingLength = record.m_length;
+        devImp.transferCycle();
+        device->m_pendingTransfer = nullptr;
+      }
+    }
+    devImp.finalCycle();
+
+    std::lock_guard<std::mutex> lk(rec.m_lock);
+    rec.m_finished = true;
+    rec.m_cv.notify_all();
+  }
+
+  void _deviceDisconnected() override {
+    std::lock_guard<std::mutex> lk(m_recording->m_lock);
+    m_runningTransferLoop = false;
+    m_recording->m_cv.notify_all();
+  }
+
+  bool _sendUSBInterruptTransfer(const uint8_t* data, size_t length) override { return true; }
+
+  size_t _receiveUSBInterruptTransfer(uint8_t* data, size_t length) override {
+    if (!m_pendingTransfer)
+      return 0;
+    size_t len = std::min(length, m_pendingLength);
+    std::memcpy(data, m_pendingTransfer, len);
+    m_pendingTransfer = nullptr;
+    return len;
+  }
+
+#if _WIN32
+#if !WINDOWS_STORE
+  const PHIDP_PREPARSED_DATA _getReportDescriptor() override { return {}; }
+#endif
+#else
+  std::vector<uint8_t> _getReportDescriptor() override { return m_recording->m_descriptor; }
+#endif
+
+  bool _sendHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override { return true; }
+  size_t _receiveHIDReport(uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override { return 0; }
+
+public:
+  HIDDeviceReplay(const std::shared_ptr<DeviceBase>& devImp, std::shared_ptr<HIDReplay::Recording> recording)
+  : m_devImp(devImp), m_recording(std::move(recording)) {}
+
+  void _startThread() override {
+    m_runningTransferLoop = true;
+    m_thread = std::thread(_threadProc, std::static_pointer_cast<HIDDeviceReplay>(shared_from_this()));
+  }
+
+  ~HIDDeviceReplay() override {
+    m_runningTransferLoop = false;
+    if (m_thread.joinable())
+      m_thread.detach();
+  }
+};
+
+std::shared_ptr<IHIDDevice> HIDReplay::Recording::newHIDDevice(DeviceToken& token,
+                                                               const std::shared_ptr<DeviceBase>& devImp) {
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_started = false;
+  m_finished = false;
+  return std::make_shared<HIDDeviceReplay>(devImp, shared_from_this());
+}
+
+HIDReplay::HIDReplay() = default;
+
+HIDReplay::~HIDReplay() { close(); }
+
+bool HIDReplay::open(const SystemChar* path, HIDReplayMode mode) {
+  close();
+#if _WIN32
+  FILE* fp = _wfopen(path, L"rb");
+#else
+  FILE* fp = std::fopen(path, "rb");
+#endif
+  if (!fp) {
+    Log.report(logvisor::Error, FMT_STRING("unable to open recording: {}"), strerror(errno));
+    return false;
+  }
+  std::vector<uint8_t> file;
+  uint8_t buf[65536];
+  size_t rdBytes;
+  while ((rdBytes = std::fread(buf, 1, sizeof(buf), fp)))
+    file.insert(file.end(), buf, buf + rdBytes);
+  std::fclose(fp);
+
+  auto recording = std::make_shared<Recording>();
+  if (!recording->load(file.data(), file.size())) {
+    Log.report(logvisor::Error, FMT_STRING("invalid HID recording"));
+    return false;
+  }
+  recording->m_mode = mode;
+
+  m_token = std::make_unique<DeviceToken>(recording->m_type, recording->m_vid, recording->m_pid, "",
+                                          recording->m_productName.c_str(), "replay");
+  m_token->m_hidSource = recording;
+  m_recording = std::move(recording);
+  return true;
+}
+
+void HIDReplay::close() {
+  if (m_token)
+    m_token->_deviceClose();
+  m_token.reset();
+  m_recording.reset();
+}
+
+void HIDReplay::start() {
+  if (!m_recording)
+    return;
+  std::lock_guard<std::mutex> lk(m_recording->m_lock);
+  m_recording->m_started = true;
+  m_recording->m_cv.notify_all();
+}
+
+size_t HIDReplay::getRecordCount() const { return m_recording ? m_recording->m_records.size() : 0; }
+
+std::chrono::microseconds HIDReplay::getDuration() const {
+  if (!m_recording || m_recording->m_records.empty())
+    return {};
+  return m_recording->m_records.back().m_time;
+}
+
+void HIDReplay::waitFinished() const {
+  if (!m_recording || !m_token || !m_token->isDeviceOpen())
+    return;
+  std::unique_lock<std::mutex> lk(m_recording->m_lock);
+  m_recording->m_cv.wait(lk, [&]() { return m_recording->m_finished; });
+}
+
+bool HIDReplay::waitFinished(std::chrono::milliseconds timeout) const {
+  if (!m_recording || !m_token || !m_token->isDeviceOpen())
+    return false;
+  std::unique_lock<std::mutex> lk(m_recording->m_lock);
+  return m_recording->m_cv.wait_for(lk, timeout, [&]() { return m_recording->m_finished; });
+}
+
+} // namespace boo
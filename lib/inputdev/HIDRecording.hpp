@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "boo/System.hpp"
+#include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/DeviceSignature.hpp"
+
+namespace boo {
+
+/* Recording file layout; multi-byte fixed fields are little-endian:
+ *   header:  'BHIR' magic (u32), version (u16), device type (u8), reserved (u8), VID (u16), PID (u16),
+ *            product name length (u16) and bytes, report descriptor length (u32) and bytes
+ *   records: kind (u8), then LEB128 varints for microseconds since the previous record,
+ *            report message/ID and payload length, then the payload */
+constexpr uint32_t HIDRecordingMagic = 0x52494842; /* BHIR */
+constexpr uint16_t HIDRecordingVersion = 1;
+
+enum class HIDRecordKind : uint8_t {
+  InputReport, /* Delivered through DeviceBase::receivedHIDReport() */
+  USBTransfer  /* Returned from DeviceBase::receiveUSBInterruptTransfer() */
+};
+
+/* Writes one device's traffic; owned by the DeviceBase being recorded.
+ * Flushed at a bounded interval so a crash loses at most the last few records. */
+class HIDRecorder {
+  static constexpr unsigned FlushRecords = 64;
+  static constexpr std::chrono::milliseconds FlushInterval{100};
+
+  FILE* m_fp;
+  std::chrono::steady_clock::time_point m_lastTime;
+  std::chrono::steady_clock::time_point m_lastFlush;
+  unsigned m_unflushed = 0;
+  std::vector<uint8_t> m_buf;
+
+  explicit HIDRecorder(FILE* fp);
+
+public:
+  ~HIDRecorder();
+  HIDRecorder(const HIDRecorder&) = delete;
+  HIDRecorder& operator=(const HIDRecorder&) = delete;
+
+  static std::unique_ptr<HIDRecorder> Create(const SystemChar* path, DeviceType type, unsigned vid, unsigned pid,
+                                             std::string_view productName, const std::vector<uint8_t>& descriptor);
+  void record(HIDRecordKind kind, uint32_t message, const uint8_t* data, size_t length);
+};
+
+} // namespace boo
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include "boo/inputdev/DeviceBase.hpp"
@@ -17,6 +18,9 @@ class IHIDDevice : public std::enable_shared_from_this<IHIDDevice> {
   virtual void _deviceDisconnected() = 0;
   virtual bool _sendUSBInterruptTransfer(const uint8_t* data, size_t length) = 0;
   virtual size_t _receiveUSBInterruptTransfer(uint8_t* data, size_t length) = 0;
+  /* When the data last returned by _receiveUSBInterruptTransfer() was read from the device;
+   * backends that read ahead of the call override this */
+  virtual std::chrono::steady_clock::time_point _receiveTime() { return std::chrono::steady_clock::now(); }
 #if _WIN32
 #if !WINDOWS_STORE
   virtual const PHIDP_PREPARSED_DATA _getReportDescriptor() = 0;
@@ -32,4 +36,12 @@ public:
   virtual ~IHIDDevice() = default;
 };
 
+/* Supplies the IHIDDevice for tokens that no platform listener produced (e.g. replays);
+ * DeviceSignature::DeviceNew() uses it in place of IHIDDeviceNew() */
+class IHIDDeviceSource {
+public:
+  virtual ~IHIDDeviceSource() = default;
+  virtual std::shared_ptr<IHIDDevice> newHIDDevice(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp) = 0;
+};
+
 } // namespace boo
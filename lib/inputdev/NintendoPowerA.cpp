@@ -29,12 +29,15 @@ void NintendoPowerA::transferCycle() {
 
   NintendoPowerAState state;
   std::memcpy(&state, payload.data(), sizeof(state));
+  _reportDecoded();
+  m_snapshot.publish(state, getReportArrival());
 
   std::lock_guard lk{m_callbackLock};
   if (state != m_last && m_callback != nullptr) {
     m_callback->controllerUpdate(state);
   }
   m_last = state;
+  _reportDelivered();
 }
 
 void NintendoPowerA::finalCycle() {}
@@ -1,6 +1,7 @@
 /* SoX Resampler Library      Copyright (c) 2007-13 robs@users.sourceforge.net
  * Licence for this file: LGPL v2.1                  See LICENCE for details. */
 
+#include "soxr-config.h"
 #include "filter.h"
 #include "simd.h"
 
@@ -24,3 +25,20 @@ fn_t _soxr_rdft32s_cb[] = {
   (fn_t)multiplier,
   (fn_t)nothing,
 };
+
+#if HAVE_AVX
+/* Same transforms; only the frequency-domain multiply is widened. */
+fn_t _soxr_rdft32avx_cb[] = {
+  (fn_t)null,
+  (fn_t)null,
+  (fn_t)nothing,
+  (fn_t)forward,
+  (fn_t)forward,
+  (fn_t)backward,
+  (fn_t)backward,
+  (fn_t)_soxr_ordered_convolve_avx,
+  (fn_t)_soxr_ordered_partial_convolve_avx,
+  (fn_t)multiplier,
+  (fn_t)nothing,
+};
+#endif
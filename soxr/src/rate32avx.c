@@ -0,0 +1,12 @@
+/* SoX Resampler Library      Copyright (c) 2007-13 robs@users.sourceforge.net
+ * Licence for this file: LGPL v2.1                  See LICENCE for details. */
+
+/* rate32s.c rebuilt with AVX2/FMA code generation for the poly-phase and
+ * half-band FIR stages; selected at run time by soxr.c. */
+
+#define sample_t   float
+#define RATE_SIMD  1
+#define RDFT_CB    _soxr_rdft32avx_cb
+#define RATE_CB    _soxr_rate32avx_cb
+#define RATE_ID    "single-precision-AVX2"
+#include "rate.h"
@@ -0,0 +1,63 @@
+/* SoX Resampler Library      Copyright (c) 2007-13 robs@users.sourceforge.net
+ * Licence for this file: LGPL v2.1                  See LICENCE for details. */
+
+/* AVX2/FMA frequency-domain multiply for the fft4g SIMD path.  This file is
+ * built with AVX2/FMA code generation; callers must check _soxr_cpu_has_avx2()
+ * (see fft4g32s.c) so that baseline x86-64 never executes it. */
+
+#include <assert.h>
+#include <immintrin.h>
+#include "simd.h"
+
+/* Complex multiply of interleaved (re, im) pairs: */
+static __m256 cplx_mul8(__m256 a, __m256 b)
+{
+  __m256 br = _mm256_moveldup_ps(b), bi = _mm256_movehdup_ps(b);
+  __m256 a_swapped = _mm256_permute_ps(a, _MM_SHUFFLE(2,3,0,1));
+  return _mm256_fmaddsub_ps(a, br, _mm256_mul_ps(a_swapped, bi));
+}
+
+static __m128 cplx_mul4(__m128 a, __m128 b)
+{
+  __m128 br = _mm_moveldup_ps(b), bi = _mm_movehdup_ps(b);
+  __m128 a_swapped = _mm_permute_ps(a, _MM_SHUFFLE(2,3,0,1));
+  return _mm_fmaddsub_ps(a, br, _mm_mul_ps(a_swapped, bi));
+}
+
+static void cplx_mul_n(int n, float * a, const float * b)
+{
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 a0 = _mm256_loadu_ps(a + i), a1 = _mm256_loadu_ps(a + i + 8);
+    _mm256_storeu_ps(a + i, cplx_mul8(a0, _mm256_loadu_ps(b + i)));
+    _mm256_storeu_ps(a + i + 8, cplx_mul8(a1, _mm256_loadu_ps(b + i + 8)));
+  }
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(a + i, cplx_mul8(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+  for (; i < n; i += 4)
+    _mm_storeu_ps(a + i, cplx_mul4(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+}
+
+
+
+void _soxr_ordered_convolve_avx(int n, void * not_used, float * a, const float * b)
+{
+  float ab0, ab1;
+  assert(!(n & 3));
+  ab0 = a[0] * b[0], ab1 = a[1] * b[1];
+  cplx_mul_n(n, a, b);
+  a[0] = ab0, a[1] = ab1;
+  (void)not_used;
+}
+
+
+
+void _soxr_ordered_partial_convolve_avx(int n, float * a, const float * b)
+{
+  float ab0;
+  assert(!(n & 3));
+  ab0 = a[0] * b[0];
+  cplx_mul_n(n, a, b);
+  a[0] = ab0;
+  a[1] = b[n] * a[n] - b[n+1] * a[n+1];
+}
@@ -6,9 +6,60 @@
 #include <stdlib.h>
 #include "simd.h"
 #include "simd-dev.h"
+#if defined _MSC_VER && (defined _M_X64 || defined _M_IX86)
+#include <intrin.h>
+#elif defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#include <cpuid.h>
+#endif
 
 #define SIMD_ALIGNMENT (sizeof(float) * 4)
 
+
+
+/* AVX2 and FMA must both be reported by CPUID, and the OS must have enabled
+ * saving of the YMM state (XCR0 bits 1 and 2), before the 256-bit paths are
+ * safe to enter.  Probed once; the result does not change for the process. */
+static int cpu_probe_avx2(void)
+{
+#if defined _MSC_VER && (defined _M_X64 || defined _M_IX86)
+  int r[4];
+  __cpuid(r, 0);
+  if (r[0] < 7)
+    return 0;
+  __cpuid(r, 1);
+  if ((r[2] & 0x18001000) != 0x18001000) /* FMA, OSXSAVE, AVX */
+    return 0;
+  if ((_xgetbv(0) & 6) != 6)
+    return 0;
+  __cpuidex(r, 7, 0);
+  return !!(r[1] & 0x20);
+#elif defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+  unsigned eax, ebx, ecx, edx, xcr0;
+  if (__get_cpuid_max(0, 0) < 7)
+    return 0;
+  __cpuid(1, eax, ebx, ecx, edx);
+  if ((ecx & 0x18001000) != 0x18001000) /* FMA, OSXSAVE, AVX */
+    return 0;
+  __asm__ ("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+  if ((xcr0 & 6) != 6)
+    return 0;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return !!(ebx & 0x20);
+#else
+  return 0;
+#endif
+}
+
+
+
+int _soxr_cpu_has_avx2(void)
+{
+  static int result = -1;
+  if (result < 0)
+    result = cpu_probe_avx2();
+  return result;
+}
+
 void * _soxr_simd_aligned_malloc(size_t size)
 {
   char * p1 = 0, * p = malloc(size + SIMD_ALIGNMENT);
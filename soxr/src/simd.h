@@ -13,4 +13,9 @@ void _soxr_simd_aligned_free(void *);
 void _soxr_ordered_convolve_simd(int n, void * not_used, float * a, const float * b);
 void _soxr_ordered_partial_convolve_simd(int n, float * a, const float * b);
 
+/* AVX2/FMA variants (simd-avx.c); only valid when _soxr_cpu_has_avx2(). */
+int _soxr_cpu_has_avx2(void);
+void _soxr_ordered_convolve_avx(int n, void * not_used, float * a, const float * b);
+void _soxr_ordered_partial_convolve_avx(int n, float * a, const float * b);
+
 #endif
@@ -196,6 +196,15 @@ static bool cpu_has_simd(void)
 #endif
 
 extern control_block_t _soxr_rate32s_cb, _soxr_rate32_cb, _soxr_rate64_cb, _soxr_vr32_cb;
+#if HAVE_AVX
+extern control_block_t _soxr_rate32avx_cb, _soxr_vr32avx_cb;
+int _soxr_cpu_has_avx2(void);
+#define cpu_has_avx2 _soxr_cpu_has_avx2
+#else
+#define cpu_has_avx2() false
+#define _soxr_rate32avx_cb _soxr_rate32s_cb
+#define _soxr_vr32avx_cb _soxr_vr32_cb
+#endif
 
 
 
@@ -246,8 +255,9 @@ soxr_t soxr_create(
       p->deinterleave = (deinterleave_t)_soxr_deinterleave_f;
       p->interleave = (interleave_t)_soxr_interleave_f;
       memcpy(&p->control_block,
-          (p->q_spec.flags & SOXR_VR)? &_soxr_vr32_cb :
+          (p->q_spec.flags & SOXR_VR)? (cpu_has_avx2()? &_soxr_vr32avx_cb : &_soxr_vr32_cb) :
 #if HAVE_SIMD
+          cpu_has_avx2()? &_soxr_rate32avx_cb :
           cpu_has_simd()? &_soxr_rate32s_cb :
 #endif
           &_soxr_rate32_cb, sizeof(p->control_block));
@@ -0,0 +1,10 @@
+/* SoX Resampler Library      Copyright (c) 2007-13 robs@users.sourceforge.net
+ * Licence for this file: LGPL v2.1                  See LICENCE for details. */
+
+/* vr32s.c rebuilt with 256-bit FMA poly-phase kernels; selected at run time
+ * by soxr.c. */
+
+#define VR_AVX   1
+#define VR_CB    _soxr_vr32avx_cb
+#define VR_ID    "single-precision variable-rate AVX2"
+#include "vr32s.c"
@@ -13,7 +13,9 @@
 #endif
 #include <string.h>
 #include <stdlib.h>
-#if defined(__x86_64__) || defined(_M_X64)
+#if defined VR_AVX
+#include <immintrin.h>
+#elif defined(__x86_64__) || defined(_M_X64)
 #include <xmmintrin.h>
 #elif defined(__ARM_NEON)
 #include "sse2neon.h"
@@ -24,6 +26,11 @@
 #include "fifo.h"
 #include "vr-coefs.h"
 
+#if !defined VR_CB
+#define VR_CB    _soxr_vr32_cb
+#define VR_ID    "single-precision variable-rate"
+#endif
+
 #define FADE_LEN_BITS     9
 #define PHASE_BITS_D      10
 #define PHASE_BITS_U      9
@@ -170,6 +177,30 @@ static void prepare_coefs(__m128 * coefs_a, __m128 * coefs_b,
 static __m128 poly_fir_coefs_d_a[POLY_FIR_LEN_D_VEC * PHASES_D];
 static __m128 poly_fir_coefs_d_b[POLY_FIR_LEN_D_VEC * PHASES_D];
 
+#if defined VR_AVX
+/* A phase's coefficient vectors are contiguous, so taps 0-15 are taken as two
+ * 256-bit FMA steps and the remaining 4 as one 128-bit step. */
+#define _8(j) sum8 = _mm256_fmadd_ps(_mm256_fmadd_ps(_mm256_loadu_ps(pb + j), x8, _mm256_loadu_ps(pa + j)), _mm256_loadu_ps(input + j), sum8);
+#define _4(j) sum = _mm_fmadd_ps(_mm_fmadd_ps(_mm_loadu_ps(pb + j), x, _mm_loadu_ps(pa + j)), _mm_loadu_ps(input + j), sum);
+
+static float hsum8(__m256 sum8, __m128 sum)
+{
+  sum = _mm_add_ps(sum, _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1)));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  return _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehdup_ps(sum)));
+}
+
+static float poly_fir1_d(float const * input, uint32_t frac)
+{
+  int i = 0, phase = (int)(frac >> (32 - PHASE_BITS_D));
+  float xf = (float)(frac << PHASE_BITS_D) * (float)(1 / MULT32);
+  float const * pa = (float const *)&a, * pb = (float const *)&b;
+  __m256 sum8 = _mm256_setzero_ps(), x8 = _mm256_set1_ps(xf);
+  __m128 sum = _mm_setzero_ps(), x = _mm_set1_ps(xf);
+  _8(0) _8(8) _4(16)
+  return hsum8(sum8, sum);
+}
+#else
 static float poly_fir1_d(float const * input, uint32_t frac)
 {
   int i = 0, phase = (int)(frac >> (32 - PHASE_BITS_D));
@@ -178,6 +209,7 @@ static float poly_fir1_d(float const * input, uint32_t frac)
   assert(i == POLY_FIR_LEN_D_VEC);
   return ((float*)&sum)[0] + ((float*)&sum)[1] + ((float*)&sum)[2] + ((float*)&sum)[3];
 }
+#endif
 #undef a
 #undef b
 #define a (coefs(poly_fir_coefs_u_a, POLY_FIR_LEN_U_VEC, phase, i))
@@ -185,6 +217,20 @@ static float poly_fir1_d(float const * input, uint32_t frac)
 static __m128 poly_fir_coefs_u_a[POLY_FIR_LEN_U_VEC * PHASES_U];
 static __m128 poly_fir_coefs_u_b[POLY_FIR_LEN_U_VEC * PHASES_U];
 
+#if defined VR_AVX
+static float poly_fir1_u(float const * input, uint32_t frac)
+{
+  int i = 0, phase = (int)(frac >> (32 - PHASE_BITS_U));
+  float xf = (float)(frac << PHASE_BITS_U) * (float)(1 / MULT32);
+  float const * pa = (float const *)&a, * pb = (float const *)&b;
+  __m256 sum8 = _mm256_setzero_ps(), x8 = _mm256_set1_ps(xf);
+  __m128 sum = _mm_setzero_ps(), x = _mm_set1_ps(xf);
+  _8(0) _4(8)
+  return hsum8(sum8, sum);
+}
+#undef _8
+#undef _4
+#else
 static float poly_fir1_u(float const * input, uint32_t frac)
 {
   int i = 0, phase = (int)(frac >> (32 - PHASE_BITS_U));
@@ -193,6 +239,7 @@ static float poly_fir1_u(float const * input, uint32_t frac)
   assert(i == POLY_FIR_LEN_U_VEC);
   return ((float*)&sum)[0] + ((float*)&sum)[1] + ((float*)&sum)[2] + ((float*)&sum)[3];
 }
+#endif
 #undef a
 #undef b
 #undef _
@@ -647,11 +694,11 @@ static char const * vr_create(void * channel, void * shared,double max_io_ratio,
 
 static char const * vr_id(void)
 {
-  return "single-precision variable-rate";
+  return VR_ID;
 }
 
 typedef void (* fn_t)(void);
-fn_t _soxr_vr32_cb[] = {
+fn_t VR_CB[] = {
   (fn_t)vr_input,
   (fn_t)vr_process,
   (fn_t)vr_output,